@@ -0,0 +1,62 @@
+#include "capability_profile.h"
+#include "cn105.h"
+#include "Globals.h"
+
+using namespace esphome;
+
+void capabilityProfile::reset() {
+    *this = capabilityProfile{};
+    version = CAPABILITY_PROFILE_VERSION;
+}
+
+bool capabilityProfile::isValid() {
+    return version == CAPABILITY_PROFILE_VERSION;
+}
+
+bool capabilityProfile::isRequestUnsupported(int requestType) {
+    return (unsupportedRequests & (1 << requestType)) != 0;
+}
+
+bool capabilityProfile::isRequestAnswered(int requestType) {
+    return (answeredRequests & (1 << requestType)) != 0;
+}
+
+bool capabilityProfile::learnRequestAnswered(int requestType) {
+    if (isRequestAnswered(requestType) && !isRequestUnsupported(requestType) && missedSessions[requestType] == 0) {
+        return false;
+    }
+    answeredRequests |= (1 << requestType);
+    unsupportedRequests &= ~(1 << requestType);
+    missedSessions[requestType] = 0;
+    return true;
+}
+
+/**
+ * Lost replies over a noisy period must not disable a request for good: a request the unit has
+ * already answered is kept, and the others only after CAPABILITY_MISSED_SESSIONS boots without answer.
+*/
+bool capabilityProfile::learnRequestMissed(int requestType) {
+    if (isRequestAnswered(requestType) || isRequestUnsupported(requestType)) {
+        return false;
+    }
+    if (missedSessions[requestType] < CAPABILITY_MISSED_SESSIONS) {
+        missedSessions[requestType]++;
+    }
+    if (missedSessions[requestType] >= CAPABILITY_MISSED_SESSIONS) {
+        unsupportedRequests |= (1 << requestType);
+    }
+    return true;
+}
+
+bool capabilityProfile::learnFlag(bool& flag, bool value) {
+    if (flag == value) {
+        return false;
+    }
+    flag = value;
+    return true;
+}
+
+void capabilityProfile::log() {
+    ESP_LOGI(TAG, "capabilities: unsupported requests 0x%02X, answered 0x%02X, tempMode: %d",
+        unsupportedRequests, answeredRequests, tempMode);
+}
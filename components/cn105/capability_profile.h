@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// bump it whenever the layout of capabilityProfile changes: older records are then ignored
+static const uint8_t CAPABILITY_PROFILE_VERSION = 3;
+
+// boots during which an optional request was given up before the unit is deemed not to support it
+static const uint8_t CAPABILITY_MISSED_SESSIONS = 3;
+static const int CAPABILITY_REQUEST_SLOTS = 8;          // RQST_PKT_* are bit indexes of a uint8_t
+
+/**
+ * What the unit has shown it supports, learned at runtime and persisted in flash, so that after a
+ * reboot the probes are not repeated and a power request (0x09) the unit never answers is no longer
+ * sent. The CN105 protocol has nothing that identifies the unit (the connect reply is the same for
+ * all of them): after swapping the unit, the profile is reset by resetCapabilities().
+ * It is saved as raw bytes in the ESPHome preferences: keep it trivially copyable.
+*/
+struct capabilityProfile {
+
+    uint8_t version = 0;
+    uint8_t unsupportedRequests = 0;        // bitmask of RQST_PKT_* the unit never answers
+    uint8_t answeredRequests = 0;           // bitmask of RQST_PKT_* the unit has answered at least once
+    uint8_t missedSessions[CAPABILITY_REQUEST_SLOTS] = {};     // per RQST_PKT_*, boots it was given up
+    bool tempMode = false;                  // setpoint with 0.5° resolution (data[11] of 0x02)
+
+    void reset();
+    bool isValid();
+    bool isRequestUnsupported(int requestType);
+    bool isRequestAnswered(int requestType);
+
+    // each learn method returns true when the profile has changed and needs to be saved
+    bool learnRequestAnswered(int requestType);
+    // once per boot at most; a request the unit has answered once is never deemed unsupported
+    bool learnRequestMissed(int requestType);
+    bool learnFlag(bool& flag, bool value);
+
+    void log();
+};
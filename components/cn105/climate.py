@@ -33,6 +33,9 @@ from esphome.const import (
     DEVICE_CLASS_DURATION,
     CONF_TX_PIN,
     CONF_RX_PIN,
+    CONF_ADDRESS,
+    CONF_PORT,
+    CONF_BAUD_RATE,
 )
 from esphome.components.sensor import (
     CONF_UNIT_OF_MEASUREMENT as SENSOR_CONF_UNIT_OF_MEASUREMENT,
@@ -69,6 +72,8 @@ CONF_ISEE_SENSOR = "isee_sensor"
 CONF_FUNCTIONS_SENSOR = "functions_sensor"
 CONF_FUNCTIONS_BUTTON = "functions_get_button"
 CONF_FUNCTIONS_SET_BUTTON = "functions_set_button"
+CONF_PACKET_TRACE_BUTTON = "packet_trace_button"
+CONF_CAPABILITIES_RESET_BUTTON = "capabilities_reset_button"
 CONF_FUNCTIONS_SET_CODE = "functions_set_code"
 CONF_FUNCTIONS_SET_VALUE = "functions_set_value"
 CONF_STAGE_SENSOR = "stage_sensor"
@@ -92,6 +97,11 @@ CN105Climate = cg.global_ns.class_(
 )
 CONF_REMOTE_TEMP_TIMEOUT = "remote_temperature_timeout"
 CONF_DEBOUNCE_DELAY = "debounce_delay"
+CONF_PROBE_INTERVAL = "liveness_probe_interval"
+CONF_MAX_MISSED_PROBES = "liveness_max_missed_probes"
+CONF_SNAPSHOT_SAVE_INTERVAL = "state_snapshot_interval"
+CONF_TCP_BRIDGE_PORT = "tcp_bridge_port"
+CONF_TCP_TRANSPORT = "tcp_transport"
 
 # Définitions des classes C++ (identiques à votre version)
 VaneOrientationSelect = cg.global_ns.class_(
@@ -215,6 +225,27 @@ HVAC_OPTION_SWITCH_SCHEMA = switch.switch_schema(HVACOptionSwitch).extend(
     {cv.GenerateID(CONF_ID): cv.declare_id(HVACOptionSwitch )}
 )
 
+TCP_TRANSPORT_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Required(CONF_ADDRESS): cv.ipv4address,
+            cv.Optional(CONF_PORT, default=6638): cv.port,
+            cv.Optional(CONF_BAUD_RATE, default=2400): cv.positive_int,
+        }
+    ),
+    cv.requires_component("socket"),
+)
+
+
+def validate_transport(config):
+    # the unit is reached through a serial to TCP bridge: no UART on this ESP
+    if CONF_TCP_TRANSPORT in config:
+        uart_id = config.pop(CONF_UART_ID, None)
+        if uart_id is not None and uart_id.is_manual:
+            raise cv.Invalid("uart_id and tcp_transport cannot be used together")
+    return config
+
+
 CONFIG_SCHEMA = climate.climate_schema(CN105Climate).extend(
     {
         cv.GenerateID(): cv.declare_id(CN105Climate),
@@ -242,6 +273,8 @@ CONFIG_SCHEMA = climate.climate_schema(CN105Climate).extend(
         cv.Optional(CONF_FUNCTIONS_SENSOR): FUNCTIONS_SENSOR_SCHEMA,
         cv.Optional(CONF_FUNCTIONS_BUTTON): FUNCTIONS_BUTTON_SCHEMA,
         cv.Optional(CONF_FUNCTIONS_SET_BUTTON): FUNCTIONS_BUTTON_SCHEMA,
+        cv.Optional(CONF_PACKET_TRACE_BUTTON): FUNCTIONS_BUTTON_SCHEMA,
+        cv.Optional(CONF_CAPABILITIES_RESET_BUTTON): FUNCTIONS_BUTTON_SCHEMA,
         cv.Optional(CONF_FUNCTIONS_SET_CODE): FUNCTIONS_NUMBER_SCHEMA,
         cv.Optional(CONF_FUNCTIONS_SET_VALUE): FUNCTIONS_NUMBER_SCHEMA,
         cv.Optional(CONF_FAHRENHEIT_SUPPORT_MODE): cv.boolean,
@@ -254,6 +287,15 @@ CONFIG_SCHEMA = climate.climate_schema(CN105Climate).extend(
             cv.update_interval
         ),
         cv.Optional(CONF_DEBOUNCE_DELAY, default="100ms"): cv.All(cv.update_interval),
+        cv.Optional(CONF_PROBE_INTERVAL, default="3s"): cv.All(cv.update_interval),
+        cv.Optional(CONF_MAX_MISSED_PROBES, default=5): cv.int_range(min=1, max=100),
+        cv.Optional(CONF_SNAPSHOT_SAVE_INTERVAL, default="10min"): cv.All(
+            cv.update_interval
+        ),
+        cv.Optional(CONF_TCP_BRIDGE_PORT): cv.All(
+            cv.port, cv.requires_component("socket")
+        ),
+        cv.Optional(CONF_TCP_TRANSPORT): TCP_TRANSPORT_SCHEMA,
         cv.Optional(
             CONF_HP_UP_TIME_CONNECTION_SENSOR
         ): HP_UP_TIME_CONNECTION_SENSOR_SCHEMA,
@@ -276,21 +318,34 @@ CONFIG_SCHEMA = climate.climate_schema(CN105Climate).extend(
         ),
     }
 ).extend(cv.COMPONENT_SCHEMA)
+CONFIG_SCHEMA = cv.All(CONFIG_SCHEMA, validate_transport)
 
 
 @coroutine
 def to_code(config):
-    uart_id_object = config[CONF_UART_ID]
-    uart_var = yield cg.get_variable(uart_id_object)
-    var = cg.new_Pvariable(config[CONF_ID], uart_var)
+    if CONF_TCP_TRANSPORT in config:
+        tcp_config = config[CONF_TCP_TRANSPORT]
+        var = cg.new_Pvariable(config[CONF_ID], cg.nullptr)
+        cg.add_define("USE_CN105_TCP_TRANSPORT")
+        cg.add(
+            var.set_tcp_transport(
+                str(tcp_config[CONF_ADDRESS]),
+                tcp_config[CONF_PORT],
+                tcp_config[CONF_BAUD_RATE],
+            )
+        )
+    else:
+        uart_id_object = config[CONF_UART_ID]
+        uart_var = yield cg.get_variable(uart_id_object)
+        var = cg.new_Pvariable(config[CONF_ID], uart_var)
 
-    cg.add(uart_var.set_data_bits(8))
-    cg.add(uart_var.set_parity(UARTParityOptions.UART_CONFIG_PARITY_EVEN))
-    cg.add(uart_var.set_stop_bits(1))
+        cg.add(uart_var.set_data_bits(8))
+        cg.add(uart_var.set_parity(UARTParityOptions.UART_CONFIG_PARITY_EVEN))
+        cg.add(uart_var.set_stop_bits(1))
 
-    uart_id_str_for_lookup = str(uart_id_object)
-    tx_pin, rx_pin = get_uart_pins_from_config(CORE.config, uart_id_str_for_lookup)
-    cg.add(var.set_tx_rx_pins(tx_pin, rx_pin))
+        uart_id_str_for_lookup = str(uart_id_object)
+        tx_pin, rx_pin = get_uart_pins_from_config(CORE.config, uart_id_str_for_lookup)
+        cg.add(var.set_tx_rx_pins(tx_pin, rx_pin))
 
     if CONF_SUPPORTS in config:
         supports = config[CONF_SUPPORTS]
@@ -317,6 +372,12 @@ def to_code(config):
 
     cg.add(var.set_remote_temp_timeout(config[CONF_REMOTE_TEMP_TIMEOUT]))
     cg.add(var.set_debounce_delay(config[CONF_DEBOUNCE_DELAY]))
+    cg.add(var.set_probe_interval(config[CONF_PROBE_INTERVAL]))
+    cg.add(var.set_max_missed_probes(config[CONF_MAX_MISSED_PROBES]))
+    cg.add(var.set_snapshot_save_interval(config[CONF_SNAPSHOT_SAVE_INTERVAL]))
+    if CONF_TCP_BRIDGE_PORT in config:
+        cg.add_define("USE_CN105_TCP_BRIDGE")
+        cg.add(var.set_tcp_bridge_port(config[CONF_TCP_BRIDGE_PORT]))
 
     # --- Configuration des entités optionnelles (style original) ---
     if CONF_HORIZONTAL_SWING_SELECT in config:
@@ -392,6 +453,14 @@ def to_code(config):
         button_var = yield button.new_button(config[CONF_FUNCTIONS_SET_BUTTON])
         cg.add(var.set_functions_set_button(button_var))
 
+    if CONF_PACKET_TRACE_BUTTON in config:
+        button_var = yield button.new_button(config[CONF_PACKET_TRACE_BUTTON])
+        cg.add(var.set_packet_trace_button(button_var))
+
+    if CONF_CAPABILITIES_RESET_BUTTON in config:
+        button_var = yield button.new_button(config[CONF_CAPABILITIES_RESET_BUTTON])
+        cg.add(var.set_capabilities_reset_button(button_var))
+
     if CONF_FUNCTIONS_SET_CODE in config:
         conf_item = config[CONF_FUNCTIONS_SET_CODE]
         number_var = yield number.new_number(
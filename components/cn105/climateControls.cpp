@@ -11,8 +11,7 @@ using namespace esphome;
 
 
 void CN105Climate::checkPendingWantedSettings() {
-    long now = CUSTOM_MILLIS;
-    if (!(this->wantedSettings.hasChanged) || (now - this->wantedSettings.lastChange < this->debounce_delay_)) {
+    if (!(this->wantedSettings.hasChanged) || (elapsedMs(cn105Millis(), this->wantedSettings.lastChange) < this->debounce_delay_)) {
         return;
     }
 
@@ -21,8 +20,7 @@ void CN105Climate::checkPendingWantedSettings() {
 }
 
 void CN105Climate::checkPendingWantedRunStates() {
-    long now = CUSTOM_MILLIS;
-    if (!(this->wantedRunStates.hasChanged) || (now - this->wantedSettings.lastChange < this->debounce_delay_)) {
+    if (!(this->wantedRunStates.hasChanged) || (elapsedMs(cn105Millis(), this->wantedSettings.lastChange) < this->debounce_delay_)) {
         return;
     }
     ESP_LOGI(LOG_ACTION_EVT_TAG, "checkPendingWantedRunStates - wanted run states have changed, sending them to the heatpump...");
@@ -83,7 +81,7 @@ void CN105Climate::controlDelegate(const esphome::climate::ClimateCall& call) {
         logCheckWantedSettingsMutex(this->wantedSettings);
         this->wantedSettings.hasChanged = true;
         this->wantedSettings.hasBeenSent = false;
-        this->wantedSettings.lastChange = CUSTOM_MILLIS;
+        this->wantedSettings.lastChange = cn105Millis();
         this->debugSettings("control (wantedSettings)", this->wantedSettings);
     }
 
@@ -116,10 +114,10 @@ void CN105Climate::controlSwing() {
     case climate::CLIMATE_SWING_OFF:
         // When swing is turned OFF, conditionally set vanes to a default static position.
         // This only sets default position if swing was previously enabled
-        if (strcmp(currentSettings.vane, "SWING") == 0) {
+        if (strcmp(hpState.settings.vane, "SWING") == 0) {
             this->setVaneSetting("AUTO");
         }
-        if (wideVaneSupported && strcmp(currentSettings.wideVane, "SWING") == 0) {
+        if (wideVaneSupported && strcmp(hpState.settings.wideVane, "SWING") == 0) {
             this->setWideVaneSetting("|");
         }
         break;
@@ -130,7 +128,7 @@ void CN105Climate::controlSwing() {
         // If horizontal swing was also on AND is supported, turn it off to a default static position.
         // This correctly handles switching from BOTH to VERTICAL, while preserving any user's
         // static horizontal setting if it wasn't swinging.
-        if (wideVaneSupported && strcmp(currentSettings.wideVane, "SWING") == 0) {
+        if (wideVaneSupported && strcmp(hpState.settings.wideVane, "SWING") == 0) {
             this->setWideVaneSetting("|");
         }
         break;
@@ -139,7 +137,7 @@ void CN105Climate::controlSwing() {
         // If vertical swing was on, turn it off to a default static position.
         // This correctly handles switching from BOTH to HORIZONTAL, while preserving any user's
         // static vertical setting if it wasn't swinging.
-        if (strcmp(currentSettings.vane, "SWING") == 0) {
+        if (strcmp(hpState.settings.vane, "SWING") == 0) {
             this->setVaneSetting("AUTO");
         }
         // Turn on horizontal swing, but only if the unit supports it.
@@ -232,7 +230,7 @@ void CN105Climate::controlTemperature() {
         setting = mapCelsiusForConversionFromFahrenheit(setting);
     }
     if (!this->tempMode) {
-        this->wantedSettings.temperature = this->lookupByteMapIndex(TEMP_MAP, 16, (int)(setting + 0.5)) > -1 ? setting : TEMP_MAP[0];
+        this->wantedSettings.temperature = lookupByteMapIndex(TEMP_MAP, 16, (int)(setting + 0.5)) > -1 ? setting : TEMP_MAP[0];
     } else {
         setting = std::round(2.0f * setting) / 2.0f;  // Round to the nearest half-degree.
         this->wantedSettings.temperature = setting < 10 ? 10 : (setting > 31 ? 31 : setting);
@@ -278,15 +276,15 @@ void CN105Climate::controlMode() {
 
 
 void CN105Climate::setActionIfOperatingTo(climate::ClimateAction action_if_operating) {
-    bool effective_operating_status = this->currentStatus.operating; // Valeur par défaut depuis paquet 0x06
+    bool effective_operating_status = this->hpState.status.operating; // Valeur par défaut depuis paquet 0x06
 
     if (this->use_stage_for_operating_status_) {
         bool stage_is_active = false;
         // Accéder à l'état actuel du stage_sensor
-        // this->currentSettings.stage est mis à jour dans getPowerFromResponsePacket
+        // this->hpState.settings.stage est mis à jour dans getPowerFromResponsePacket
         // lorsque le stage_sensor_ (s'il est configuré) publie son état.
-        if (this->currentSettings.stage != nullptr &&
-            strcmp(this->currentSettings.stage, STAGE_MAP[0 /*IDLE*/]) != 0) {
+        if (this->hpState.settings.stage != nullptr &&
+            strcmp(this->hpState.settings.stage, STAGE_MAP[0 /*IDLE*/]) != 0) {
             stage_is_active = true;
         }
 
@@ -319,7 +317,7 @@ void CN105Climate::setActionIfOperatingTo(climate::ClimateAction action_if_opera
         static_cast<int>(this->action),
         effective_operating_status ? "true" : "false",
         this->use_stage_for_operating_status_ ? "yes" : "no",
-        this->currentSettings.stage ? this->currentSettings.stage : "N/A");
+        this->hpState.settings.stage ? this->hpState.settings.stage : "N/A");
 }
 
 /**
@@ -332,7 +330,7 @@ void CN105Climate::setActionIfOperatingAndCompressorIsActiveTo(climate::ClimateA
 
     ESP_LOGW(TAG, "Warning: the use of compressor frequency as an active indicator is deprecated. Please use operating status instead.");
 
-    if (currentStatus.compressorFrequency <= 0) {
+    if (hpState.status.compressorFrequency <= 0) {
         this->action = climate::CLIMATE_ACTION_IDLE;
     } else {
         this->setActionIfOperatingTo(action);
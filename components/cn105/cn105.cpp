@@ -7,6 +7,8 @@ using namespace esphome;
 CN105Climate::CN105Climate(uart::UARTComponent* uart) :
     UARTDevice(uart) {
 
+    this->uartLink.uart = uart;         // nullptr with tcp_transport
+
     this->traits_.set_supports_action(true);
     this->traits_.set_supports_current_temperature(true);
     this->traits_.set_supports_two_point_target_temperature(false);
@@ -20,16 +22,14 @@ CN105Climate::CN105Climate(uart::UARTComponent* uart) :
     this->wideVaneAdj = false;
     this->functions = heatpumpFunctions();
     this->autoUpdate = false;
-    this->firstRun = true;
     this->externalUpdate = false;
-    this->lastSend = 0;
     this->infoMode = 0;
-    this->lastConnectRqTimeMs = 0;
-    this->currentStatus.operating = false;
-    this->currentStatus.compressorFrequency = NAN;
-    this->currentStatus.inputPower = NAN;
-    this->currentStatus.kWh = NAN;
-    this->currentStatus.runtimeHours = NAN;
+    this->hpState.init();
+    this->hpState.status.operating = false;
+    this->hpState.status.compressorFrequency = NAN;
+    this->hpState.status.inputPower = NAN;
+    this->hpState.status.kWh = NAN;
+    this->hpState.status.runtimeHours = NAN;
     this->tx_pin_ = -1;
     this->rx_pin_ = -1;
 
@@ -45,11 +45,17 @@ CN105Climate::CN105Climate(uart::UARTComponent* uart) :
     this->night_mode_switch_ = nullptr;
     this->circulator_switch_ = nullptr;
 
-    this->powerRequestWithoutResponses = 0;     // power request is not supported by all heatpump #112
+    this->scheduler.init();
 
     this->remote_temp_timeout_ = 4294967295;    // uint32_t max
+    this->snapshot_save_interval_ = DEFAULT_SNAPSHOT_SAVE_INTERVAL_MS;
     this->generateExtraComponents();
     this->loopCycle.init();
+    this->connection.init();
+    this->liveness.init();
+    this->link.init();
+    this->transmitQueue.init();
+    this->trace.init();
     this->wantedSettings.resetSettings();
     this->wantedRunStates.resetSettings();
 #ifndef USE_ESP32
@@ -95,53 +101,132 @@ void CN105Climate::set_debounce_delay(uint32_t delay) {
     log_info_uint32(LOG_ACTION_EVT_TAG, "set_debounce_delay is set to ", delay);
 }
 
+void CN105Climate::set_probe_interval(uint32_t interval) {
+    this->liveness.probeIntervalMs = interval;
+    log_info_uint32(TAG, "liveness probe interval is set to ", interval, " ms");
+}
+
+void CN105Climate::set_max_missed_probes(int max_missed) {
+    this->liveness.maxMissedProbes = max_missed;
+    ESP_LOGI(TAG, "liveness max missed probes is set to %d", max_missed);
+}
+
+void CN105Climate::set_snapshot_save_interval(uint32_t interval) {
+    this->snapshot_save_interval_ = interval;
+    if (interval == 4294967295) {
+        ESP_LOGI(TAG, "state snapshot is disabled.");
+    } else {
+        log_info_uint32(TAG, "state snapshot min save interval is set to ", interval, " ms");
+    }
+}
+
+void CN105Climate::set_tcp_bridge_port(uint16_t port) {
+#ifdef USE_CN105_TCP_BRIDGE
+    this->bridge.port = port;
+    ESP_LOGI(TAG, "tcp bridge port is set to %u", port);
+#else
+    ESP_LOGW(TAG, "tcp bridge not compiled in, port %u ignored", port);
+#endif
+}
+
+void CN105Climate::set_tcp_transport(const std::string& host, uint16_t port, uint32_t baud_rate) {
+#ifdef USE_CN105_TCP_TRANSPORT
+    this->tcpLink.host = host;
+    this->tcpLink.port = port;
+    this->tcpLink.baudRate = baud_rate;
+    this->transport = &this->tcpLink;
+    ESP_LOGI(TAG, "tcp transport is set to %s:%u", host.c_str(), port);
+#else
+    ESP_LOGW(TAG, "tcp transport not compiled in, %s:%u ignored", host.c_str(), port);
+#endif
+}
+
+uint32_t CN105Climate::get_transport_rtt() {
+    return this->transport->getRttMs();
+}
+
+uint32_t CN105Climate::get_heatpump_turnaround() {
+    return this->turnaround.avg;
+}
+
+void CN105Climate::logTransportStats() {
+    ESP_LOGI(TAG, "transport: %s", this->transport->getName());
+    this->transport->logStats();
+    ESP_LOGI(TAG, "heatpump turnaround: last %u ms, avg %u ms, min %u ms, max %u ms (%u responses)",
+        (unsigned int)this->turnaround.last, (unsigned int)this->turnaround.avg, (unsigned int)this->turnaround.min,
+        (unsigned int)this->turnaround.max, (unsigned int)this->turnaround.count);
+}
+
+bool CN105Climate::is_state_restored() {
+    return this->stateRestored;
+}
+
 float CN105Climate::get_compressor_frequency() {
-    return currentStatus.compressorFrequency;
+    return hpState.status.compressorFrequency;
 }
 float CN105Climate::get_input_power() {
-    return currentStatus.inputPower;
+    return hpState.status.inputPower;
 }
 float CN105Climate::get_kwh() {
-    return currentStatus.kWh;
+    return hpState.status.kWh;
 }
 float CN105Climate::get_runtime_hours() {
-    return currentStatus.runtimeHours;
+    return hpState.status.runtimeHours;
 }
 bool CN105Climate::is_operating() {
-    return currentStatus.operating;
+    return hpState.status.operating;
 }
 bool CN105Climate::is_air_purifier() {
-    return currentRunStates.air_purifier;
+    return hpState.runStates.air_purifier;
 }
 bool CN105Climate::is_night_mode() {
-    return currentRunStates.night_mode;
+    return hpState.runStates.night_mode;
 }
 bool CN105Climate::is_circulator() {
-    return currentRunStates.circulator;
+    return hpState.runStates.circulator;
 }
 
-// SERIAL_8E1
+/**
+ * opens the transport: the UART when it is 8E1, or a TCP connection, which is
+ * only reported up later by processTransport() when it takes time
+*/
 void CN105Climate::setupUART() {
 
-    log_info_uint32(TAG, "setupUART() with baudrate ", this->parent_->get_baud_rate());
-    this->setHeatpumpConnected(false);
-    this->isUARTConnected_ = false;
-
-    // just for debugging purpose, a way to use a button i, yaml to trigger a reconnect
-    this->uart_setup_switch = true;
+    if (this->isHeatpumpConnected_) {
+        this->onLinkEvent(LinkEvent::LINK_LOST);
+    }
 
-    if (this->parent_->get_data_bits() == 8 &&
-        this->parent_->get_parity() == uart::UART_CONFIG_PARITY_EVEN &&
-        this->parent_->get_stop_bits() == 1) {
-        ESP_LOGD(TAG, "UART est configuré en SERIAL_8E1");
-        this->isUARTConnected_ = true;
-        this->initBytePointer();
+    if (this->transport->open()) {
+        this->framer.init();
+        this->onLinkEvent(LinkEvent::UART_READY);
     } else {
-        ESP_LOGW(TAG, "UART n'est pas configuré en SERIAL_8E1");
+        this->onLinkEvent(LinkEvent::UART_LOST);
     }
 
 }
 
+/**
+ * connections of the transport that complete or break between two loop() calls (TCP)
+*/
+void CN105Climate::processTransport() {
+    switch (this->transport->poll()) {
+    case TransportEvent::UP:
+        this->framer.init();
+        this->onLinkEvent(LinkEvent::UART_READY);
+        this->sendFirstConnectionPacket();
+        break;
+    case TransportEvent::DOWN:
+        if (this->loopCycle.isCycleRunning()) {
+            this->loopCycle.cycleEnded(true);
+        }
+        this->responsePending = false;
+        this->onLinkEvent(LinkEvent::UART_LOST);
+        break;
+    default:
+        break;
+    }
+}
+
 void CN105Climate::setHeatpumpConnected(bool state) {
     this->isHeatpumpConnected_ = state;
     if (this->hp_uptime_connection_sensor_ != nullptr) {
@@ -154,48 +239,157 @@ void CN105Climate::setHeatpumpConnected(bool state) {
         }
     }
 }
+
+/**
+ * single entry point for link state changes: feeds the state machine
+ * and keeps the connection flags, the uptime sensor and the reconnection backoff in sync
+*/
+void CN105Climate::onLinkEvent(LinkEvent event) {
+    bool wasConnected = this->link.isHeatpumpConnected();
+
+    if (!this->link.handle(event)) {
+        return;
+    }
+
+    this->isUARTConnected_ = !this->link.is(LinkState::UART_DOWN);
+
+    bool connected = this->link.isHeatpumpConnected();
+    if (connected != wasConnected) {
+        this->setHeatpumpConnected(connected);
+        if (connected) {
+            this->connection.connectionSucceeded();
+        } else {
+            this->connection.connectionLost(this->lastResponseMs);
+        }
+    }
+}
+
 void CN105Climate::disconnectUART() {
     ESP_LOGD(TAG, "disconnectUART()");
-    this->uart_setup_switch = false;
-    this->setHeatpumpConnected(false);
-    //this->isHeatpumpConnected_ = false;
-    //this->isUARTConnected_ = false;
-    this->firstRun = true;
+    this->onLinkEvent(LinkEvent::LINK_LOST);
     this->publish_state();
 
 }
 
+/**
+ * Hands the link over to the reconnection state machine.
+ * Idempotent: while the link is not connected, further calls do nothing.
+*/
 void CN105Climate::reconnectUART() {
+    if (!this->isHeatpumpConnected_) {
+        ESP_LOGV(TAG, "reconnectUART(): reconnection already in progress");
+        return;
+    }
     ESP_LOGD(TAG, "reconnectUART()");
-    this->lastReconnectTimeMs = CUSTOM_MILLIS;
     this->disconnectUART();
+    this->transport->close();                           // a TCP connection may be half open: a new one is made
     this->setupUART();
-    this->sendFirstConnectionPacket();
 }
 
+/**
+ * called from loop(): fires the next connection attempt when the backoff delay has elapsed
+*/
+void CN105Climate::checkConnectionAttempt() {
+    if ((this->link.is(LinkState::UART_DOWN) || this->link.is(LinkState::CONNECTING)) && this->connection.isAttemptDue()) {
+        if (this->transmitQueue.getStatus(this->connectTxHandle) == TxStatus::QUEUED) {
+            return;                                     // the previous connection packet has not even left yet
+        }
+        this->sendFirstConnectionPacket();
+    }
+}
+
+uint32_t CN105Climate::get_connection_attempt() {
+    return this->connection.getAttempt();
+}
 
-void CN105Climate::reconnectIfConnectionLost() {
+uint32_t CN105Climate::get_time_since_last_connection() {
+    return this->connection.getTimeSinceLastSuccess();
+}
 
-    long reconnectTimeMs = CUSTOM_MILLIS - this->lastReconnectTimeMs;
+const char* CN105Climate::get_link_state() {
+    return linkStateMachine::getStateName(this->link.state);
+}
+
+uint32_t CN105Climate::get_time_in_link_state(LinkState state) {
+    return this->link.getTimeInState(state);
+}
 
-    if (reconnectTimeMs < this->update_interval_) {
+void CN105Climate::logLinkStats() {
+    this->link.logStats();
+}
+
+#ifdef USE_CN105_TCP_BRIDGE
+void CN105Climate::logTcpBridgeStats() {
+    this->bridge.logStats();
+}
+#endif
+
+/**
+ * reads the capability profile saved by a previous boot, applied once the unit answers (see applyCapabilities)
+*/
+void CN105Climate::loadCapabilities() {
+    this->capabilitiesPref_ = global_preferences->make_preference<capabilityProfile>(
+        this->get_object_id_hash() ^ fnv1_hash("cn105_capabilities"), true);
+
+    if (this->capabilitiesPref_.load(&this->capabilities)) {
+        ESP_LOGI(TAG, "capability profile restored from flash");
+    } else {
+        this->capabilities = capabilityProfile{};
+    }
+}
+
+void CN105Climate::applyCapabilities() {
+    if (!this->capabilities.isValid()) {
+        ESP_LOGI(TAG, "no capability profile yet, learning it");
+        this->capabilities.reset();
+        this->saveCapabilities();
         return;
     }
 
+    ESP_LOGI(TAG, "applying the capability profile");
+    this->capabilities.log();
+    this->tempMode = this->tempMode || this->capabilities.tempMode;
+}
+
+/**
+ * forgets what was learned, after the unit has been swapped: nothing in the protocol tells it
+*/
+void CN105Climate::resetCapabilities() {
+    ESP_LOGI(TAG, "capability profile reset, learning it again");
+    this->capabilities.reset();
+    this->requestsGivenUp = 0;
+    this->saveCapabilities();
+}
+
+void CN105Climate::saveCapabilities() {
+    if (this->capabilities.version != CAPABILITY_PROFILE_VERSION) {
+        return;                                             // not bound to a unit yet
+    }
+    if (!this->capabilitiesPref_.save(&this->capabilities)) {
+        ESP_LOGW(TAG, "could not save the capability profile");
+    }
+}
+
+
+void CN105Climate::reconnectIfConnectionLost() {
+
+    if (!this->isHeatpumpConnected_) {
+        return;                                         // the state machine is already on it
+    }
+
     if (!this->isHeatpumpConnectionActive()) {
-        long connectTimeMs = CUSTOM_MILLIS - this->lastConnectRqTimeMs;
-        if (connectTimeMs > this->update_interval_) {
-            long lrTimeMs = CUSTOM_MILLIS - this->lastResponseMs;
-            ESP_LOGW(TAG, "Heatpump has not replied for %ld s", lrTimeMs / 1000);
-            ESP_LOGI(TAG, "We think Heatpump is not connected anymore..");
-            this->reconnectUART();
-        }
+        uint32_t lrTimeMs = elapsedMs(cn105Millis(), this->lastResponseMs);
+        ESP_LOGW(TAG, "Heatpump has not replied for %u s", (unsigned int)(lrTimeMs / 1000));
+        ESP_LOGI(TAG, "We think Heatpump is not connected anymore..");
+        this->reconnectUART();
     }
 }
 
 
 bool CN105Climate::isHeatpumpConnectionActive() {
-    long lrTimeMs = CUSTOM_MILLIS - this->lastResponseMs;
+    // elapsed time in uint32_t: with a 64 bit long (host builds) the difference went negative
+    // across the wraparound of the ms counter, and a silent heatpump was deemed active
+    uint32_t lrTimeMs = elapsedMs(cn105Millis(), this->lastResponseMs);
 
     // if (lrTimeMs > MAX_DELAY_RESPONSE_FACTOR * this->update_interval_) {
     //     ESP_LOGV(TAG, "Heatpump has not replied for %ld s", lrTimeMs / 1000);
@@ -203,5 +397,121 @@ bool CN105Climate::isHeatpumpConnectionActive() {
     //     this->disconnectUART();
     // }
 
+    if (this->liveness.isLinkLost()) {
+        return false;
+    }
+
     return  (lrTimeMs < MAX_DELAY_RESPONSE_FACTOR * this->update_interval_);
-}
\ No newline at end of file
+}
+
+/**
+ * Liveness layer (livenessManagement), independent of update_interval: sends the probes
+ * and reconnects when too many of them are missed.
+*/
+void CN105Climate::checkLiveness() {
+    if (!this->isHeatpumpConnected_) {
+        return;
+    }
+
+    // over TCP the answer comes a round trip later
+    LivenessAction action = this->liveness.check(this->lastResponseMs, this->transport->getRttMs());
+
+    if (action == LivenessAction::PROBE_MISSED || action == LivenessAction::LINK_LOST) {
+        ESP_LOGW(TAG, "liveness probe missed (%d/%d)",
+            action == LivenessAction::LINK_LOST ? this->liveness.maxMissedProbes : this->liveness.nonResponseCounter,
+            this->liveness.maxMissedProbes);
+        this->onLinkEvent(LinkEvent::PROBE_MISSED);
+    }
+
+    if (action == LivenessAction::LINK_LOST) {
+        ESP_LOGW(TAG, "Heatpump has not replied for %u s", (unsigned int)(elapsedMs(cn105Millis(), this->lastResponseMs) / 1000));
+        ESP_LOGI(TAG, "We think Heatpump is not connected anymore..");
+        if (this->loopCycle.isCycleRunning()) {
+            this->loopCycle.cycleEnded(true);
+        }
+        this->reconnectUART();
+        return;
+    }
+
+    if (action != LivenessAction::NONE && !this->loopCycle.isCycleRunning()) {
+        ESP_LOGD(TAG, "liveness probe: sending status request (0x06)");
+        this->buildAndSendRequestPacket(RQST_PKT_STATUS);
+    }
+}
+/**
+ * publishes the last confirmed state saved in flash, so that HA does not show unknown values
+ * until the first cycle. As hpState.settings is then set, the first connection is a warm one:
+ * the restored state is kept as unverified and reconciled with the first settings read.
+*/
+void CN105Climate::restoreSnapshot() {
+    if (this->snapshot_save_interval_ == 4294967295) {
+        return;
+    }
+
+    this->snapshotPref_ = global_preferences->make_preference<stateSnapshot>(
+        this->get_object_id_hash() ^ fnv1_hash("cn105_snapshot"), true);
+
+    if (!this->snapshotPref_.load(&this->lastSnapshot) || !this->lastSnapshot.isValid()) {
+        ESP_LOGI(TAG, "no valid state snapshot in flash, waiting for the first cycle");
+        memset(&this->lastSnapshot, 0, sizeof(stateSnapshot));
+        return;
+    }
+
+    heatpumpSettings restoredSettings{};
+    heatpumpRunStates restoredRunStates{};
+    heatpumpStatus restoredStatus = this->hpState.status;
+    restoredSettings.resetSettings();
+    restoredRunStates.resetSettings();
+    this->lastSnapshot.restore(restoredSettings, restoredRunStates, restoredStatus);
+
+    ESP_LOGI(TAG, "publishing the state restored from flash (power: %s, mode: %s, setpoint: %.1f)",
+        restoredSettings.power, restoredSettings.mode != nullptr ? restoredSettings.mode : "-", restoredSettings.temperature);
+    this->stateRestored = true;
+
+    this->publishStateToHA(restoredSettings);
+    this->statusChanged(restoredStatus);
+
+    this->hpState.runStates = restoredRunStates;
+    if ((this->airflow_control_select_ != nullptr) && (restoredRunStates.airflow_control != nullptr)) {
+        this->airflow_control_select_->publish_state(restoredRunStates.airflow_control);
+    }
+    if ((this->air_purifier_switch_ != nullptr) && (restoredRunStates.air_purifier >= 0)) {
+        this->air_purifier_switch_->publish_state(restoredRunStates.air_purifier);
+    }
+    if ((this->night_mode_switch_ != nullptr) && (restoredRunStates.night_mode >= 0)) {
+        this->night_mode_switch_->publish_state(restoredRunStates.night_mode);
+    }
+    if ((this->circulator_switch_ != nullptr) && (restoredRunStates.circulator >= 0)) {
+        this->circulator_switch_->publish_state(restoredRunStates.circulator);
+    }
+}
+
+/**
+ * called at the end of each complete cycle: writes the snapshot only when the state has really
+ * changed, and at most once per snapshot_save_interval_ (a skipped change is retried next cycle)
+*/
+void CN105Climate::saveSnapshotIfChanged() {
+    if ((this->snapshot_save_interval_ == 4294967295) || (this->hpState.settings.power == nullptr)) {
+        return;
+    }
+
+    stateSnapshot snapshot;
+    snapshot.capture(this->hpState.settings, this->hpState.runStates, this->hpState.status);
+
+    if (snapshot.sameStateAs(this->lastSnapshot)) {
+        return;
+    }
+    if (this->snapshotSaved && elapsedMs(cn105Millis(), this->lastSnapshotSaveMs) < this->snapshot_save_interval_) {
+        return;
+    }
+
+    if (this->snapshotPref_.save(&snapshot)) {
+        this->lastSnapshot = snapshot;
+        this->lastSnapshotSaveMs = cn105Millis();
+        this->snapshotSaved = true;
+        this->nbSnapshotWrites_++;
+        ESP_LOGD(TAG, "state snapshot saved (%lu writes since boot)", this->nbSnapshotWrites_);
+    } else {
+        ESP_LOGW(TAG, "could not save the state snapshot");
+    }
+}
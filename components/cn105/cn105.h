@@ -20,6 +20,23 @@
 #include <esphome/components/button/button.h>
 #include <esphome/components/binary_sensor/binary_sensor.h>
 #include "cycle_management.h"
+#include "connection_management.h"
+#include "liveness_management.h"
+#include "link_state_machine.h"
+#include "capability_profile.h"
+#include "state_snapshot.h"
+#include "tx_queue.h"
+#include "packet_trace.h"
+#include "cn105_framer.h"
+#include "cn105_decoders.h"
+#include "cn105_encoders.h"
+#include "cn105_state.h"
+#include "cn105_scheduler.h"
+#include "wanted_settings.h"
+#include "tcp_bridge.h"
+#include "cn105_transport.h"
+#include "uart_transport.h"
+#include "tcp_transport.h"
 
 #ifdef USE_ESP32
 #include <mutex>
@@ -59,6 +76,8 @@ namespace esphome {
         void set_functions_set_button(FunctionsButton* Button);
         void set_functions_set_code(FunctionsNumber* Number);
         void set_functions_set_value(FunctionsNumber* Number);
+        void set_packet_trace_button(FunctionsButton* Button);
+        void set_capabilities_reset_button(FunctionsButton* Button);
 
         void set_sub_mode_sensor(esphome::text_sensor::TextSensor* Sub_mode_sensor);
         void set_auto_sub_mode_sensor(esphome::text_sensor::TextSensor* Auto_sub_mode_sensor);
@@ -74,6 +93,8 @@ namespace esphome {
         FunctionsButton* Functions_set_button_ = nullptr;
         FunctionsNumber* Functions_set_code_ = nullptr;
         FunctionsNumber* Functions_set_value_ = nullptr;
+        FunctionsButton* packet_trace_button_ = nullptr;
+        FunctionsButton* capabilities_reset_button_ = nullptr;
         text_sensor::TextSensor* Sub_mode_sensor_ = nullptr;
         text_sensor::TextSensor* Auto_sub_mode_sensor_ = nullptr;
         HVACOptionSwitch* air_purifier_switch_ = nullptr;
@@ -139,6 +160,37 @@ namespace esphome {
         void buildAndSendRequestPacket(int packetType);
         bool isHeatpumpConnectionActive();
         void reconnectIfConnectionLost();
+        void checkLiveness();
+        void checkConnectionAttempt();
+
+        // reconnection diagnostics
+        uint32_t get_connection_attempt();
+        uint32_t get_time_since_last_connection();
+
+        // the unit through a serial to TCP bridge instead of the UART (tcp_transport)
+        void set_tcp_transport(const std::string& host, uint16_t port, uint32_t baud_rate);
+        // round trip of the transport, and time the unit takes to answer, without the transport and the line
+        uint32_t get_transport_rtt();
+        uint32_t get_heatpump_turnaround();
+        void logTransportStats();
+
+        // link state machine diagnostics
+        const char* get_link_state();
+        uint32_t get_time_in_link_state(LinkState state);
+        void logLinkStats();
+
+        // forgets the learned capabilities, after swapping the unit (capabilities_reset_button)
+        void resetCapabilities();
+
+        // logs the last frames exchanged with the heatpump (binary trace, formatted on demand)
+        void dumpPacketTrace();
+
+        // raw CN105 stream served on a TCP port (tcp_bridge_port), its frames are arbitrated with the poll cycle
+        void set_tcp_bridge_port(uint16_t port);
+#ifdef USE_CN105_TCP_BRIDGE
+        const tcpBridgeStats& get_tcp_bridge_stats() const { return this->bridge.stats; }
+        void logTcpBridgeStats();
+#endif
 
         void sendWantedSettings();
         void sendWantedSettingsDelegate();
@@ -152,6 +204,13 @@ namespace esphome {
 
         void set_debounce_delay(uint32_t delay);
 
+        void set_probe_interval(uint32_t interval);
+        void set_max_missed_probes(int max_missed);
+
+        void set_snapshot_save_interval(uint32_t interval);
+        // true from boot until the first complete cycle, while HA shows the state restored from flash
+        bool is_state_restored();
+
         // this is the ping or heartbeat of the setRemotetemperature for timeout management
         void pingExternalTemperature();
 
@@ -172,9 +231,7 @@ namespace esphome {
         // Configure the climate object with traits that we support.
 
 
-        /// le bouton de setup de l'UART
-        bool uart_setup_switch;
-
+        // mirrors of the link state machine (kept for yaml lambdas), only written by onLinkEvent()
         bool isUARTConnected_ = false;
         bool isHeatpumpConnected_ = false;
         bool shouldSendExternalTemperature_ = false;
@@ -183,6 +240,9 @@ namespace esphome {
         unsigned long nbCompleteCycles_ = 0;
         unsigned long nbCycles_ = 0;
         unsigned int nbHeatpumpConnections_ = 0;
+        // nb of entity publications to HA spared by warm reconnects (unverified state confirmed unchanged)
+        unsigned long nbRepublishAvoided_ = 0;
+        unsigned long nbSnapshotWrites_ = 0;
 
 
         void sendFirstConnectionPacket();
@@ -225,32 +285,26 @@ namespace esphome {
 
         bool processInput(void);
         void parse(uint8_t inputData);
-        void checkHeader(uint8_t inputData);
-        void initBytePointer();
         void processDataPacket();
         void getDataFromResponsePacket();
         void getAutoModeStateFromResponsePacket(); //NET added
-        void getPowerFromResponsePacket(); //NET added
-        void getSettingsFromResponsePacket();
-        void getRoomTemperatureFromResponsePacket();
-        void getOperatingAndCompressorFreqFromResponsePacket();
-        void getHVACOptionsFromResponsePacket();
+        void getPowerFromResponsePacket(const infoResponse& response); //NET added
+        void getSettingsFromResponsePacket(const infoResponse& response);
+        void getRoomTemperatureFromResponsePacket(const infoResponse& response);
+        void getOperatingAndCompressorFreqFromResponsePacket(const infoResponse& response);
+        void getHVACOptionsFromResponsePacket(const infoResponse& response);
+        decodeOptions getDecodeOptions();
+        void scheduleNextRequest(uint8_t infoCode);
 
         void updateSuccess();
         void processCommand();
-        bool checkSum();
         uint8_t checkSum(uint8_t bytes[], int len);
 
         const char* getModeSetting();
         const char* getPowerSetting();
         const char* getVaneSetting();
-        const char* getWideVaneSetting();
-        const char* getAirflowControlSetting();
         const char* getFanSpeedSetting();
         float getTemperatureSetting();
-        bool getAirPurifierRunState();
-        bool getNightModeRunState();
-        bool getCirculatorRunState();
 
         void setModeSetting(const char* setting);
         void setPowerSetting(const char* setting);
@@ -260,14 +314,21 @@ namespace esphome {
         void setFanSpeed(const char* setting);
 
         void setHeatpumpConnected(bool state);
+        void onLinkEvent(LinkEvent event);
 
     private:
-        const char* lookupByteMapValue(const char* valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo = "", const char* defaultValue = nullptr);
-        int lookupByteMapValue(const int valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo = "");
-        int lookupByteMapIndex(const char* valuesMap[], int len, const char* lookupValue, const char* debugInfo = "");
-        int lookupByteMapIndex(const int valuesMap[], int len, int lookupValue, const char* debugInfo = "");
 
-        void writePacket(uint8_t* packet, int length, bool checkIsActive = true);
+        void processTransport();
+        void measureTurnaround(int responseLength);
+        txHandle writePacket(uint8_t* packet, int length, bool checkIsActive = true, TxPriority priority = TxPriority::PRIO_NORMAL);
+        void processTxQueue();
+        void processTcpBridge();
+        bool isTcpBridgeBusy();
+        bool isTcpBridgeSlotFree();
+        void sendFrame(const uint8_t* packet, int length);
+        uint32_t getFrameDurationMs(int length);
+        bool isTxComplete();
+        uint32_t getTimeSinceTxComplete();
         void prepareInfoPacket(uint8_t* packet, int length);
         void prepareSetPacket(uint8_t* packet, int length);
 
@@ -278,6 +339,16 @@ namespace esphome {
         void heatpumpUpdate(heatpumpSettings& settings);
 
         void statusChanged(heatpumpStatus status);
+        void publishStatus(uint32_t changed);
+
+        void reconcileUnverifiedSettings(heatpumpSettings& settings);
+
+        void loadCapabilities();
+        void applyCapabilities();
+        void saveCapabilities();
+
+        void restoreSnapshot();
+        void saveSnapshotIfChanged();
 
         void checkPendingWantedSettings();
         void checkPendingWantedRunStates();
@@ -292,7 +363,7 @@ namespace esphome {
         void updateAction();
         void setActionIfOperatingTo(climate::ClimateAction action);
         void setActionIfOperatingAndCompressorIsActiveTo(climate::ClimateAction action);
-        void hpPacketDebug(uint8_t* packet, unsigned int length, const char* packetDirection);
+        void hpPacketDebug(const uint8_t* packet, unsigned int length, TraceDirection direction);
 
         void debugSettings(const char* settingName, heatpumpSettings& settings);
         void debugSettings(const char* settingName, wantedHeatpumpSettings& settings);
@@ -310,11 +381,36 @@ namespace esphome {
 
         void createPacket(uint8_t* packet);
         void createInfoPacket(uint8_t* packet, uint8_t packetType);
-        heatpumpSettings currentSettings{};
+        // last known state of the unit: settings, status and run states
+        cn105State hpState;
         wantedHeatpumpSettings wantedSettings{};
-        heatpumpRunStates currentRunStates{};
         wantedHeatpumpRunStates wantedRunStates{};
         cycleManagement loopCycle{};
+        cn105Scheduler scheduler;
+        connectionManagement connection{};
+        livenessManagement liveness{};
+        linkStateMachine link{};
+        capabilityProfile capabilities{};
+        uint8_t requestsGivenUp = 0;                // RQST_PKT_* given up since boot, counted once in the profile
+        txQueue transmitQueue{};
+        uartTransport uartLink{};
+#ifdef USE_CN105_TCP_TRANSPORT
+        tcpTransport tcpLink{};
+#endif
+        cn105Transport* transport = &uartLink;
+        latencyStats turnaround{};
+        bool responsePending = false;               // a frame was sent, the next one of the unit answers it
+        packetTrace trace{};
+#ifdef USE_CN105_TCP_BRIDGE
+        tcpBridge bridge{};
+#endif
+        txHandle connectTxHandle = TX_INVALID_HANDLE;
+        ESPPreferenceObject capabilitiesPref_;
+        stateSnapshot lastSnapshot{};               // last snapshot written to (or read from) flash
+        ESPPreferenceObject snapshotPref_;
+        uint32_t lastSnapshotSaveMs = 0;
+        bool snapshotSaved = false;
+        bool stateRestored = false;
 
 #ifdef USE_ESP32
         std::mutex wantedSettingsMutex;
@@ -322,11 +418,12 @@ namespace esphome {
         volatile bool wantedSettingsMutex = false;
 #endif
 
-        unsigned long lastResponseMs;
+        uint32_t lastResponseMs;
 
 
         uint32_t remote_temp_timeout_;
         uint32_t debounce_delay_;
+        uint32_t snapshot_save_interval_;
 
         int baud_ = 0;
         int tx_pin_ = -1;
@@ -335,36 +432,22 @@ namespace esphome {
 
 
         //HardwareSerial* _HardSerial{ nullptr };
-        unsigned long lastSend;
-        unsigned long lastConnectRqTimeMs;
-        unsigned long lastReconnectTimeMs;
+        // estimated time when the stop bit of the last frame leaves the wire (may be in the future)
+        uint32_t txCompleteMs = 0;
 
-        uint8_t storedInputData[MAX_DATA_BYTES]; // multi-byte data
-        uint8_t* data;
+        cn105Framer framer;
+        const uint8_t* data;       // data bytes of the frame being processed
 
-        // initialise to all off, then it will update shortly after connect;
-        heatpumpStatus currentStatus{ 0, 0, false, {TIMER_MODE_MAP[0], 0, 0, 0, 0}, 0, 0, 0, 0 };
         heatpumpFunctions functions;
 
+        // true after a warm reconnect, until a complete cycle has confirmed the last known state
+        bool stateUnverified = false;
+
         bool tempMode = false;
         bool wideVaneAdj;
         bool autoUpdate;
-        bool firstRun;
         int infoMode;
         bool externalUpdate;
 
-        // counter for status request for checking heatpump is still connected
-        // is the counter > MAX_NON_RESPONSE_REQ then we conclude uart is not connected anymore
-        int nonResponseCounter = 0;
-
-        int powerRequestWithoutResponses = 0;
-
-        bool isReading = false;
-        bool isWriting = false;
-
-        bool foundStart = false;
-        int bytesRead = 0;
-        int dataLength = 0;
-        uint8_t command = 0;
     };
 }
@@ -0,0 +1,38 @@
+#include "cn105_clock.h"
+
+#ifdef CN105_HOST_BUILD
+#include <chrono>
+#include <thread>
+#else
+#include "esphome/core/hal.h"
+#endif
+
+/**
+ * esphome::millis()/delay() on the device, the monotonic clock of the OS on a host
+*/
+struct platformClock : cn105Clock {
+#ifdef CN105_HOST_BUILD
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    uint32_t millis() override {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->start).count();
+    }
+    void delay(uint32_t ms) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+#else
+    uint32_t millis() override { return esphome::millis(); }
+    void delay(uint32_t ms) override { esphome::delay(ms); }
+#endif
+};
+
+static platformClock defaultClock;
+static cn105Clock* currentClock = &defaultClock;
+
+void cn105InstallClock(cn105Clock* clock) {
+    currentClock = clock != nullptr ? clock : &defaultClock;
+}
+
+cn105Clock& cn105GetClock() {
+    return *currentClock;
+}
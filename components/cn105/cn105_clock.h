@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * Time source of the component: every timer reads cn105Millis() and every busy wait goes through
+ * cn105Delay(). On the device the platform clock is esphome::millis()/delay(); the host tools
+ * install a virtualClock to run faster than real time and to cross the 32 bit wraparound of the
+ * ms counter (49.7 days).
+ *
+ * Timestamps are uint32_t ms. Compare them only through elapsedMs()/isTimeReached(), which stay
+ * correct across the wraparound for intervals up to 24.8 days.
+*/
+struct cn105Clock {
+    virtual ~cn105Clock() = default;
+    virtual uint32_t millis() = 0;
+    virtual void delay(uint32_t ms) = 0;
+};
+
+/**
+ * Deterministic clock for the host tools: time only moves with advance(), set() or delay()
+*/
+struct virtualClock : cn105Clock {
+    uint32_t nowMs = 0;
+
+    uint32_t millis() override { return this->nowMs; }
+    void delay(uint32_t ms) override { this->nowMs += ms; }
+    void advance(uint32_t ms) { this->nowMs += ms; }
+    void set(uint32_t ms) { this->nowMs = ms; }
+};
+
+// nullptr restores the platform clock
+void cn105InstallClock(cn105Clock* clock);
+cn105Clock& cn105GetClock();
+
+inline uint32_t cn105Millis() { return cn105GetClock().millis(); }
+inline void cn105Delay(uint32_t ms) { cn105GetClock().delay(ms); }
+
+// ms from sinceMs to nowMs, sinceMs being in the past
+inline uint32_t elapsedMs(uint32_t nowMs, uint32_t sinceMs) {
+    return nowMs - sinceMs;
+}
+
+// true once nowMs is at or after timeMs, which may be in the future (deferred deadlines)
+inline bool isTimeReached(uint32_t nowMs, uint32_t timeMs) {
+    return (int32_t)(nowMs - timeMs) >= 0;
+}
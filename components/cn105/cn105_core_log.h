@@ -0,0 +1,21 @@
+#pragma once
+
+/**
+ * Logging of the dependency free core (protocol, framer, decoders).
+ * On the device it is the ESPHome logger; the host tools build with -DCN105_HOST_BUILD
+ * and provide cn105_host_log() (see tools/host/host_log.cpp).
+*/
+#ifdef CN105_HOST_BUILD
+
+extern int cn105_host_log_level;        // 0: none, 1: error, 2: warning, 3: info, 5: debug, 6: verbose
+void cn105_host_log(int level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, ...) cn105_host_log(1, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) cn105_host_log(2, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) cn105_host_log(3, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) cn105_host_log(5, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) cn105_host_log(6, tag, __VA_ARGS__)
+
+#else
+#include "esphome/core/log.h"
+#endif
@@ -0,0 +1,176 @@
+#include "cn105_decoders.h"
+#include "cn105_core_log.h"
+
+#include <map>
+
+// Given a temperature in Celsius that will be converted to Fahrenheit, converts
+// it to the Celsius value corresponding to the the Fahrenheit value that
+// Mitsubishi thermostats would have converted the Celsius value to. For
+// instance, 21.5°C is 70.7°F, but to get it to map to 70°F, this function
+// returns 21.1°C.
+float mapCelsiusForConversionToFahrenheit(const float c) {
+    // allocated once and never destroyed: the lambda returns the reference, not a copy
+    static const auto& mapping = []() -> const std::map<float, float>& {
+        auto* const m = new std::map<float, float>{
+            {16.0, 61}, {16.5, 62}, {17.0, 63}, {17.5, 64}, {18.0, 65},
+            {18.5, 66}, {19.0, 67}, {20.0, 68}, {21.0, 69}, {21.5, 70},
+            {22.0, 71}, {22.5, 72}, {23.0, 73}, {23.5, 74}, {24.0, 75},
+            {24.5, 76}, {25.0, 77}, {25.5, 78}, {26.0, 79}, {26.5, 80},
+            {27.0, 81}, {27.5, 82}, {28.0, 83}, {28.5, 84}, {29.0, 85},
+            {29.5, 86}, {30.0, 87}, {30.5, 88}
+        };
+        for (auto& pair : *m) {
+            pair.second = (pair.second - 32.0f) / 1.8f;
+        }
+        return *m;
+        }();
+
+    auto it = mapping.find(c);
+    if (it == mapping.end()) return c;
+    return it->second;
+}
+
+settingsDecoded decodeSettings(const uint8_t* data, const decodeOptions& options) {
+    settingsDecoded decoded{};
+    heatpumpSettings& receivedSettings = decoded.settings;
+    ESP_LOGD("Decoder", "[0x02 is settings]");
+
+    receivedSettings.connected = true;
+    receivedSettings.power = lookupByteMapValue(POWER_MAP, POWER, 2, data[3], "power reading");
+    receivedSettings.iSee = data[4] > 0x08 ? true : false;
+    receivedSettings.mode = lookupByteMapValue(MODE_MAP, MODE, 5, receivedSettings.iSee ? (data[4] - 0x08) : data[4], "mode reading");
+
+    ESP_LOGD("Decoder", "[Power : %s]", receivedSettings.power);
+    ESP_LOGD("Decoder", "[iSee  : %d]", receivedSettings.iSee);
+    ESP_LOGD("Decoder", "[Mode  : %s]", receivedSettings.mode);
+
+    if (data[11] != 0x00) {
+        int temp = data[11];
+        temp -= 128;
+        receivedSettings.temperature = (float)temp / 2;
+        decoded.tempMode = true;
+    } else {
+        receivedSettings.temperature = lookupByteMapValue(TEMP_MAP, TEMP, 16, data[5], "temperature reading");
+    }
+    if (options.fahrenheitSupport) {
+        receivedSettings.temperature = mapCelsiusForConversionToFahrenheit(receivedSettings.temperature);
+    }
+
+    ESP_LOGD("Decoder", "[Temp °C: %f]", receivedSettings.temperature);
+
+    receivedSettings.fan = lookupByteMapValue(FAN_MAP, FAN, 6, data[6], "fan reading");
+    ESP_LOGD("Decoder", "[Fan: %s]", receivedSettings.fan);
+
+    receivedSettings.vane = lookupByteMapValue(VANE_MAP, VANE, 7, data[7], "vane reading");
+    ESP_LOGD("Decoder", "[Vane: %s]", receivedSettings.vane);
+
+    if ((data[10] != 0) && options.wideVaneSupported) {    // wideVane is not always supported
+        receivedSettings.wideVane = lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, data[10] & 0x0F, "wideVane reading");
+        decoded.wideVane = true;
+        decoded.wideVaneAdj = (data[10] & 0xF0) == 0x80 ? true : false;
+        ESP_LOGD("Decoder", "[wideVane: %s (adj:%d)]", receivedSettings.wideVane, decoded.wideVaneAdj);
+    } else {
+        ESP_LOGD("Decoder", "widevane is not supported");
+    }
+
+    if (data[10] == 0x80) {
+        if (receivedSettings.iSee) {
+            decoded.airflowControl = lookupByteMapValue(AIRFLOW_CONTROL_MAP, AIRFLOW_CONTROL, 3, data[14], "airflow control reading");
+        } else {
+            // For some reason data[10] is 0x80, but the i-See sensor is not active.
+            // Some units let us do this, but the real mode is unknown (might be powersave) and the i-See sensor does not get activated.
+            ESP_LOGD("Decoder", "i-See sensor not present/active.");
+            decoded.airflowControl = AIRFLOW_CONTROL_MAP[0];
+        }
+    } else {
+        decoded.airflowControl = AIRFLOW_CONTROL_MAP[0];
+    }
+
+    return decoded;
+}
+
+void decodeRoomTemperature(const uint8_t* data, const decodeOptions& options, heatpumpStatus& status) {
+    //                 0  1  2  3  4  5  6  7  8  9 10 11 12 13 14 15
+    // FC 62 01 30 10 03 00 00 0E 00 94 B0 B0 FE 42 00 01 0A 64 00 00 A9
+    //                         RT    OT RT SP ?? ?? ?? RM RM RM
+    // RT = room temperature (in old format and in new format)
+    // OT = outside air temperature
+    // SP = room setpoint temperature?
+    // RM = indoor unit operating time in minutes
+
+    if (data[5] > 1) {
+        status.outsideAirTemperature = (data[5] - 128) / 2.0f;
+        if (options.fahrenheitSupport) {
+            status.outsideAirTemperature = mapCelsiusForConversionToFahrenheit(status.outsideAirTemperature);
+        }
+    } else {
+        status.outsideAirTemperature = NAN;
+    }
+
+    if (data[6] != 0x00) {
+        int temp = data[6];
+        temp -= 128;
+        status.roomTemperature = temp / 2.0f;
+    } else {
+        status.roomTemperature = lookupByteMapValue(ROOM_TEMP_MAP, ROOM_TEMP, 32, data[3]);
+    }
+    if (options.fahrenheitSupport) {
+        status.roomTemperature = mapCelsiusForConversionToFahrenheit(status.roomTemperature);
+    }
+
+    status.runtimeHours = float((data[11] << 16) | (data[12] << 8) | data[13]) / 60;
+
+    ESP_LOGD("Decoder", "[Room °C: %f]", status.roomTemperature);
+    ESP_LOGD("Decoder", "[OAT  °C: %f]", status.outsideAirTemperature);
+}
+
+void decodeStatus(const uint8_t* data, heatpumpStatus& status) {
+    //FC 62 01 30 10 06 00 00 1A 01 00 00 00 00 00 00 00 00 00 00 00 3C
+    //MSZ-RW25VGHZ-SC1 / MUZ-RW25VGHZ-SC1
+    //FC 62 01 30 10 06 00 00 00 01 00 08 05 50 00 00 42 00 00 00 00 B7
+    //                           OP IP IP EU EU       ??
+    // OP = operating status (1 = compressor running, 0 = standby)
+    // IP = Current input power in Watts (16-bit decimal)
+    // EU = energy usage
+    //      (used energy in kWh = value/10)
+    //      TODO: Currently the maximum size of the counter is not known and
+    //            if the counter extends to other bytes.
+    // ?? = unknown bytes that appear to have a fixed/constant value
+    ESP_LOGD("Decoder", "[0x06 is status]");
+
+    status.operating = data[4];
+    status.compressorFrequency = data[3];
+    status.inputPower = (data[5] << 8) | data[6];
+    status.kWh = float((data[7] << 8) | data[8]) / 10;
+}
+
+void decodeStage(const uint8_t* data, heatpumpSettings& settings) {
+    //FC 62 01 30 10 09 00 00 00 02 02 00 00 00 00 00 00 00 00 00 00 50
+    ESP_LOGD("Decoder", "[0x09 is sub modes]");
+
+    settings.stage = lookupByteMapValue(STAGE_MAP, STAGE, 7, data[4], "current stage for delivery");
+    settings.sub_mode = lookupByteMapValue(SUB_MODE_MAP, SUB_MODE, 4, data[3], "submode");
+    settings.auto_sub_mode = lookupByteMapValue(AUTO_SUB_MODE_MAP, AUTO_SUB_MODE, 4, data[5], "auto mode sub mode");
+
+    ESP_LOGD("Decoder", "[Stage : %s]", settings.stage);
+    ESP_LOGD("Decoder", "[Sub Mode  : %s]", settings.sub_mode);
+    ESP_LOGD("Decoder", "[Auto Mode Sub Mode  : %s]", settings.auto_sub_mode);
+}
+
+void decodeHVACOptions(const uint8_t* data, heatpumpRunStates& runStates) {
+    //MSZ-LN25VG2W
+    //FC 62 01 30 10 42 01 01 01 00 00 00 00 00 00 00 00 00 00 00 00 18
+    //                  AP NM CL
+    // AP = air purifier (1 = on, 0 = off)
+    // NM = night mode (1 = on, 0 = off)
+    // CL = circulator (1 = on, 0 = off) ! MIGHT BE SAME BYTE AS ECONOCOOL - NEEDS TESTING !
+    ESP_LOGD("Decoder", "[0x42 is HVAC options]");
+
+    runStates.air_purifier = data[1];
+    runStates.night_mode = data[2];
+    runStates.circulator = data[3];
+
+    ESP_LOGD("Decoder", "[Air purifier : %s]", runStates.air_purifier ? "ON" : "OFF");
+    ESP_LOGD("Decoder", "[Night mode : %s]", runStates.night_mode ? "ON" : "OFF");
+    ESP_LOGD("Decoder", "[Circulator : %s]", runStates.circulator ? "ON" : "OFF");
+}
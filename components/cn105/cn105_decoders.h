@@ -0,0 +1,36 @@
+#pragma once
+#include "cn105_protocol.h"
+#include "cn105_types.h"
+
+/**
+ * Pure decoders of the 0x62 info responses: data points to the INFO_RESPONSE_DATA_LEN data bytes of the frame (data[0] is the info code).
+ * They do not publish anything, the caller decides what changed.
+*/
+// data length of the 0x62 responses: the decoders read up to data[15], shorter responses must not be decoded
+static const int INFO_RESPONSE_DATA_LEN = 0x10;
+
+struct decodeOptions {
+    bool wideVaneSupported;         // climate traits support horizontal swing
+    bool fahrenheitSupport;         // use_fahrenheit_support_mode
+};
+
+struct settingsDecoded {
+    heatpumpSettings settings;
+    const char* airflowControl;
+    bool tempMode;                  // setpoint is sent in the enhanced (0.5°C) format
+    bool wideVane;                  // wideVane byte is meaningful
+    bool wideVaneAdj;
+};
+
+float mapCelsiusForConversionToFahrenheit(const float c);
+
+// 0x02: power, mode, setpoint, fan, vanes, i-See and airflow control
+settingsDecoded decodeSettings(const uint8_t* data, const decodeOptions& options);
+// 0x03: room and outside air temperatures, runtime; other fields of status are left untouched
+void decodeRoomTemperature(const uint8_t* data, const decodeOptions& options, heatpumpStatus& status);
+// 0x06: operating, compressor frequency, input power and energy; other fields of status are left untouched
+void decodeStatus(const uint8_t* data, heatpumpStatus& status);
+// 0x09: stage, sub mode and auto sub mode
+void decodeStage(const uint8_t* data, heatpumpSettings& settings);
+// 0x42: air purifier, night mode and circulator
+void decodeHVACOptions(const uint8_t* data, heatpumpRunStates& runStates);
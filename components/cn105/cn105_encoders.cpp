@@ -0,0 +1,150 @@
+#include "cn105_encoders.h"
+#include "cn105_core_log.h"
+
+#include <cmath>
+#include <string.h>
+
+static const char* ENCODER_TAG = "Encoder";
+
+// the setpoint byte is 0x80 + 2 x °C in the enhanced format: anything else would overflow it
+static bool isEncodableTemperature(float temperature) {
+    return std::isfinite(temperature) && temperature > 0 && temperature < 63.5f;
+}
+
+void encodeInfoHeader(uint8_t* packet, int length) {
+    memset(packet, 0, length * sizeof(uint8_t));
+
+    for (int i = 0; i < INFOHEADER_LEN && i < length; i++) {
+        packet[i] = INFOHEADER[i];
+    }
+}
+
+void encodeSetHeader(uint8_t* packet, int length) {
+    memset(packet, 0, length * sizeof(uint8_t));
+
+    for (int i = 0; i < HEADER_LEN && i < length; i++) {
+        packet[i] = HEADER[i];
+    }
+}
+
+void encodeInfoRequest(uint8_t* packet, uint8_t infoCode) {
+    encodeInfoHeader(packet, PACKET_LEN);
+    packet[5] = infoCode;
+    packet[21] = computeChecksum(packet, 21);
+}
+
+void encodeSettings(uint8_t* packet, const heatpumpSettings& wanted, bool tempMode, bool wideVaneAdj) {
+    encodeSetHeader(packet, PACKET_LEN);
+
+    if (wanted.power != nullptr) {
+        ESP_LOGD(ENCODER_TAG, "power -> %s", wanted.power);
+        int index = lookupByteMapIndex(POWER_MAP, 2, wanted.power, "power (write)");
+        if (index > -1) {
+            packet[8] = POWER[index];
+            packet[6] += CONTROL_PACKET_1[0];
+        }
+    }
+
+    if (wanted.mode != nullptr) {
+        ESP_LOGD(ENCODER_TAG, "heatpump mode -> %s", wanted.mode);
+        int index = lookupByteMapIndex(MODE_MAP, 5, wanted.mode, "mode (write)");
+        if (index > -1) {
+            packet[9] = MODE[index];
+            packet[6] += CONTROL_PACKET_1[1];
+        }
+    }
+
+    if (wanted.temperature != -1 && !isEncodableTemperature(wanted.temperature)) {
+        ESP_LOGW(ENCODER_TAG, "temperature %f cannot be written, ignored", wanted.temperature);
+    } else if (wanted.temperature != -1) {
+        if (!tempMode) {
+            ESP_LOGD(ENCODER_TAG, "temperature (tempmode is false) -> %f", wanted.temperature);
+            int index = lookupByteMapIndex(TEMP_MAP, 16, (int)wanted.temperature, "temperature (write)");
+            if (index > -1) {
+                packet[10] = TEMP[index];
+                packet[6] += CONTROL_PACKET_1[2];
+            }
+        } else {
+            ESP_LOGD(ENCODER_TAG, "temperature (tempmode is true) -> %f", wanted.temperature);
+            float temp = (wanted.temperature * 2) + 128;
+            packet[19] = (int)temp;
+            packet[6] += CONTROL_PACKET_1[2];
+        }
+    }
+
+    if (wanted.fan != nullptr) {
+        ESP_LOGD(ENCODER_TAG, "heatpump fan -> %s", wanted.fan);
+        int index = lookupByteMapIndex(FAN_MAP, 6, wanted.fan, "fan (write)");
+        if (index > -1) {
+            packet[11] = FAN[index];
+            packet[6] += CONTROL_PACKET_1[3];
+        }
+    }
+
+    if (wanted.vane != nullptr) {
+        ESP_LOGD(ENCODER_TAG, "heatpump vane -> %s", wanted.vane);
+        int index = lookupByteMapIndex(VANE_MAP, 7, wanted.vane, "vane (write)");
+        if (index > -1) {
+            packet[12] = VANE[index];
+            packet[6] += CONTROL_PACKET_1[4];
+        }
+    }
+
+    if (wanted.wideVane != nullptr) {
+        ESP_LOGD(ENCODER_TAG, "heatpump widevane -> %s", wanted.wideVane);
+        int index = lookupByteMapIndex(WIDEVANE_MAP, 8, wanted.wideVane, "wideVane (write)");
+        if (index > -1) {
+            packet[18] = WIDEVANE[index] | (wideVaneAdj ? 0x80 : 0x00);
+            packet[7] += CONTROL_PACKET_2[0];
+        }
+    }
+
+    packet[21] = computeChecksum(packet, 21);
+}
+
+void encodeRemoteTemperature(uint8_t* packet, float temperature) {
+    encodeSetHeader(packet, PACKET_LEN);
+
+    packet[5] = 0x07;
+    if (isEncodableTemperature(temperature)) {
+        packet[6] = 0x01;
+        float temp = round(temperature * 2);
+        packet[7] = static_cast<uint8_t>((int)temp - 16);
+        packet[8] = static_cast<uint8_t>((int)temp + 128);
+    } else {
+        packet[8] = 0x80; //MHK1 send 80, even though it could be 00, since ControlByte is 00
+    }
+
+    packet[21] = computeChecksum(packet, 21);
+}
+
+void encodeRunStates(uint8_t* packet, const heatpumpRunStates& wanted) {
+    encodeSetHeader(packet, PACKET_LEN);
+
+    packet[5] = 0x08;
+    if (wanted.airflow_control != nullptr) {
+        ESP_LOGD(ENCODER_TAG, "airflow control -> %s", wanted.airflow_control);
+        int index = lookupByteMapIndex(AIRFLOW_CONTROL_MAP, 3, wanted.airflow_control, "run state (write)");
+        if (index > -1) {
+            packet[11] = AIRFLOW_CONTROL[index];
+            packet[6] += RUN_STATE_PACKET_1[4];
+        }
+    }
+    if (wanted.air_purifier > -1) {
+        ESP_LOGI(ENCODER_TAG, "air purifier switch state -> %s", wanted.air_purifier ? "ON" : "OFF");
+        packet[17] = wanted.air_purifier ? 0x01 : 0x00;
+        packet[7] += RUN_STATE_PACKET_2[1];
+    }
+    if (wanted.night_mode > -1) {
+        ESP_LOGI(ENCODER_TAG, "night mode switch state -> %s", wanted.night_mode ? "ON" : "OFF");
+        packet[18] = wanted.night_mode ? 0x01 : 0x00;
+        packet[7] += RUN_STATE_PACKET_2[2];
+    }
+    if (wanted.circulator > -1) {
+        ESP_LOGI(ENCODER_TAG, "circulator switch state -> %s", wanted.circulator ? "ON" : "OFF");
+        packet[19] = wanted.circulator ? 0x01 : 0x00;
+        packet[7] += RUN_STATE_PACKET_2[3];
+    }
+
+    packet[21] = computeChecksum(packet, 21);
+}
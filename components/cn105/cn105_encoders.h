@@ -0,0 +1,21 @@
+#pragma once
+#include "cn105_protocol.h"
+#include "cn105_types.h"
+
+/**
+ * Builders of the frames sent to the unit: packet must hold PACKET_LEN bytes, the checksum is added.
+*/
+
+// zeroed packet with the info (0x42) or set (0x41) header
+void encodeInfoHeader(uint8_t* packet, int length);
+void encodeSetHeader(uint8_t* packet, int length);
+
+// 0x42 request for the given info code (INFOMODE[RQST_PKT_*])
+void encodeInfoRequest(uint8_t* packet, uint8_t infoCode);
+// 0x41 0x01: only the fields that are set (not nullptr, temperature != -1) are written,
+// values that are not in their *_MAP are ignored
+void encodeSettings(uint8_t* packet, const heatpumpSettings& wanted, bool tempMode, bool wideVaneAdj);
+// 0x41 0x07: remote temperature, 0 or less (or out of range) to go back to the internal sensor
+void encodeRemoteTemperature(uint8_t* packet, float temperature);
+// 0x41 0x08: only the run states that are set (airflow_control not nullptr, switches > -1) are written
+void encodeRunStates(uint8_t* packet, const heatpumpRunStates& wanted);
@@ -0,0 +1,64 @@
+#include "cn105_framer.h"
+#include "cn105_core_log.h"
+
+/**
+ * Seek the byte pointer to the beginning of the frame
+*/
+void cn105Framer::init() {
+    this->foundStart = false;
+    this->bytesRead = 0;
+    this->dataLength = -1;
+    this->command = 0;
+}
+
+/**
+ * The total size of a frame is: header (5 bytes) + data length (header[4]) + checksum (1 byte).
+*/
+bool cn105Framer::push(uint8_t inputData) {
+
+    ESP_LOGV("Decoder", "--> %02X [nb: %d]", inputData, this->bytesRead);
+
+    if (!this->foundStart) {                // no packet yet
+        if (inputData == HEADER[0]) {
+            this->foundStart = true;
+            this->frame[this->bytesRead++] = inputData;
+        }
+        return false;                       // unknown bytes are skipped
+    }
+
+    this->frame[this->bytesRead] = inputData;
+
+    if (this->bytesRead == 4) {             // header is complete
+        if (this->frame[2] == HEADER[2] && this->frame[3] == HEADER[3]) {
+            ESP_LOGV("Header", "[%02X] (%02X) %02X %02X [%02X]<-- header", this->frame[0], this->frame[1], this->frame[2], this->frame[3], this->frame[4]);
+            ESP_LOGD("Header", "command: (%02X) data length: [%02X]<-- header", this->frame[1], this->frame[4]);
+            this->command = this->frame[1];
+        }
+        this->dataLength = this->frame[4];
+        if (this->dataLength > MAX_FRAME_DATA_LEN) {
+            // the length byte cannot be trusted: drop the frame and look for the next start byte
+            ESP_LOGW("Header", "data length %d > %d, frame dropped", this->dataLength, MAX_FRAME_DATA_LEN);
+            this->init();
+            return false;
+        }
+    }
+
+    if ((this->dataLength != -1) && (this->bytesRead == this->dataLength + 5)) {
+        return true;                        // checksum byte received
+    }
+
+    this->bytesRead++;                      // more data to come
+    return false;
+}
+
+bool cn105Framer::isChecksumValid() const {
+    uint8_t packetCheckSum = this->frame[this->bytesRead];
+    uint8_t processedCS = computeChecksum(this->frame, this->dataLength + 5);
+
+    if (packetCheckSum == processedCS) {
+        ESP_LOGD("chkSum", "OK-> %02X=%02X ", processedCS, packetCheckSum);
+    } else {
+        ESP_LOGW("chkSum", "KO-> %02X!=%02X ", processedCS, packetCheckSum);
+    }
+    return (packetCheckSum == processedCS);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "cn105_protocol.h"
+
+/**
+ * Reassembles the CN105 frames from the incoming byte stream:
+ * FC <command> 01 30 <data length> <data...> <checksum>
+*/
+// header (5) + data + checksum (1) must fit in the frame buffer
+static const int MAX_FRAME_DATA_LEN = MAX_DATA_BYTES - 6;
+
+struct cn105Framer {
+    uint8_t frame[MAX_DATA_BYTES];
+    int bytesRead;
+    int dataLength;
+    bool foundStart;
+    uint8_t command;
+
+    void init();
+    // true when the byte completes a frame; the frame stays available until the next init()
+    bool push(uint8_t inputData);
+
+    const uint8_t* getFrame() const { return this->frame; }
+    int getFrameLength() const { return this->bytesRead + 1; }
+    uint8_t getCommand() const { return this->command; }
+    const uint8_t* getData() const { return &this->frame[5]; }
+    int getDataLength() const { return this->dataLength; }
+    bool isChecksumValid() const;
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * CN105 protocol constants and byte maps.
+*/
+
+#define MAX_DATA_BYTES     64         // max number of data bytes in incoming messages
+
+static const int PACKET_LEN = 22;
+static const int PACKET_TYPE_DEFAULT = 99;
+
+static const int CONNECT_LEN = 8;
+static const uint8_t CONNECT[CONNECT_LEN] = { 0xfc, 0x5a, 0x01, 0x30, 0x02, 0xca, 0x01, 0xa8 };
+static const int HEADER_LEN = 8;
+static const uint8_t HEADER[HEADER_LEN] = { 0xfc, 0x41, 0x01, 0x30, 0x10, 0x01, 0x00, 0x00 };
+
+static const int INFOHEADER_LEN = 5;
+static const uint8_t INFOHEADER[INFOHEADER_LEN] = { 0xfc, 0x42, 0x01, 0x30, 0x10 };
+
+
+static const int INFOMODE_LEN = 7;
+static const uint8_t INFOMODE[INFOMODE_LEN] = {
+  0x02, // request a settings packet - RQST_PKT_SETTINGS
+  0x03, // request the current room temp - RQST_PKT_ROOM_TEMP
+  0x04, // unknown
+  0x05, // request the timers - RQST_PKT_TIMERS
+  0x06, // request status - RQST_PKT_STATUS
+  0x09, // request standby mode (maybe?) RQST_PKT_STANDBY
+  0x42  // request HVAC options - RQST_PKT_HVAC_OPTIONS
+};
+
+static const int RCVD_PKT_NONE = -1;
+static const int RCVD_PKT_FAIL = 0;
+static const int RCVD_PKT_CONNECT_SUCCESS = 1;
+static const int RCVD_PKT_SETTINGS = 2;
+static const int RCVD_PKT_ROOM_TEMP = 3;
+static const int RCVD_PKT_UPDATE_SUCCESS = 4;
+static const int RCVD_PKT_STATUS = 5;
+static const int RCVD_PKT_TIMER = 6;
+static const int RCVD_PKT_FUNCTIONS = 7;
+
+static const uint8_t CONTROL_PACKET_1[5] = { 0x01,    0x02,  0x04,  0x08, 0x10 };
+//{"POWER","MODE","TEMP","FAN","VANE"};
+static const uint8_t CONTROL_PACKET_2[1] = { 0x01 };
+//{"WIDEVANE"};
+static const uint8_t RUN_STATE_PACKET_1[5] = { 0x01, 0x04, 0x08, 0x10, 0x20 };
+static const uint8_t RUN_STATE_PACKET_2[5] = { 0x02, 0x04, 0x08, 0x10, 0x20 };
+static const uint8_t POWER[2] = { 0x00, 0x01 };
+static const char* POWER_MAP[2] = { "OFF", "ON" };
+static const uint8_t MODE[5] = { 0x01,   0x02,  0x03, 0x07, 0x08 };
+static const char* MODE_MAP[5] = { "HEAT", "DRY", "COOL", "FAN", "AUTO" };
+static const uint8_t TEMP[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+static const int TEMP_MAP[16] = { 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16 };
+static const uint8_t FAN[6] = { 0x00,  0x01,   0x02, 0x03, 0x05, 0x06 };
+static const char* FAN_MAP[6] = { "AUTO", "QUIET", "1", "2", "3", "4" };
+static const uint8_t VANE[7] = { 0x00,  0x01, 0x02, 0x03, 0x04, 0x05, 0x07 };
+static const char* VANE_MAP[7] = { "AUTO", "↑↑", "↑", "—", "↓", "↓↓", "SWING" };
+static const uint8_t WIDEVANE[8] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x08, 0x0c, 0x00 };
+static const char* WIDEVANE_MAP[8] = { "←←", "←", "|", "→", "→→", "←→", "SWING", "AIRFLOW CONTROL" };
+static const uint8_t ROOM_TEMP[32] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+                                  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f };
+static const int ROOM_TEMP_MAP[32] = { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
+                                  26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41 };
+static const uint8_t TIMER_MODE[4] = { 0x00,  0x01,  0x02, 0x03 };
+static const char* TIMER_MODE_MAP[4] = { "NONE", "OFF", "ON", "BOTH" };
+
+static const uint8_t AIRFLOW_CONTROL[3] = { 0x00, 0x01, 0x02 };
+static const char* AIRFLOW_CONTROL_MAP[3] = { "EVEN", "INDIRECT", "DIRECT" };
+
+//added NET to work with additional data
+static const uint8_t STAGE[7] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+static const char* STAGE_MAP[7] = { "IDLE", "LOW", "GENTLE", "MEDIUM", "MODERATE", "HIGH", "DIFFUSE" };
+
+static const uint8_t SUB_MODE[4] = { 0x00, 0x02, 0x04, 0x08 };
+static const char* SUB_MODE_MAP[4] = { "NORMAL", "DEFROST", "PREHEAT", "STANDBY" };
+static const uint8_t AUTO_SUB_MODE[4] = { 0x00, 0x01, 0x02, 0x03 };
+static const char* AUTO_SUB_MODE_MAP[4] = { "AUTO_OFF","AUTO_COOL", "AUTO_HEAT", "AUTO_LEADER" };
+
+static const int TIMER_INCREMENT_MINUTES = 10;
+
+static const uint8_t FUNCTIONS_SET_PART1 = 0x1F;
+static const uint8_t FUNCTIONS_GET_PART1 = 0x20;
+static const uint8_t FUNCTIONS_SET_PART2 = 0x21;
+static const uint8_t FUNCTIONS_GET_PART2 = 0x22;
+
+
+static const int RQST_PKT_SETTINGS = 0;
+static const int RQST_PKT_ROOM_TEMP = 1;
+static const int RQST_PKT_TIMERS = 3;
+static const int RQST_PKT_STATUS = 4;
+static const int RQST_PKT_STANDBY = 5;
+static const int RQST_PKT_UNKNOWN = 2;
+static const int RQST_PKT_HVAC_OPTIONS = 6;
+
+// byte map lookups: value <-> protocol byte
+const char* lookupByteMapValue(const char* valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo = "", const char* defaultValue = nullptr);
+int lookupByteMapValue(const int valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo = "");
+int lookupByteMapIndex(const char* valuesMap[], int len, const char* lookupValue, const char* debugInfo = "");
+int lookupByteMapIndex(const int valuesMap[], int len, int lookupValue, const char* debugInfo = "");
+
+// (0xfc - sum of the bytes) & 0xff
+uint8_t computeChecksum(const uint8_t bytes[], int len);
@@ -0,0 +1,66 @@
+#include "cn105_scheduler.h"
+#include "cn105_core_log.h"
+
+static const char* SCHEDULER_TAG = "CYCLE";
+
+void cn105Scheduler::init() {
+    this->powerRequestWithoutResponses = 0;     // power request is not supported by all heatpump #112
+}
+
+cycleStep cn105Scheduler::onResponse(uint8_t infoCode, const cycleContext& context) {
+    cycleStep step{ SCHEDULER_NO_REQUEST, false, false, false };
+
+    switch (infoCode) {
+    case 0x02:
+        // next step is to get the room temperature case 0x03
+        ESP_LOGD(SCHEDULER_TAG, "3a: Sending room °C request (0x03)");
+        step.request = RQST_PKT_ROOM_TEMP;
+        break;
+
+    case 0x03:
+        // next step is to get the heatpump extra function status (air purifier, night mode, circulator) case 0x42 if these are enabled in the YAML
+        // or else the heatpump status (operating and compressor frequency) case 0x06
+        if (context.hvacOptionsEnabled) {
+            ESP_LOGD(SCHEDULER_TAG, "3c: Sending HVAC options request (0x42)");
+            step.request = RQST_PKT_HVAC_OPTIONS;
+        } else {
+            ESP_LOGD(SCHEDULER_TAG, "4a: Sending status request (0x06)");
+            step.request = RQST_PKT_STATUS;
+        }
+        break;
+
+    case 0x42:
+        ESP_LOGD(SCHEDULER_TAG, "4a: Sending status request (0x06)");
+        step.request = RQST_PKT_STATUS;
+        break;
+
+    case 0x06:
+        if (!context.cycleRunning) {
+            // out of cycle status: this is the reply to a liveness probe, nothing to chain
+            break;
+        }
+        if ((this->powerRequestWithoutResponses < MAX_POWER_REQUEST_WITHOUT_RESPONSE) &&
+            (!context.standbyUnsupported)) {     // known unsupported units are never asked
+            ESP_LOGD(SCHEDULER_TAG, "5a: Sending power request (0x09)");
+            step.request = RQST_PKT_STANDBY;
+            this->powerRequestWithoutResponses++;
+        } else {
+            // in this case, the cycle ends up now
+            step.standbyGivenUp = !context.standbyUnsupported;
+            step.cycleEnded = true;
+        }
+        break;
+
+    case 0x09:
+        // reset the powerRequestWithoutResponses to 0 as we had a response
+        this->powerRequestWithoutResponses = 0;
+        step.standbyAnswered = true;
+        step.cycleEnded = true;
+        break;
+
+    default:
+        break;
+    }
+
+    return step;
+}
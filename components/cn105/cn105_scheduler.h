@@ -0,0 +1,38 @@
+#pragma once
+#include "cn105_protocol.h"
+
+static const int SCHEDULER_NO_REQUEST = -1;
+
+/**
+ * What the info cycle needs to know about the component and the unit to chain the requests
+*/
+struct cycleContext {
+    bool cycleRunning;              // a 0x06 out of a cycle is the reply to a liveness probe
+    bool hvacOptionsEnabled;        // an air purifier, night mode or circulator switch is configured
+    bool standbyUnsupported;        // the unit is known not to answer 0x09
+};
+
+/**
+ * Next step of the info cycle once a response has been received
+*/
+struct cycleStep {
+    int request;                    // RQST_PKT_* to send next, or SCHEDULER_NO_REQUEST
+    bool cycleEnded;
+    bool standbyAnswered;           // the unit answers 0x09
+    bool standbyGivenUp;            // 0x09 was asked too many times without answer
+};
+
+/**
+ * Chaining of the info requests of a cycle:
+ * 0x02 settings -> 0x03 room °C -> [0x42 HVAC options] -> 0x06 status -> [0x09 stage] -> end
+*/
+struct cn105Scheduler {
+    // nb of unanswered power requests (0x09) after which the unit is deemed not to support it
+    static const int MAX_POWER_REQUEST_WITHOUT_RESPONSE = 3;
+
+    int powerRequestWithoutResponses;
+
+    void init();
+    int firstRequest() const { return RQST_PKT_SETTINGS; }
+    cycleStep onResponse(uint8_t infoCode, const cycleContext& context);
+};
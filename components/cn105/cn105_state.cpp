@@ -0,0 +1,164 @@
+#include "cn105_state.h"
+
+#include <string.h>
+
+static bool sameString(const char* a, const char* b) {
+    if (a == nullptr || b == nullptr) {
+        return a == b;
+    }
+    return strcmp(a, b) == 0;
+}
+
+static bool sameFloat(float a, float b) {
+    return std::isnan(a) ? std::isnan(b) : a == b;
+}
+
+// string fields are only updated with known values: a nullptr received means "not read"
+static uint32_t applyString(const char*& current, const char* received, StateField field) {
+    if (received == nullptr || sameString(current, received)) {
+        return 0;
+    }
+    current = received;
+    return field;
+}
+
+static uint32_t applyFloat(float& current, float received, StateField field) {
+    if (sameFloat(current, received)) {
+        return 0;
+    }
+    current = received;
+    return field;
+}
+
+void cn105State::init() {
+    this->settings = heatpumpSettings{};
+    this->runStates = heatpumpRunStates{};
+    // initialise to all off, then it will update shortly after connect
+    this->status = heatpumpStatus{ 0, 0, false, {TIMER_MODE_MAP[0], 0, 0, 0, 0}, 0, 0, 0, 0 };
+}
+
+uint32_t cn105State::applySettings(const heatpumpSettings& received) {
+    uint32_t changed = 0;
+    changed |= applyString(this->settings.power, received.power, FIELD_POWER);
+    changed |= applyString(this->settings.mode, received.mode, FIELD_MODE);
+    changed |= applyFloat(this->settings.temperature, received.temperature, FIELD_TEMPERATURE);
+    changed |= applyString(this->settings.fan, received.fan, FIELD_FAN);
+    changed |= applyString(this->settings.vane, received.vane, FIELD_VANE);
+    changed |= applyString(this->settings.wideVane, received.wideVane, FIELD_WIDE_VANE);
+    if (this->settings.iSee != received.iSee) {
+        this->settings.iSee = received.iSee;
+        changed |= FIELD_ISEE;
+    }
+    this->settings.connected = received.connected;
+    return changed;
+}
+
+uint32_t cn105State::applyStage(const heatpumpSettings& received) {
+    uint32_t changed = 0;
+    changed |= applyString(this->settings.stage, received.stage, FIELD_STAGE);
+    changed |= applyString(this->settings.sub_mode, received.sub_mode, FIELD_SUB_MODE);
+    changed |= applyString(this->settings.auto_sub_mode, received.auto_sub_mode, FIELD_AUTO_SUB_MODE);
+    return changed;
+}
+
+uint32_t cn105State::applyStatus(const heatpumpStatus& received) {
+    uint32_t changed = 0;
+    changed |= applyFloat(this->status.roomTemperature, received.roomTemperature, FIELD_ROOM_TEMPERATURE);
+    changed |= applyFloat(this->status.outsideAirTemperature, received.outsideAirTemperature, FIELD_OUTSIDE_AIR_TEMPERATURE);
+    if (this->status.operating != received.operating) {
+        this->status.operating = received.operating;
+        changed |= FIELD_OPERATING;
+    }
+    changed |= applyFloat(this->status.compressorFrequency, received.compressorFrequency, FIELD_COMPRESSOR_FREQUENCY);
+    changed |= applyFloat(this->status.inputPower, received.inputPower, FIELD_INPUT_POWER);
+    changed |= applyFloat(this->status.kWh, received.kWh, FIELD_KWH);
+    changed |= applyFloat(this->status.runtimeHours, received.runtimeHours, FIELD_RUNTIME_HOURS);
+    return changed;
+}
+
+uint32_t cn105State::applyRunStates(const heatpumpRunStates& received, uint32_t fields) {
+    uint32_t changed = 0;
+    if ((fields & FIELD_AIR_PURIFIER) && this->runStates.air_purifier != received.air_purifier) {
+        this->runStates.air_purifier = received.air_purifier;
+        changed |= FIELD_AIR_PURIFIER;
+    }
+    if ((fields & FIELD_NIGHT_MODE) && this->runStates.night_mode != received.night_mode) {
+        this->runStates.night_mode = received.night_mode;
+        changed |= FIELD_NIGHT_MODE;
+    }
+    if ((fields & FIELD_CIRCULATOR) && this->runStates.circulator != received.circulator) {
+        this->runStates.circulator = received.circulator;
+        changed |= FIELD_CIRCULATOR;
+    }
+    if (fields & FIELD_AIRFLOW_CONTROL) {
+        changed |= applyString(this->runStates.airflow_control, received.airflow_control, FIELD_AIRFLOW_CONTROL);
+    }
+    return changed;
+}
+
+infoResponse cn105State::decodeInfoResponse(const uint8_t* data, const decodeOptions& options) const {
+    infoResponse response{};
+    response.code = data[0];
+    response.known = true;
+    response.status = this->status;
+    switch (response.code) {
+    case 0x02:
+        response.settings = decodeSettings(data, options);
+        response.runStates.airflow_control = response.settings.airflowControl;
+        break;
+    case 0x03:
+        decodeRoomTemperature(data, options, response.status);
+        break;
+    case 0x06:
+        decodeStatus(data, response.status);
+        break;
+    case 0x09:
+        decodeStage(data, response.stage);
+        break;
+    case 0x42:
+        decodeHVACOptions(data, response.runStates);
+        break;
+    case 0x20:          // functions: not part of the state model
+    case 0x22:
+        break;
+    default:
+        response.known = false;
+        break;
+    }
+    return response;
+}
+
+/**
+ * The settings of a 0x02 response are left to the caller: the component holds back the ones
+ * the user is changing (CN105Climate::heatpumpUpdate()), the host tools call applySettings().
+*/
+uint32_t cn105State::applyInfoResponse(const infoResponse& response, uint32_t runStateFields) {
+    switch (response.code) {
+    case 0x02:
+        return this->applyRunStates(response.runStates, runStateFields & FIELD_AIRFLOW_CONTROL);
+    case 0x03:
+    case 0x06:
+        return this->applyStatus(response.status);
+    case 0x09:
+        return this->applyStage(response.stage);
+    case 0x42:
+        return this->applyRunStates(response.runStates, runStateFields & (FIELD_AIR_PURIFIER | FIELD_NIGHT_MODE | FIELD_CIRCULATOR));
+    default:
+        return 0;
+    }
+}
+
+const char* cn105State::getFieldName(StateField field) {
+    static const char* FIELD_NAMES[STATE_FIELD_COUNT] = {
+        "power", "mode", "target_temperature", "fan", "vane", "wide_vane", "isee",
+        "stage", "sub_mode", "auto_sub_mode",
+        "current_temperature", "outside_air_temperature", "operating", "compressor_frequency", "input_power", "kwh", "runtime_hours",
+        "air_purifier", "night_mode", "circulator", "airflow_control"
+    };
+    for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+        if (field == (1UL << i)) {
+            return FIELD_NAMES[i];
+        }
+    }
+    return "?";
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "cn105_decoders.h"
+
+/**
+ * Fields of the state model, as bits of the change masks returned by cn105State::apply*()
+*/
+enum StateField : uint32_t {
+    FIELD_POWER = 1UL << 0,
+    FIELD_MODE = 1UL << 1,
+    FIELD_TEMPERATURE = 1UL << 2,
+    FIELD_FAN = 1UL << 3,
+    FIELD_VANE = 1UL << 4,
+    FIELD_WIDE_VANE = 1UL << 5,
+    FIELD_ISEE = 1UL << 6,
+    FIELD_STAGE = 1UL << 7,
+    FIELD_SUB_MODE = 1UL << 8,
+    FIELD_AUTO_SUB_MODE = 1UL << 9,
+    FIELD_ROOM_TEMPERATURE = 1UL << 10,
+    FIELD_OUTSIDE_AIR_TEMPERATURE = 1UL << 11,
+    FIELD_OPERATING = 1UL << 12,
+    FIELD_COMPRESSOR_FREQUENCY = 1UL << 13,
+    FIELD_INPUT_POWER = 1UL << 14,
+    FIELD_KWH = 1UL << 15,
+    FIELD_RUNTIME_HOURS = 1UL << 16,
+    FIELD_AIR_PURIFIER = 1UL << 17,
+    FIELD_NIGHT_MODE = 1UL << 18,
+    FIELD_CIRCULATOR = 1UL << 19,
+    FIELD_AIRFLOW_CONTROL = 1UL << 20,
+};
+static const int STATE_FIELD_COUNT = 21;
+
+static const uint32_t FIELDS_STATUS = FIELD_ROOM_TEMPERATURE | FIELD_OUTSIDE_AIR_TEMPERATURE | FIELD_OPERATING |
+FIELD_COMPRESSOR_FREQUENCY | FIELD_INPUT_POWER | FIELD_KWH | FIELD_RUNTIME_HOURS;
+static const uint32_t FIELDS_RUN_STATES = FIELD_AIR_PURIFIER | FIELD_NIGHT_MODE | FIELD_CIRCULATOR | FIELD_AIRFLOW_CONTROL;
+
+/**
+ * A 0x62 info response decoded by cn105State::decodeInfoResponse(); only the part of its info code is filled
+*/
+struct infoResponse {
+    uint8_t code;
+    bool known;                     // false for the info codes that are not decoded
+    settingsDecoded settings;       // 0x02
+    heatpumpStatus status;          // 0x03, 0x06: the current status with the received fields
+    heatpumpSettings stage;         // 0x09: stage, sub_mode and auto_sub_mode
+    heatpumpRunStates runStates;    // 0x42, and the airflow control of 0x02
+};
+
+/**
+ * Last known state of the heatpump, as read from the unit.
+ * Strings point to the *_MAP entries and are compared with strcmp.
+ * The apply*() methods store the received values and return the mask of the fields that changed,
+ * the caller decides what has to be published.
+*/
+struct cn105State {
+    heatpumpSettings settings;
+    heatpumpStatus status;
+    heatpumpRunStates runStates;
+
+    void init();
+
+    uint32_t applySettings(const heatpumpSettings& received);
+    uint32_t applyStage(const heatpumpSettings& received);
+    uint32_t applyStatus(const heatpumpStatus& received);
+    // only the given run state fields are considered (the others may not be read from this unit)
+    uint32_t applyRunStates(const heatpumpRunStates& received, uint32_t fields);
+
+    // decodes a 0x62 response, against the current status (0x03 and 0x06 only carry part of it)
+    infoResponse decodeInfoResponse(const uint8_t* data, const decodeOptions& options) const;
+    // stores a decoded response, except the settings of 0x02 (see applySettings()); returns the mask of the fields that changed
+    uint32_t applyInfoResponse(const infoResponse& response, uint32_t runStateFields = FIELDS_RUN_STATES);
+
+    static const char* getFieldName(StateField field);
+};
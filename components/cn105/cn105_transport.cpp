@@ -0,0 +1,29 @@
+#include "cn105_transport.h"
+
+void latencyStats::add(uint32_t ms) {
+    this->last = ms;
+    if (this->count == 0) {
+        this->avg = ms;
+        this->min = ms;
+        this->max = ms;
+    } else {
+        this->avg = (this->avg * 7 + ms + 4) / 8;
+        if (ms < this->min) {
+            this->min = ms;
+        }
+        if (ms > this->max) {
+            this->max = ms;
+        }
+    }
+    this->count++;
+}
+
+/**
+ * 22 bytes at 2400 bauds 8E1 (11 bits per byte) take about 100 ms
+*/
+uint32_t computeFrameDurationMs(int length, uint32_t baudRate, uint32_t bitsPerByte) {
+    if (baudRate == 0) {
+        return 0;
+    }
+    return (length * bitsPerByte * 1000 + baudRate - 1) / baudRate;
+}
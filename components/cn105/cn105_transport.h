@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * Min/avg/max of a delay in ms; the average is a moving one (1/8 of each new sample),
+ * so it follows a link whose latency changes.
+*/
+struct latencyStats {
+    uint32_t last = 0;
+    uint32_t avg = 0;
+    uint32_t min = 0;
+    uint32_t max = 0;
+    uint32_t count = 0;
+
+    void add(uint32_t ms);
+};
+
+enum class TransportEvent : uint8_t {
+    NONE,
+    UP,                     // a connection in progress succeeded
+    DOWN,                   // the link was lost
+};
+
+/**
+ * Byte link between the component and the CN105 connector: the UART of the ESP (uartTransport),
+ * or a serial to TCP bridge plugged into the unit (tcpTransport). The component only frames,
+ * paces and times what goes through it.
+*/
+struct cn105Transport {
+    virtual ~cn105Transport() = default;
+
+    virtual const char* getName() = 0;
+    // true when bytes can be exchanged now; a connection that takes time is reported by poll()
+    virtual bool open() = 0;
+    virtual void close() {}
+    // from loop(): completes a connection in progress, detects a lost one
+    virtual TransportEvent poll() { return TransportEvent::NONE; }
+
+    virtual int available() = 0;
+    virtual bool readByte(uint8_t* data) = 0;
+    virtual void write(const uint8_t* data, int length) = 0;
+
+    // time the frame takes on the serial line of the unit
+    virtual uint32_t getFrameDurationMs(int length) = 0;
+    // round trip of the transport itself, the unit excluded (0 for a local UART)
+    virtual uint32_t getRttMs() { return 0; }
+    virtual void logStats() {}
+};
+
+// bits of a byte on the wire: start bit + data bits + parity bit + stop bits
+uint32_t computeFrameDurationMs(int length, uint32_t baudRate, uint32_t bitsPerByte);
@@ -0,0 +1,230 @@
+#pragma once
+#include <stdint.h>
+#include <cmath>
+#include <cstring>
+
+/**
+ * State model of the heatpump: settings, status and run states as decoded from the CN105 frames.
+*/
+
+struct heatpumpSettings {
+    const char* power;
+    const char* mode;
+    float temperature;
+    const char* fan;
+    const char* vane; //vertical vane, up/down
+    const char* wideVane; //horizontal vane, left/right
+    bool iSee;   //iSee sensor, at the moment can only detect it, not set it
+    bool connected;
+    const char* stage;
+    const char* sub_mode;
+    const char* auto_sub_mode;
+
+    void resetSettings() {
+        power = nullptr;
+        mode = nullptr;
+        temperature = -1.0f;
+        fan = nullptr;
+        vane = nullptr;
+        wideVane = nullptr;
+    }
+
+    heatpumpSettings() = default;
+    heatpumpSettings(const heatpumpSettings& other) = default;
+
+    heatpumpSettings& operator=(const heatpumpSettings& other) {
+        if (this != &other) { // protection contre l'auto-affectation
+            power = other.power;
+            mode = other.mode;
+            temperature = other.temperature;
+            fan = other.fan;
+            vane = other.vane;
+            wideVane = other.wideVane;
+            iSee = other.iSee;
+            connected = other.connected;
+            stage = other.stage;
+            sub_mode = other.sub_mode;
+            auto_sub_mode = other.auto_sub_mode;
+        }
+        return *this;
+    }
+
+
+    // by value: a restored setting may not point to the same map entry as a decoded one
+    static bool isSameValue(const char* a, const char* b) {
+        return (a == nullptr || b == nullptr) ? a == b : strcmp(a, b) == 0;
+    }
+
+    bool operator==(const heatpumpSettings& other) const {
+        return isSameValue(power, other.power) &&
+            isSameValue(mode, other.mode) &&
+            temperature == other.temperature &&
+            isSameValue(fan, other.fan) &&
+            isSameValue(vane, other.vane) &&
+            isSameValue(wideVane, other.wideVane);
+        //iSee == other.iSee;
+    }
+
+    bool operator!=(const heatpumpSettings& other) {
+        return !(this->operator==(other));
+    }
+
+};
+
+struct wantedHeatpumpSettings : heatpumpSettings {
+    bool hasChanged;
+    bool hasBeenSent;
+    uint8_t nb_deffered_requests;
+    uint32_t lastChange;
+
+    void resetSettings() {
+        heatpumpSettings::resetSettings();
+
+        hasChanged = false;
+        hasBeenSent = false;
+        //nb_deffered_requests = 0;
+        //lastChange = 0;
+    }
+
+    wantedHeatpumpSettings& operator=(const wantedHeatpumpSettings& other) {
+        if (this != &other) { // self-assignment protection
+            heatpumpSettings::operator=(other); // Appel à l'opérateur d'affectation de la classe de base
+            hasChanged = other.hasChanged;
+            hasBeenSent = other.hasBeenSent;
+        }
+        return *this;
+    }
+
+    wantedHeatpumpSettings& operator=(const heatpumpSettings& other) {
+        if (this != &other) { // self-assignment protection
+            heatpumpSettings::operator=(other); // Copie des membres de base
+        }
+        return *this;
+    }
+};
+
+struct heatpumpTimers {
+    const char* mode;
+    int onMinutesSet;
+    int onMinutesRemaining;
+    int offMinutesSet;
+    int offMinutesRemaining;
+
+    heatpumpTimers& operator=(const heatpumpTimers& other) {
+        if (this != &other) { // protection contre l'auto-affectation
+            mode = other.mode;
+            onMinutesSet = other.onMinutesSet;
+            onMinutesRemaining = other.onMinutesRemaining;
+            offMinutesSet = other.offMinutesSet;
+            offMinutesRemaining = other.offMinutesRemaining;
+        }
+        return *this;
+    }
+    bool operator==(const heatpumpTimers& other) const {
+        return
+            mode == other.mode &&
+            onMinutesSet == other.onMinutesSet &&
+            onMinutesRemaining == other.onMinutesRemaining &&
+            offMinutesSet == other.offMinutesSet &&
+            offMinutesRemaining == other.offMinutesRemaining;
+    }
+
+
+    bool operator!=(const heatpumpTimers& other) const {
+        return !(this->operator==(other));
+    }
+};
+
+
+struct heatpumpStatus {
+    float roomTemperature;
+    float outsideAirTemperature;
+    bool operating; // if true, the heatpump is operating to reach the desired temperature
+    heatpumpTimers timers;
+    float compressorFrequency;
+    float inputPower;
+    float kWh;
+    float runtimeHours;
+
+    bool operator==(const heatpumpStatus& other) const {
+        return (std::isnan(roomTemperature) ? std::isnan(other.roomTemperature) : roomTemperature == other.roomTemperature) &&
+            (std::isnan(outsideAirTemperature) ? std::isnan(other.outsideAirTemperature) : outsideAirTemperature == other.outsideAirTemperature) &&
+            operating == other.operating &&
+            //timers == other.timers &&  // Assurez-vous que l'opérateur == est également défini pour heatpumpTimers
+            compressorFrequency == other.compressorFrequency &&
+            inputPower == other.inputPower &&
+            kWh == other.kWh &&
+            runtimeHours == other.runtimeHours;
+    }
+
+    bool operator!=(const heatpumpStatus& other) const {
+        return !(*this == other);
+    }
+};
+
+struct heatpumpRunStates {
+    int8_t air_purifier;
+    int8_t night_mode;
+    int8_t circulator;
+    const char* airflow_control;
+    
+    void resetSettings() {
+        air_purifier = -1;
+        night_mode = -1;
+        circulator = -1;
+        airflow_control = nullptr;
+    }
+    
+    heatpumpRunStates() = default;
+    heatpumpRunStates(const heatpumpRunStates& other) = default;
+
+    heatpumpRunStates& operator=(const heatpumpRunStates& other) {
+        if (this != &other) {
+            air_purifier = other.air_purifier;
+            night_mode = other.night_mode;
+            circulator = other.circulator;
+            airflow_control = other.airflow_control;
+        }
+        return *this;
+    }
+    
+    bool operator==(const heatpumpRunStates& other) const {
+        return air_purifier == other.air_purifier &&
+            night_mode == other.night_mode &&
+            circulator == other.circulator &&
+            airflow_control == other.airflow_control;
+    }
+    
+    bool operator!=(const heatpumpRunStates& other) {
+        return !(this->operator==(other));
+    }
+};
+
+struct wantedHeatpumpRunStates : heatpumpRunStates {
+    bool hasChanged;
+    bool hasBeenSent;
+    uint32_t lastChange;
+    
+    void resetSettings() {
+        heatpumpRunStates::resetSettings();
+        
+        hasChanged = false;
+        hasBeenSent = false;
+    }
+    
+    wantedHeatpumpRunStates& operator=(const wantedHeatpumpRunStates& other) {
+        if (this != &other) {
+            heatpumpRunStates::operator=(other);
+            hasChanged = other.hasChanged;
+            hasBeenSent = other.hasBeenSent;
+        }
+        return *this;
+    }
+    
+    wantedHeatpumpRunStates& operator=(const heatpumpRunStates& other) {
+        if (this != &other) {
+            heatpumpRunStates::operator=(other);
+        }
+        return *this;
+    }
+};
@@ -17,8 +17,8 @@ void CN105Climate::setup() {
 
     this->fan_mode = climate::CLIMATE_FAN_OFF;
     this->swing_mode = climate::CLIMATE_SWING_OFF;
-    this->initBytePointer();
-    this->lastResponseMs = CUSTOM_MILLIS;
+    this->framer.init();
+    this->lastResponseMs = cn105Millis();
 
     // initialize diagnostic stats
     this->nbCompleteCycles_ = 0;
@@ -31,6 +31,9 @@ void CN105Climate::setup() {
     //ESP_LOGI(TAG, "debounce_delay is set to %lu", this->debounce_delay_);
     log_info_uint32(TAG, "debounce_delay is set to ", this->debounce_delay_);
 
+    this->loadCapabilities();
+    this->restoreSnapshot();
+
     this->setupUART();
     this->sendFirstConnectionPacket();
 }
@@ -41,7 +44,10 @@ void CN105Climate::setup() {
  * This function is called repeatedly in the main program loop.
  */
 void CN105Climate::loop() {
+    this->processTransport();                                               // TCP connections made or lost
+    this->processTxQueue();                                                 // frames waiting for the link
     if (!this->processInput()) {                                            // if we don't get any input: no read op
+        this->checkConnectionAttempt();                                     // non blocking (re)connection with backoff
         if ((this->wantedSettings.hasChanged) && (!this->loopCycle.isCycleRunning())) {
             this->checkPendingWantedSettings();
         } else if ((this->wantedRunStates.hasChanged) && (!this->loopCycle.isCycleRunning())) {
@@ -50,12 +56,16 @@ void CN105Climate::loop() {
             if (this->loopCycle.isCycleRunning()) {                         // if we are  running an update cycle
                 this->loopCycle.checkTimeout(this->update_interval_);
             } else { // we are not running a cycle
-                if (this->loopCycle.hasUpdateIntervalPassed(this->get_update_interval())) {
+                // not while a liveness probe (0x06) is outstanding: its reply would be taken for a step of the cycle
+                if (this->loopCycle.hasUpdateIntervalPassed(this->get_update_interval()) &&
+                    !this->liveness.probePending && !this->isTcpBridgeBusy()) {
                     this->buildAndSendRequestsInfoPackets();            // initiate an update cycle with this->cycleStarted();
                 }
             }
         }
+        this->checkLiveness();                                              // short probe, independent of update_interval
     }
+    this->processTcpBridge();                                               // frames of the tcp bridge client, in the gaps
 }
 
 uint32_t CN105Climate::get_update_interval() const { return this->update_interval_; }
@@ -0,0 +1,96 @@
+#include "connection_management.h"
+#include "cn105_clock.h"
+#include "cn105_core_log.h"
+
+#include <algorithm>
+
+#ifdef CN105_HOST_BUILD
+#include <stdlib.h>
+#else
+#include "esphome/core/helpers.h"
+#endif
+
+static const char* CONNECTION_TAG = "CN105";
+
+static uint32_t randomUint32() {
+#ifdef CN105_HOST_BUILD
+    return (uint32_t)rand();
+#else
+    return esphome::random_uint32();
+#endif
+}
+
+void connectionManagement::init() {
+    attempt = 0;
+    currentDelayMs = 0;
+    bootMs = cn105Millis();
+    lastAttemptMs = bootMs;
+    lastSuccessMs = bootMs;
+    hasSucceeded = false;
+}
+
+/**
+ * lastResponseMs: the last frame of the unit; the outage began there, not when it was detected
+ * (after the missed liveness probes)
+*/
+void connectionManagement::connectionLost(uint32_t lastResponseMs) {
+    ESP_LOGI(CONNECTION_TAG, "connection lost, reconnecting...");
+    attempt = 0;
+    currentDelayMs = 0;                     // first attempt of an outage is immediate
+    lastAttemptMs = cn105Millis();
+    lostMs = lastResponseMs;
+}
+
+void connectionManagement::attemptStarted() {
+    attempt++;
+    lastAttemptMs = cn105Millis();
+    currentDelayMs = computeBackoffDelay();
+    ESP_LOGI(CONNECTION_TAG, "connection attempt %u", (unsigned int)attempt);
+    ESP_LOGD(CONNECTION_TAG, "next connection attempt in %u ms", (unsigned int)currentDelayMs);
+}
+
+void connectionManagement::connectionSucceeded() {
+    attempt = 0;
+    currentDelayMs = 0;
+    lastSuccessMs = cn105Millis();
+    hasSucceeded = true;
+}
+
+bool connectionManagement::isAttemptDue() {
+    return elapsedMs(cn105Millis(), lastAttemptMs) >= currentDelayMs;
+}
+
+uint32_t connectionManagement::getAttempt() {
+    return attempt;
+}
+
+/**
+ * ms since the last successful connection (since init() if it never succeeded)
+*/
+uint32_t connectionManagement::getTimeSinceLastSuccess() {
+    return elapsedMs(cn105Millis(), lastSuccessMs);
+}
+
+/**
+ * ms since the last frame of the unit before the connection was lost (since init() if it was never established)
+*/
+uint32_t connectionManagement::getOutageDuration() {
+    return elapsedMs(cn105Millis(), hasSucceeded ? lostMs : bootMs);
+}
+
+/**
+ * CONNECT_RETRY_FIRST_MS * 2^(attempt-1), capped to CONNECT_RETRY_MAX_MS,
+ * then shifted by a random jitter of +/- CONNECT_RETRY_JITTER_PERCENT
+*/
+uint32_t connectionManagement::computeBackoffDelay() {
+    uint32_t delay = CONNECT_RETRY_MAX_MS;
+    if (attempt > 0 && attempt <= 16) {
+        delay = std::min(CONNECT_RETRY_FIRST_MS << (attempt - 1), CONNECT_RETRY_MAX_MS);
+    }
+
+    uint32_t jitterRange = delay * CONNECT_RETRY_JITTER_PERCENT / 100;
+    if (jitterRange > 0) {
+        delay = delay - jitterRange + (randomUint32() % (2 * jitterRange + 1));
+    }
+    return delay;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+
+// reconnection backoff: quick first retry, then doubling up to a cap, with a random jitter
+static const uint32_t CONNECT_RETRY_FIRST_MS = 2000;
+static const uint32_t CONNECT_RETRY_MAX_MS = 60000;
+static const uint32_t CONNECT_RETRY_JITTER_PERCENT = 20;
+
+// a reconnection after an outage shorter than this keeps the last known state (warm reconnect)
+static const uint32_t WARM_RECONNECT_MAX_OUTAGE_MS = 300000;
+
+/**
+ * Reconnection pacing, used while the link state machine is UART_DOWN or CONNECTING.
+ * The first attempt of an outage is immediate, the next ones are spaced by an exponential
+ * backoff (with jitter) up to a cap. It is ticked from loop(), never from a scheduler callback.
+ * Time comes from cn105Millis().
+*/
+struct connectionManagement {
+
+    uint32_t attempt = 0;                   // nb of connection attempts since the last success
+    uint32_t currentDelayMs = 0;            // delay before the next attempt
+    uint32_t lastAttemptMs = 0;
+    uint32_t lastSuccessMs = 0;
+    uint32_t lostMs = 0;                    // last frame of the unit before the outage
+    uint32_t bootMs = 0;                    // outages before the first connection count from init()
+    bool hasSucceeded = false;
+
+    void init();
+    void connectionLost(uint32_t lastResponseMs);
+    void attemptStarted();
+    void connectionSucceeded();
+    bool isAttemptDue();
+    uint32_t getAttempt();
+    uint32_t getTimeSinceLastSuccess();
+    uint32_t getOutageDuration();
+    uint32_t computeBackoffDelay();
+
+};
@@ -1,12 +1,12 @@
 #include "cycle_management.h"
-#include "cn105.h"
-#include "Globals.h"
+#include "cn105_clock.h"
+#include "cn105_core_log.h"
 
-using namespace esphome;
+static const char* CYCLE_TAG = "CYCLE";
 
-void cycleManagement::checkTimeout(unsigned int update_interval) {
-    if (doesCycleTimeOut(update_interval)) {                          // does it last too long ?                    
-        ESP_LOGW(TAG, "Cycle timeout, reseting cycle...");
+void cycleManagement::checkTimeout(uint32_t update_interval) {
+    if (doesCycleTimeOut(update_interval)) {                          // does it last too long ?
+        ESP_LOGW(CYCLE_TAG, "Cycle timeout, reseting cycle...");
         cycleEnded(true);
     }
 }
@@ -18,48 +18,50 @@ bool cycleManagement::isCycleRunning() {
 
 void cycleManagement::init() {
     cycleRunning = false;
-    lastCompleteCycleMs = CUSTOM_MILLIS;
+    lastCompleteCycleMs = cn105Millis();
 }
 
 void cycleManagement::deferCycle() {
 
-#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
+#if defined(ESPHOME_LOG_LEVEL) && ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
     uint32_t delay = DEFER_SCHEDULE_UPDATE_LOOP_DELAY * 2;
 #else
     uint32_t delay = DEFER_SCHEDULE_UPDATE_LOOP_DELAY;
 #endif
 
-    //ESP_LOGI(LOG_CYCLE_TAG, "Defering cycle trigger of %lu ms", delay);
-    log_info_uint32(LOG_CYCLE_TAG, "Defering cycle trigger of  ", delay, " ms");
+    ESP_LOGI(CYCLE_TAG, "Defering cycle trigger of %u ms", (unsigned int)delay);
     // forces the lastCompleteCycle offset of delay ms to allow a longer rest time
-    lastCompleteCycleMs = CUSTOM_MILLIS + delay;
+    lastCompleteCycleMs = cn105Millis() + delay;
 
 }
 void cycleManagement::cycleStarted() {
-    ESP_LOGI(LOG_CYCLE_TAG, "1: Cycle start");
-    lastCycleStartMs = CUSTOM_MILLIS;
+    ESP_LOGI(CYCLE_TAG, "1: Cycle start");
+    lastCycleStartMs = cn105Millis();
     cycleRunning = true;
 }
 
 void cycleManagement::cycleEnded(bool timedOut) {
     cycleRunning = false;
+    uint32_t now = cn105Millis();
 
-    if (lastCompleteCycleMs < CUSTOM_MILLIS) {    // we check this because of defering mecanism
+    if (isTimeReached(now, lastCompleteCycleMs)) {      // we check this because of defering mecanism
         // a complete cycle is done
-        lastCompleteCycleMs = CUSTOM_MILLIS;      // to prevent next inteval from ticking too soon
+        lastCompleteCycleMs = now;                      // to prevent next inteval from ticking too soon
     }
 
-    ESP_LOGI(LOG_CYCLE_TAG, "6: Cycle ended in %.1f seconds (with timeout?: %s)",
-        (lastCompleteCycleMs - lastCycleStartMs) / 1000.0, timedOut ? "YES" : " NO");
+    ESP_LOGI(CYCLE_TAG, "6: Cycle ended in %.1f seconds (with timeout?: %s)",
+        (int32_t)(lastCompleteCycleMs - lastCycleStartMs) / 1000.0, timedOut ? "YES" : " NO");
 
 }
 
-bool cycleManagement::hasUpdateIntervalPassed(unsigned int update_interval) {
-    if (CUSTOM_MILLIS < lastCompleteCycleMs) return false;      // must be checked because operands are they are unsigned
-    return (CUSTOM_MILLIS - lastCompleteCycleMs) > update_interval;
+// the differences are signed: a deferred lastCompleteCycleMs is ahead of the clock, and the
+// unsigned comparisons used before stalled the cycles for 49.7 days after the ms counter wrapped
+bool cycleManagement::hasUpdateIntervalPassed(uint32_t update_interval) {
+    uint32_t now = cn105Millis();
+    return isTimeReached(now, lastCompleteCycleMs) && elapsedMs(now, lastCompleteCycleMs) > update_interval;
 }
 
-bool cycleManagement::doesCycleTimeOut(unsigned int update_interval) {
-    if (CUSTOM_MILLIS < lastCycleStartMs) return false;         // must be checked because operands are they are unsigned
-    return (CUSTOM_MILLIS - lastCycleStartMs) > (2 * update_interval) + 1000;
+bool cycleManagement::doesCycleTimeOut(uint32_t update_interval) {
+    uint32_t now = cn105Millis();
+    return isTimeReached(now, lastCycleStartMs) && elapsedMs(now, lastCycleStartMs) > (2 * update_interval) + 1000;
 }
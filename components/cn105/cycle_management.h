@@ -1,18 +1,26 @@
 #pragma once
+#include <stdint.h>
 
+// defering delay for update_interval when we've just sent a wentedSettings
+static const uint32_t DEFER_SCHEDULE_UPDATE_LOOP_DELAY = 750;
+
+/**
+ * Pacing of the info cycles, on cn105Millis() (cn105_clock.h).
+ * lastCompleteCycleMs may be in the future when a cycle is deferred.
+*/
 struct cycleManagement {
 
     bool cycleRunning = false;
-    unsigned long lastCycleStartMs = 0;
-    unsigned long lastCompleteCycleMs = 0;
+    uint32_t lastCycleStartMs = 0;
+    uint32_t lastCompleteCycleMs = 0;
 
     void init();
     void cycleStarted();
     void cycleEnded(bool timedOut = false);
-    bool hasUpdateIntervalPassed(unsigned int update_interval);
-    bool doesCycleTimeOut(unsigned int update_interval);
+    bool hasUpdateIntervalPassed(uint32_t update_interval);
+    bool doesCycleTimeOut(uint32_t update_interval);
     bool isCycleRunning();
     void deferCycle();
-    void checkTimeout(unsigned int update_interval);
+    void checkTimeout(uint32_t update_interval);
 
-};
\ No newline at end of file
+};
@@ -27,7 +27,7 @@ void CN105Climate::set_vertical_vane_select(
         this->setVaneSetting(setting);
         this->wantedSettings.hasChanged = true;
         this->wantedSettings.hasBeenSent = false;
-        this->wantedSettings.lastChange = CUSTOM_MILLIS;
+        this->wantedSettings.lastChange = cn105Millis();
         });
 
 }
@@ -46,7 +46,7 @@ void CN105Climate::set_horizontal_vane_select(
         this->setWideVaneSetting(setting);
         this->wantedSettings.hasChanged = true;
         this->wantedSettings.hasBeenSent = false;
-        this->wantedSettings.lastChange = CUSTOM_MILLIS;
+        this->wantedSettings.lastChange = cn105Millis();
     });
 
 }
@@ -59,15 +59,15 @@ void CN105Climate::set_airflow_control_select(
     this->airflow_control_select_->traits.set_options(airflowControlOptions);
     
     this->airflow_control_select_->setCallbackFunction([this](const char* setting) {
-        if (strcmp(this->currentSettings.wideVane, lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, 0x80 & 0x0F)) == 0) {
+        if (strcmp(this->hpState.settings.wideVane, lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, 0x80 & 0x0F)) == 0) {
             ESP_LOGD("EVT", "airFlow -> Request for change of airflow control setting: %s", setting);
 
             this->setAirflowControlSetting(setting);
             this->wantedRunStates.hasChanged = true;
             this->wantedRunStates.hasBeenSent = false;
-            this->wantedRunStates.lastChange = CUSTOM_MILLIS;
+            this->wantedRunStates.lastChange = cn105Millis();
         } else {
-            this->airflow_control_select_->publish_state(this->currentRunStates.airflow_control);
+            this->airflow_control_select_->publish_state(this->hpState.runStates.airflow_control);
         }
     });
 }
@@ -123,6 +123,20 @@ void CN105Climate::set_functions_get_button(FunctionsButton* Button) {
         });
 }
 
+void CN105Climate::set_packet_trace_button(FunctionsButton* Button) {
+    this->packet_trace_button_ = Button;
+    this->packet_trace_button_->setCallbackFunction([this]() {
+        this->dumpPacketTrace();
+        });
+}
+
+void CN105Climate::set_capabilities_reset_button(FunctionsButton* Button) {
+    this->capabilities_reset_button_ = Button;
+    this->capabilities_reset_button_->setCallbackFunction([this]() {
+        this->resetCapabilities();
+        });
+}
+
 void CN105Climate::set_functions_set_button(FunctionsButton* Button) {
     this->Functions_set_button_ = Button;
     this->Functions_set_button_->setCallbackFunction([this]() {
@@ -166,7 +180,7 @@ void CN105Climate::set_air_purifier_switch(HVACOptionSwitch* Switch) {
         
         this->wantedRunStates.hasChanged = true;
         this->wantedRunStates.hasBeenSent = false;
-        this->wantedRunStates.lastChange = CUSTOM_MILLIS;
+        this->wantedRunStates.lastChange = cn105Millis();
     });
 }
 
@@ -177,7 +191,7 @@ void CN105Climate::set_night_mode_switch(HVACOptionSwitch* Switch) {
         
         this->wantedRunStates.hasChanged = true;
         this->wantedRunStates.hasBeenSent = false;
-        this->wantedRunStates.lastChange = CUSTOM_MILLIS;
+        this->wantedRunStates.lastChange = cn105Millis();
     });
 }
 
@@ -188,7 +202,7 @@ void CN105Climate::set_circulator_switch(HVACOptionSwitch* Switch) { // only in
         
         this->wantedRunStates.hasChanged = true;
         this->wantedRunStates.hasBeenSent = false;
-        this->wantedRunStates.lastChange = CUSTOM_MILLIS;
+        this->wantedRunStates.lastChange = cn105Millis();
     });
 }
 
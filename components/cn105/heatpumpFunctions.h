@@ -1,7 +1,10 @@
 #pragma once
-#include "Globals.h"
-
+#include <stdint.h>
 
+/**
+ * Function settings of the unit (codes 101..128, values 1..3), carried by the 0x20/0x22 responses
+ * and the 0x1F/0x21 set packets.
+*/
 
 #define MAX_FUNCTION_CODE_COUNT 30
 
@@ -28,8 +31,8 @@ public:
     bool isValid() const;
 
     // data must be 15 bytes
-    void setData1(uint8_t* data);
-    void setData2(uint8_t* data);
+    void setData1(const uint8_t* data);
+    void setData2(const uint8_t* data);
     void getData1(uint8_t* data) const;
     void getData2(uint8_t* data) const;
 
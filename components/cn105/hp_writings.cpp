@@ -3,42 +3,31 @@
 using namespace esphome;
 
 uint8_t CN105Climate::checkSum(uint8_t bytes[], int len) {
-    uint8_t sum = 0;
-    for (int i = 0; i < len; i++) {
-        sum += bytes[i];
-    }
-    return (0xfc - sum) & 0xff;
+    return computeChecksum(bytes, len);
 }
 
 
+/**
+ * One connection attempt. It never blocks nor re-schedules itself: the next attempt,
+ * if the heatpump does not reply, is fired by checkConnectionAttempt() from loop().
+*/
 void CN105Climate::sendFirstConnectionPacket() {
+    this->connection.attemptStarted();
+
     if (this->isUARTConnected_) {
-        this->lastReconnectTimeMs = CUSTOM_MILLIS;          // marker to prevent to many reconnections
-        this->setHeatpumpConnected(false);
         ESP_LOGD(TAG, "Envoi du packet de connexion...");
         uint8_t packet[CONNECT_LEN];
         memcpy(packet, CONNECT, CONNECT_LEN);
         //for(int count = 0; count < 2; count++) {
 
-        this->writePacket(packet, CONNECT_LEN, false);      // checkIsActive=false because it's the first packet and we don't have any reply yet
+        // checkIsActive=false because it's the first packet and we don't have any reply yet
+        this->connectTxHandle = this->writePacket(packet, CONNECT_LEN, false, TxPriority::PRIO_HIGH);
 
-        this->lastSend = CUSTOM_MILLIS;
-        this->lastConnectRqTimeMs = CUSTOM_MILLIS;
         this->nbHeatpumpConnections_++;
 
-        // we wait for a 10s timeout to check if the hp has replied to connection packet
-        this->set_timeout("checkFirstConnection", 10000, [this]() {
-            if (!this->isHeatpumpConnected_) {
-                ESP_LOGE(TAG, "--> Heatpump did not reply: NOT CONNECTED <--");
-                ESP_LOGI(TAG, "Trying to connect again...");
-                this->sendFirstConnectionPacket();
-            }});
-
     } else {
         ESP_LOGE(TAG, "UART doesn't seem to be connected...");
         this->setupUART();
-        // this delay to prevent a logging flood should never happen
-        CUSTOM_DELAY(750);
     }
 }
 
@@ -47,11 +36,11 @@ void CN105Climate::sendFirstConnectionPacket() {
 
 // void CN105Climate::statusChanged() {
 //     ESP_LOGD(TAG, "hpStatusChanged ->");
-//     this->current_temperature = currentStatus.roomTemperature;
+//     this->current_temperature = hpState.status.roomTemperature;
 
-//     ESP_LOGD(TAG, "t°: %f", currentStatus.roomTemperature);
-//     ESP_LOGD(TAG, "operating: %d", currentStatus.operating);
-//     ESP_LOGD(TAG, "compressor freq: %f", currentStatus.compressorFrequency);
+//     ESP_LOGD(TAG, "t°: %f", hpState.status.roomTemperature);
+//     ESP_LOGD(TAG, "operating: %d", hpState.status.operating);
+//     ESP_LOGD(TAG, "compressor freq: %f", hpState.status.compressorFrequency);
 
 //     this->updateAction();
 //     this->publish_state();
@@ -59,51 +48,174 @@ void CN105Climate::sendFirstConnectionPacket() {
 
 void CN105Climate::prepareInfoPacket(uint8_t* packet, int length) {
     ESP_LOGV(TAG, "preparing info packet...");
+    encodeInfoHeader(packet, length);
+}
 
-    memset(packet, 0, length * sizeof(uint8_t));
+void CN105Climate::prepareSetPacket(uint8_t* packet, int length) {
+    ESP_LOGV(TAG, "preparing Set packet...");
+    encodeSetHeader(packet, length);
+}
 
-    for (int i = 0; i < INFOHEADER_LEN && i < length; i++) {
-        packet[i] = INFOHEADER[i];
+/**
+ * Hands a copy of the frame over to the tx queue, so the caller's buffer can go out of scope,
+ * and sends it right away if the link is ready. Otherwise it waits in the queue, at most
+ * until its deadline, and is sent from loop() once the link is back.
+*/
+txHandle CN105Climate::writePacket(uint8_t* packet, int length, bool checkIsActive, TxPriority priority) {
+    uint32_t timeoutMs = TX_SET_TIMEOUT_MS;
+    if (priority == TxPriority::PRIO_LOW) {
+        timeoutMs = TX_REQUEST_TIMEOUT_MS;
+    } else if (priority == TxPriority::PRIO_HIGH) {
+        timeoutMs = TX_CONNECT_TIMEOUT_MS;
     }
+
+    txHandle handle = this->transmitQueue.enqueue(packet, length, priority, timeoutMs, checkIsActive);
+    this->processTxQueue();
+    return handle;
 }
 
-void CN105Climate::prepareSetPacket(uint8_t* packet, int length) {
-    ESP_LOGV(TAG, "preparing Set packet...");
-    memset(packet, 0, length * sizeof(uint8_t));
+/**
+ * Sends the queued frames, highest priority first, as long as the link can take them.
+ * A frame is only handed to the UART once the previous one has left the wire.
+*/
+void CN105Climate::processTxQueue() {
+#ifdef USE_CN105_TCP_BRIDGE
+    if (this->bridge.state == BridgeState::AWAITING) {
+        return;                                             // the line is the bridge client's until the unit answers
+    }
+#endif
+    txFrame* frame;
+    while ((frame = this->transmitQueue.next()) != nullptr) {
+        if (!this->isTxComplete()) {
+            return;                                         // previous frame still on the wire
+        }
+        if ((!this->isUARTConnected_) ||
+            (frame->checkIsActive && !this->isHeatpumpConnectionActive())) {
+            ESP_LOGV(TAG, "tx queue: link not ready, %d frame(s) waiting", this->transmitQueue.size());
+            this->reconnectIfConnectionLost();
+            return;
+        }
+        this->sendFrame(frame->bytes, frame->length);
+#ifdef USE_CN105_TCP_BRIDGE
+        if (frame->handle == this->bridge.handle) {
+            this->bridge.sent();
+        }
+#endif
+        this->transmitQueue.complete(frame, TxStatus::SENT);
+    }
+}
 
-    for (int i = 0; i < HEADER_LEN && i < length; i++) {
-        packet[i] = HEADER[i];
+/**
+ * Accepts the bridge client, reads its next frame and hands it to the tx queue in a gap of
+ * the poll cycle. Its response is forwarded by processDataPacket().
+*/
+void CN105Climate::processTcpBridge() {
+#ifdef USE_CN105_TCP_BRIDGE
+    if (this->bridge.port == 0) {
+        return;
+    }
+    this->bridge.acceptClient();
+    this->bridge.readFrame();
+
+    uint32_t now = cn105Millis();
+    switch (this->bridge.state) {
+    case BridgeState::READY:
+        if (elapsedMs(now, this->bridge.receivedMs) > TCP_BRIDGE_READY_TIMEOUT_MS) {
+            ESP_LOGW(TAG, "tcp bridge: no gap in the poll cycle, client frame dropped");
+            this->bridge.drop();
+        } else if (this->isTcpBridgeSlotFree()) {
+            // enqueued directly: processTxQueue() must know the handle when it sends the frame
+            txHandle handle = this->transmitQueue.enqueue(this->bridge.framer.getFrame(), this->bridge.framer.getFrameLength(),
+                TxPriority::PRIO_NORMAL, TX_SET_TIMEOUT_MS, true);
+            if (handle == TX_INVALID_HANDLE) {
+                this->bridge.drop();
+            } else {
+                this->bridge.queued(handle);
+                this->processTxQueue();
+            }
+        }
+        break;
+    case BridgeState::QUEUED: {
+        TxStatus status = this->transmitQueue.getStatus(this->bridge.handle);
+        if (status != TxStatus::QUEUED && status != TxStatus::SENT) {
+            ESP_LOGW(TAG, "tcp bridge: client frame not sent (%s)", status == TxStatus::EVICTED ? "evicted" : "expired");
+            this->bridge.drop();
+        }
+    }
+        break;
+    case BridgeState::AWAITING:
+        if (elapsedMs(now, this->bridge.sentMs) > TCP_BRIDGE_RESPONSE_TIMEOUT_MS) {
+            this->bridge.timeout();
+            this->processTxQueue();                         // our frames held meanwhile
+        }
+        break;
+    default:
+        break;
     }
+#endif
 }
 
-void CN105Climate::writePacket(uint8_t* packet, int length, bool checkIsActive) {
+// a client frame is on the line: no new poll cycle until it is answered
+bool CN105Climate::isTcpBridgeBusy() {
+#ifdef USE_CN105_TCP_BRIDGE
+    return this->bridge.isBusy();
+#else
+    return false;
+#endif
+}
 
-    if ((this->isUARTConnected_) &&
-        (this->isHeatpumpConnectionActive() || (!checkIsActive))) {
+/**
+ * A gap of the poll cycle: synced link, no cycle, nothing of ours queued, on the wire or awaiting
+ * an answer, so the next frame of the unit can only be the response to the client's.
+*/
+bool CN105Climate::isTcpBridgeSlotFree() {
+    return this->link.is(LinkState::POLLING) &&
+        !this->loopCycle.isCycleRunning() &&
+        !this->liveness.probePending &&
+        !this->wantedSettings.hasChanged &&
+        !this->wantedRunStates.hasChanged &&
+        (this->transmitQueue.size() == 0) &&
+        this->isTxComplete();
+}
 
-        ESP_LOGD(TAG, "writing packet...");
-        this->hpPacketDebug(packet, length, "WRITE");
+void CN105Climate::sendFrame(const uint8_t* packet, int length) {
+    ESP_LOGD(TAG, "writing packet...");
+    this->hpPacketDebug(packet, length, TraceDirection::TX);
 
-        for (int i = 0; i < length; i++) {
-            this->get_hw_serial_()->write_byte((uint8_t)packet[i]);
-        }
+    this->transport->write(packet, length);
 
-        // Prevent sending wantedSettings too soon after writing for example the remote temperature update packet
-        this->lastSend = CUSTOM_MILLIS;
+    // write() returns as soon as the frame is buffered: pacing relies on when it actually leaves
+    // (this prevents sending wantedSettings too soon after writing for example the remote temperature update packet).
+    // Through a TCP bridge, it leaves the line of the unit half a round trip later.
+    this->txCompleteMs = cn105Millis() + this->getFrameDurationMs(length) + this->transport->getRttMs() / 2;
+    this->responsePending = true;
 
-    } else {
-        ESP_LOGW(TAG, "could not write as asked, because UART is not connected");
-        this->reconnectUART();
-        ESP_LOGW(TAG, "delaying packet writing because we need to reconnect first...");
-        this->set_timeout("write", 4000, [this, packet, length]() { this->writePacket(packet, length); });
+    if (length > 1 && packet[1] == HEADER[1]) {         // set packet (0x41): the heatpump will ACK it
+        this->onLinkEvent(LinkEvent::WRITE_SENT);
     }
 }
 
+/**
+ * time needed to shift the frame out on the line of the unit (22 bytes at 2400 bauds 8E1 take about 100 ms)
+*/
+uint32_t CN105Climate::getFrameDurationMs(int length) {
+    return this->transport->getFrameDurationMs(length);
+}
+
+bool CN105Climate::isTxComplete() {
+    return isTimeReached(cn105Millis(), this->txCompleteMs);
+}
+
+uint32_t CN105Climate::getTimeSinceTxComplete() {
+    int32_t elapsed = (int32_t)(cn105Millis() - this->txCompleteMs);
+    return elapsed > 0 ? elapsed : 0;
+}
+
 const char* CN105Climate::getModeSetting() {
     if (this->wantedSettings.mode) {
         return this->wantedSettings.mode;
     } else {
-        return this->currentSettings.mode;
+        return this->hpState.settings.mode;
     }
 }
 
@@ -111,7 +223,7 @@ const char* CN105Climate::getPowerSetting() {
     if (this->wantedSettings.power) {
         return this->wantedSettings.power;
     } else {
-        return this->currentSettings.power;
+        return this->hpState.settings.power;
     }
 }
 
@@ -119,18 +231,7 @@ const char* CN105Climate::getVaneSetting() {
     if (this->wantedSettings.vane) {
         return this->wantedSettings.vane;
     } else {
-        return this->currentSettings.vane;
-    }
-}
-
-const char* CN105Climate::getWideVaneSetting() {
-    if (this->wantedSettings.wideVane) {
-        if (strcmp(this->wantedSettings.wideVane, lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, 0x80 & 0x0F)) == 0 && !this->currentSettings.iSee) {
-            this->wantedSettings.wideVane = this->currentSettings.wideVane;
-        }
-        return this->wantedSettings.wideVane;
-    } else {
-        return this->currentSettings.wideVane;
+        return this->hpState.settings.vane;
     }
 }
 
@@ -138,7 +239,7 @@ const char* CN105Climate::getFanSpeedSetting() {
     if (this->wantedSettings.fan) {
         return this->wantedSettings.fan;
     } else {
-        return this->currentSettings.fan;
+        return this->hpState.settings.fan;
     }
 }
 
@@ -146,94 +247,13 @@ float CN105Climate::getTemperatureSetting() {
     if (this->wantedSettings.temperature != -1.0) {
         return this->wantedSettings.temperature;
     } else {
-        return this->currentSettings.temperature;
+        return this->hpState.settings.temperature;
     }
 }
-const char* CN105Climate::getAirflowControlSetting() {
-    if (this->wantedRunStates.airflow_control) {
-        return this->wantedRunStates.airflow_control;
-    } else {
-        return this->currentRunStates.airflow_control;
-    }
-}
-bool CN105Climate::getAirPurifierRunState() {
-    if (this->wantedRunStates.air_purifier != this->currentRunStates.air_purifier) {
-        return this->wantedRunStates.air_purifier;
-    } else {
-        return this->currentRunStates.air_purifier;
-    }
-}
-bool CN105Climate::getNightModeRunState() {
-    if (this->wantedRunStates.night_mode != this->currentRunStates.night_mode) {
-        return this->wantedRunStates.night_mode;
-    } else {
-        return this->currentRunStates.night_mode;
-    }
-}
-bool CN105Climate::getCirculatorRunState() {
-    if (this->wantedRunStates.circulator != this->currentRunStates.circulator) {
-        return this->wantedRunStates.circulator;
-    } else {
-        return this->currentRunStates.circulator;
-    }
-}
-
 
 void CN105Climate::createPacket(uint8_t* packet) {
-    prepareSetPacket(packet, PACKET_LEN);
-
-    //ESP_LOGD(TAG, "checking differences bw asked settings and current ones...");
     ESP_LOGD(TAG, "building packet for writing...");
-
-    if (this->wantedSettings.power != nullptr) {
-        ESP_LOGD(TAG, "power -> %s", getPowerSetting());
-        packet[8] = POWER[lookupByteMapIndex(POWER_MAP, 2, getPowerSetting(), "power (write)")];
-        packet[6] += CONTROL_PACKET_1[0];
-    }
-
-    if (this->wantedSettings.mode != nullptr) {
-        ESP_LOGD(TAG, "heatpump mode -> %s", getModeSetting());
-        packet[9] = MODE[lookupByteMapIndex(MODE_MAP, 5, getModeSetting(), "mode (write)")];
-        packet[6] += CONTROL_PACKET_1[1];
-    }
-
-    if (wantedSettings.temperature != -1) {
-        if (!tempMode) {
-            ESP_LOGD(TAG, "temperature (tempmode is false) -> %f", getTemperatureSetting());
-            packet[10] = TEMP[lookupByteMapIndex(TEMP_MAP, 16, getTemperatureSetting(), "temperature (write)")];
-            packet[6] += CONTROL_PACKET_1[2];
-        } else {
-            ESP_LOGD(TAG, "temperature (tempmode is true) -> %f", getTemperatureSetting());
-            float temp = (getTemperatureSetting() * 2) + 128;
-            packet[19] = (int)temp;
-            packet[6] += CONTROL_PACKET_1[2];
-        }
-    }
-
-    if (this->wantedSettings.fan != nullptr) {
-        ESP_LOGD(TAG, "heatpump fan -> %s", getFanSpeedSetting());
-        packet[11] = FAN[lookupByteMapIndex(FAN_MAP, 6, getFanSpeedSetting(), "fan (write)")];
-        packet[6] += CONTROL_PACKET_1[3];
-    }
-
-    if (this->wantedSettings.vane != nullptr) {
-        ESP_LOGD(TAG, "heatpump vane -> %s", getVaneSetting());
-        packet[12] = VANE[lookupByteMapIndex(VANE_MAP, 7, getVaneSetting(), "vane (write)")];
-        packet[6] += CONTROL_PACKET_1[4];
-    }
-
-    if (this->wantedSettings.wideVane != nullptr) {
-        ESP_LOGD(TAG, "heatpump widevane -> %s", getWideVaneSetting());
-        packet[18] = WIDEVANE[lookupByteMapIndex(WIDEVANE_MAP, 8, getWideVaneSetting(), "wideVane (write)")] | (this->wideVaneAdj ? 0x80 : 0x00);
-        packet[7] += CONTROL_PACKET_2[0];
-    }
-
-
-    // add the checksum
-    uint8_t chkSum = checkSum(packet, 21);
-    packet[21] = chkSum;
-    //ESP_LOGD(TAG, "debug before write packet:");
-    //this->hpPacketDebug(packet, 22, "WRITE");
+    mergeWantedSettings(packet, this->wantedSettings, this->hpState.settings, this->tempMode, this->wideVaneAdj);
 }
 
 
@@ -254,10 +274,10 @@ void CN105Climate::publishWantedSettingsStateToHA() {
 
     if ((this->wantedSettings.vane != nullptr) || (this->wantedSettings.wideVane != nullptr)) {
         if (this->wantedSettings.vane == nullptr) { // to prevent a nullpointer error
-            this->wantedSettings.vane = this->currentSettings.vane;
+            this->wantedSettings.vane = this->hpState.settings.vane;
         }
         if (this->wantedSettings.wideVane == nullptr) { // to prevent a nullpointer error
-            this->wantedSettings.wideVane = this->currentSettings.wideVane;
+            this->wantedSettings.wideVane = this->hpState.settings.wideVane;
         }
 
         checkVaneSettings(this->wantedSettings, false);
@@ -274,7 +294,7 @@ void CN105Climate::publishWantedSettingsStateToHA() {
 void CN105Climate::publishWantedRunStatesStateToHA() {
     if (this->wantedRunStates.airflow_control != nullptr) {
         if (this->wantedRunStates.airflow_control == nullptr) {
-            this->wantedRunStates.airflow_control = this->currentRunStates.airflow_control;
+            this->wantedRunStates.airflow_control = this->hpState.runStates.airflow_control;
         }
         if (this->hasChanged(this->airflow_control_select_->state.c_str(), this->wantedRunStates.airflow_control, "select airflow control")) {
             ESP_LOGI(TAG, "airflow control setting changed");
@@ -283,7 +303,7 @@ void CN105Climate::publishWantedRunStatesStateToHA() {
     }
     if (this->wantedRunStates.air_purifier > -1) {
         if (this->wantedRunStates.air_purifier == -1) {
-            this->wantedRunStates.air_purifier = this->currentRunStates.air_purifier;
+            this->wantedRunStates.air_purifier = this->hpState.runStates.air_purifier;
         }
         if (this->air_purifier_switch_->state != this->wantedRunStates.air_purifier) {
             ESP_LOGI(TAG, "air purifier setting changed");
@@ -292,7 +312,7 @@ void CN105Climate::publishWantedRunStatesStateToHA() {
     }
     if (this->wantedRunStates.night_mode > -1) {
         if (this->wantedRunStates.night_mode == -1) {
-            this->wantedRunStates.night_mode = this->currentRunStates.night_mode;
+            this->wantedRunStates.night_mode = this->hpState.runStates.night_mode;
         }
         if (this->night_mode_switch_->state != this->wantedRunStates.night_mode) {
             ESP_LOGI(TAG, "night mode setting changed");
@@ -301,7 +321,7 @@ void CN105Climate::publishWantedRunStatesStateToHA() {
     }
     if (this->wantedRunStates.circulator > -1) {
         if (this->wantedRunStates.circulator == -1) {
-            this->wantedRunStates.circulator = this->currentRunStates.circulator;
+            this->wantedRunStates.circulator = this->hpState.runStates.circulator;
         }
         if (this->circulator_switch_->state != this->wantedRunStates.circulator) {
             ESP_LOGI(TAG, "circulator setting changed");
@@ -312,20 +332,18 @@ void CN105Climate::publishWantedRunStatesStateToHA() {
 
 
 void CN105Climate::sendWantedSettingsDelegate() {
-    this->wantedSettings.hasBeenSent = true;
-    this->lastSend = CUSTOM_MILLIS;
     ESP_LOGI(TAG, "sending wantedSettings..");
-    this->debugSettings("wantedSettings", wantedSettings);
-    // and then we send the update packet
+    // marks the wanted settings as sent
     uint8_t packet[PACKET_LEN] = {};
     this->createPacket(packet);
+    this->debugSettings("wantedSettings", wantedSettings);
+    // and then we send the update packet
     this->writePacket(packet, PACKET_LEN);
-    this->hpPacketDebug(packet, 22, "WRITE_SETTINGS");
 
     this->publishWantedSettingsStateToHA();
 
     // as soon as the packet is sent, we reset the settings
-    this->wantedSettings.resetSettings();
+    consumeWantedSettings(this->wantedSettings);
 
     // as we've just sent a packet to the heatpump, we let it time for process
     // this might not be necessary but, we give it a try because of issue #32
@@ -340,7 +358,7 @@ void CN105Climate::sendWantedSettingsDelegate() {
 */
 void CN105Climate::sendWantedSettings() {
     if (this->isHeatpumpConnectionActive() && this->isUARTConnected_) {
-        if (CUSTOM_MILLIS - this->lastSend > 300) {        // we don't want to send too many packets
+        if (this->getTimeSinceTxComplete() > 300) {        // we don't want to send too many packets
 
             //this->cycleEnded();   // only if we let the cycle be interrupted to send wented settings
 
@@ -363,7 +381,7 @@ void CN105Climate::sendWantedSettings() {
 void CN105Climate::buildAndSendRequestPacket(int packetType) {
     uint8_t packet[PACKET_LEN] = {};
     createInfoPacket(packet, packetType);
-    this->writePacket(packet, PACKET_LEN);
+    this->writePacket(packet, PACKET_LEN, true, TxPriority::PRIO_LOW);
 }
 
 
@@ -388,17 +406,14 @@ void CN105Climate::buildAndSendRequestsInfoPackets() {
 
 void CN105Climate::createInfoPacket(uint8_t* packet, uint8_t packetType) {
     ESP_LOGD(TAG, "creating Info packet");
-    // add the header to the packet
-    for (int i = 0; i < INFOHEADER_LEN; i++) {
-        packet[i] = INFOHEADER[i];
-    }
 
     // set the mode - settings or room temperature
+    uint8_t infoCode;
     if (packetType != PACKET_TYPE_DEFAULT) {
-        packet[5] = INFOMODE[packetType];
+        infoCode = INFOMODE[packetType];
     } else {
         // request current infoMode, and increment for the next request
-        packet[5] = INFOMODE[infoMode];
+        infoCode = INFOMODE[infoMode];
         if (infoMode == (INFOMODE_LEN - 1)) {
             infoMode = 0;
         } else {
@@ -406,14 +421,7 @@ void CN105Climate::createInfoPacket(uint8_t* packet, uint8_t packetType) {
         }
     }
 
-    // pad the packet out
-    for (int i = 0; i < 15; i++) {
-        packet[i + 6] = 0x00;
-    }
-
-    // add the checksum
-    uint8_t chkSum = checkSum(packet, 21);
-    packet[21] = chkSum;
+    encodeInfoRequest(packet, infoCode);
 }
 
 
@@ -422,21 +430,7 @@ void CN105Climate::sendRemoteTemperature() {
     this->shouldSendExternalTemperature_ = false;
 
     uint8_t packet[PACKET_LEN] = {};
-
-    prepareSetPacket(packet, PACKET_LEN);
-
-    packet[5] = 0x07;
-    if (this->remoteTemperature_ > 0) {
-        packet[6] = 0x01;
-        float temp = round(this->remoteTemperature_ * 2);
-        packet[7] = static_cast<uint8_t>(temp - 16);
-        packet[8] = static_cast<uint8_t>(temp + 128);
-    } else {
-        packet[8] = 0x80; //MHK1 send 80, even though it could be 00, since ControlByte is 00
-    }
-    // add the checksum
-    uint8_t chkSum = checkSum(packet, 21);
-    packet[21] = chkSum;
+    encodeRemoteTemperature(packet, this->remoteTemperature_);
     ESP_LOGD(LOG_REMOTE_TEMP, "Sending remote temperature packet... -> %f", this->remoteTemperature_);
     writePacket(packet, PACKET_LEN);
 
@@ -446,45 +440,122 @@ void CN105Climate::sendRemoteTemperature() {
 
 void CN105Climate::sendWantedRunStates() {
     uint8_t packet[PACKET_LEN] = {};
-    
-    prepareSetPacket(packet, PACKET_LEN);
-    
-    packet[5] = 0x08;
-    if (this->wantedRunStates.airflow_control != nullptr) {
-        ESP_LOGD(TAG, "airflow control -> %s", getAirflowControlSetting());
-        packet[11] = AIRFLOW_CONTROL[lookupByteMapIndex(AIRFLOW_CONTROL_MAP, 3, getAirflowControlSetting(), "run state (write)")];
-        packet[6] += RUN_STATE_PACKET_1[4];
-    }
-    if (this->wantedRunStates.air_purifier > -1) {
-        if (getAirPurifierRunState() != currentRunStates.air_purifier) {
-            ESP_LOGI(TAG, "air purifier switch state -> %s", getAirPurifierRunState() ? "ON" : "OFF");
-            packet[17] = getAirPurifierRunState() ? 0x01 : 0x00;
-            packet[7] += RUN_STATE_PACKET_2[1];
-        }
-    }
-    if (this->wantedRunStates.night_mode > -1) {
-        if (getNightModeRunState() != currentRunStates.night_mode) {
-            ESP_LOGI(TAG, "night mode switch state -> %s", this->getNightModeRunState() ? "ON" : "OFF");
-            packet[18] = getNightModeRunState() ? 0x01 : 0x00;
-            packet[7] += RUN_STATE_PACKET_2[2];
-        }
-    }
-    if (this->wantedRunStates.circulator > -1) {
-        if (getCirculatorRunState() != currentRunStates.circulator) {
-            ESP_LOGI(TAG, "circulator switch state -> %s", getCirculatorRunState() ? "ON" : "OFF");
-            packet[19] = getCirculatorRunState() ? 0x01 : 0x00;
-            packet[7] += RUN_STATE_PACKET_2[3];
-        }
-    }
-    
-    // Add the checksum
-    uint8_t chkSum = checkSum(packet, 21);
-    packet[21] = chkSum;
+    mergeWantedRunStates(packet, this->wantedRunStates);
     ESP_LOGD(LOG_SET_RUN_STATE, "Sending set run state package (0x08)");
     writePacket(packet, PACKET_LEN);
     
     this->publishWantedRunStatesStateToHA();
     
-    this->wantedRunStates.resetSettings();
+    consumeWantedRunStates(this->wantedRunStates);
     this->loopCycle.deferCycle();
-}
\ No newline at end of file
+}
+
+//#region heatpump_functions fonctions clim
+
+void CN105Climate::getFunctions() {
+    ESP_LOGV(TAG, "getting the list of functions...");
+
+    functions.clear();
+
+    uint8_t packet1[PACKET_LEN] = {};
+
+    prepareInfoPacket(packet1, PACKET_LEN);
+    packet1[5] = FUNCTIONS_GET_PART1;
+    packet1[21] = checkSum(packet1, 21);
+
+    writePacket(packet1, PACKET_LEN, true, TxPriority::PRIO_LOW);
+
+    // Read command will issue part 2.
+}
+
+void CN105Climate::getFunctionsPart2() {
+    ESP_LOGV(TAG, "getting the list of functions part 2...");
+
+    uint8_t packet2[PACKET_LEN] = {};
+
+    prepareInfoPacket(packet2, PACKET_LEN);
+    packet2[5] = FUNCTIONS_GET_PART2;
+    packet2[21] = checkSum(packet2, 21);
+
+    writePacket(packet2, PACKET_LEN, true, TxPriority::PRIO_LOW);
+}
+
+void CN105Climate::functionsArrived() {
+
+    // Called after 2nd packet has arrived.
+
+    char states[256];
+    states[0] = '\0';  // Initialize as empty string
+    size_t remaining = sizeof(states);
+    char* pos = states;
+
+    heatpumpFunctionCodes codes = functions.getAllCodes();
+    for (int i = 0; i < MAX_FUNCTION_CODE_COUNT; ++i) {
+        if (codes.valid[i]) {
+            int code = codes.code[i];
+            int value = functions.getValue(code);
+            if (value > 0) {  // only values 1, 2, 3 are valid -- 0 values mean something the device does not support
+                int written = snprintf(pos, remaining, "%i: %i ", code, value);
+                if (written < 0 || static_cast<size_t>(written) >= remaining) {
+                    // Buffer full or error
+                    break;
+                }
+                pos += written;
+                remaining -= written;
+            }
+        }
+    }
+
+    // Publish the results of all the codes in the Functions sensor
+    if (this->Functions_sensor_ != nullptr) {
+        this->Functions_sensor_->publish_state(states);
+    }
+}
+
+bool CN105Climate::setFunctions(heatpumpFunctions const& functions) {
+    if (!functions.isValid()) {
+        return false;
+    }
+
+    uint8_t packet1[PACKET_LEN] = {};
+    uint8_t packet2[PACKET_LEN] = {};
+
+    prepareSetPacket(packet1, PACKET_LEN);
+    packet1[5] = FUNCTIONS_SET_PART1;
+
+    prepareSetPacket(packet2, PACKET_LEN);
+    packet2[5] = FUNCTIONS_SET_PART2;
+
+    functions.getData1(&packet1[6]);
+    functions.getData2(&packet2[6]);
+
+    // sanity check, we expect data byte 15 (index 20) to be 0
+    if (packet1[20] != 0 || packet2[20] != 0)
+        return false;
+
+    // make sure all the other data bytes are set
+    for (int i = 6; i < 20; ++i) {
+        if (packet1[i] == 0 || packet2[i] == 0)
+            return false;
+    }
+
+    packet1[21] = checkSum(packet1, 21);
+    packet2[21] = checkSum(packet2, 21);
+    /*
+        while (!canSend(false)) {
+            cn105Delay(10);
+        }*/
+    ESP_LOGD(TAG, "sending a setFunctions packet part 1");
+    writePacket(packet1, PACKET_LEN);
+    //readPacket();
+
+    /*while (!canSend(false)) {
+        cn105Delay(10);
+    }*/
+    ESP_LOGD(TAG, "sending a setFunctions packet part 2");
+    writePacket(packet2, PACKET_LEN);
+    //readPacket();
+
+    return true;
+}
+//#endregion heatpump_functions fonctions clim
@@ -0,0 +1,122 @@
+#include "link_state_machine.h"
+#include "cn105_clock.h"
+#include "cn105_core_log.h"
+
+static const char* LINK_TAG = "LINK";
+
+static const char* LINK_STATE_NAMES[LINK_STATE_COUNT] = { "UART_DOWN", "CONNECTING", "SYNCING", "POLLING", "WRITING", "DEGRADED" };
+
+// every allowed transition; an event with no matching row leaves the state unchanged
+static const linkTransition LINK_TRANSITIONS[] = {
+    { LinkState::UART_DOWN,  LinkEvent::UART_READY,     LinkState::CONNECTING },
+
+    { LinkState::CONNECTING, LinkEvent::UART_LOST,      LinkState::UART_DOWN },
+    { LinkState::CONNECTING, LinkEvent::CONNECT_ACK,    LinkState::SYNCING },
+
+    { LinkState::SYNCING,    LinkEvent::UART_LOST,      LinkState::UART_DOWN },
+    { LinkState::SYNCING,    LinkEvent::CYCLE_COMPLETE, LinkState::POLLING },
+    { LinkState::SYNCING,    LinkEvent::PROBE_MISSED,   LinkState::DEGRADED },
+    { LinkState::SYNCING,    LinkEvent::LINK_LOST,      LinkState::CONNECTING },
+
+    { LinkState::POLLING,    LinkEvent::UART_LOST,      LinkState::UART_DOWN },
+    { LinkState::POLLING,    LinkEvent::WRITE_SENT,     LinkState::WRITING },
+    { LinkState::POLLING,    LinkEvent::PROBE_MISSED,   LinkState::DEGRADED },
+    { LinkState::POLLING,    LinkEvent::LINK_LOST,      LinkState::CONNECTING },
+
+    { LinkState::WRITING,    LinkEvent::UART_LOST,      LinkState::UART_DOWN },
+    { LinkState::WRITING,    LinkEvent::WRITE_DONE,     LinkState::POLLING },
+    { LinkState::WRITING,    LinkEvent::CYCLE_COMPLETE, LinkState::POLLING },    // ACK lost but the link works
+    { LinkState::WRITING,    LinkEvent::PROBE_MISSED,   LinkState::DEGRADED },
+    { LinkState::WRITING,    LinkEvent::LINK_LOST,      LinkState::CONNECTING },
+
+    { LinkState::DEGRADED,   LinkEvent::UART_LOST,      LinkState::UART_DOWN },
+    { LinkState::DEGRADED,   LinkEvent::RESPONSE_OK,    LinkState::POLLING },    // or back to degradedFrom, see handle()
+    { LinkState::DEGRADED,   LinkEvent::WRITE_SENT,     LinkState::WRITING },
+    { LinkState::DEGRADED,   LinkEvent::LINK_LOST,      LinkState::CONNECTING },
+};
+
+void linkStateMachine::init() {
+    state = LinkState::UART_DOWN;
+    degradedFrom = LinkState::POLLING;
+    enteredMs = cn105Millis();
+}
+
+/**
+ * applies an event, returns true if the state has changed
+ * A link that recovers goes back to the state it degraded from: one that degraded while SYNCING
+ * has not completed its first cycle yet.
+*/
+bool linkStateMachine::handle(LinkEvent event) {
+    for (const linkTransition& t : LINK_TRANSITIONS) {
+        if (t.from == state && t.event == event) {
+            LinkState next = t.to;
+            if (state == LinkState::DEGRADED && event == LinkEvent::RESPONSE_OK) {
+                next = degradedFrom;
+            } else if (next == LinkState::DEGRADED) {
+                degradedFrom = state;
+            }
+
+            uint32_t now = cn105Millis();
+            uint8_t from = static_cast<uint8_t>(state);
+            uint8_t to = static_cast<uint8_t>(next);
+
+            timeInStateMs[from] += elapsedMs(now, enteredMs);
+            transitionCounts[from][to]++;
+            enteredMs = now;
+            state = next;
+
+            ESP_LOGD(LINK_TAG, "%s -> %s", LINK_STATE_NAMES[from], LINK_STATE_NAMES[to]);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool linkStateMachine::is(LinkState s) const {
+    return state == s;
+}
+
+bool linkStateMachine::isHeatpumpConnected() const {
+    return state == LinkState::SYNCING || state == LinkState::POLLING ||
+        state == LinkState::WRITING || state == LinkState::DEGRADED;
+}
+
+/**
+ * total ms spent in a state, including the current period
+*/
+uint32_t linkStateMachine::getTimeInState(LinkState s) {
+    uint32_t total = timeInStateMs[static_cast<uint8_t>(s)];
+    if (s == state) {
+        total += elapsedMs(cn105Millis(), enteredMs);
+    }
+    return total;
+}
+
+uint32_t linkStateMachine::getTransitionCount(LinkState from, LinkState to) const {
+    return transitionCounts[static_cast<uint8_t>(from)][static_cast<uint8_t>(to)];
+}
+
+const char* linkStateMachine::getStateName(LinkState s) {
+    uint8_t index = static_cast<uint8_t>(s);
+    return index < LINK_STATE_COUNT ? LINK_STATE_NAMES[index] : "UNKNOWN";
+}
+
+void linkStateMachine::logStats() {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < LINK_STATE_COUNT; i++) {
+        total += getTimeInState(static_cast<LinkState>(i));
+    }
+
+    ESP_LOGI(LINK_TAG, "current state: %s", LINK_STATE_NAMES[static_cast<uint8_t>(state)]);
+    for (uint8_t i = 0; i < LINK_STATE_COUNT; i++) {
+        uint32_t ms = getTimeInState(static_cast<LinkState>(i));
+        ESP_LOGI(LINK_TAG, "%-10s: %9.1f s (%5.1f%%)", LINK_STATE_NAMES[i], ms / 1000.0, total > 0 ? ms * 100.0 / total : 0.0);
+    }
+    for (uint8_t from = 0; from < LINK_STATE_COUNT; from++) {
+        for (uint8_t to = 0; to < LINK_STATE_COUNT; to++) {
+            if (transitionCounts[from][to] > 0) {
+                ESP_LOGI(LINK_TAG, "%s -> %s: %u", LINK_STATE_NAMES[from], LINK_STATE_NAMES[to], (unsigned int)transitionCounts[from][to]);
+            }
+        }
+    }
+}
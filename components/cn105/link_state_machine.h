@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * Connection/protocol state of the link with the heatpump.
+ *
+ *   UART_DOWN -> CONNECTING -> SYNCING -> POLLING <-> WRITING
+ *                    ^             ^  |     |  ^
+ *                    |             |  v     v  |
+ *                    +------------ DEGRADED ---+
+ *
+ * SYNCING lasts until the first complete cycle, WRITING from a set packet until its ACK,
+ * DEGRADED while liveness probes are missed; a reply brings it back to the state it left.
+*/
+enum class LinkState : uint8_t {
+    UART_DOWN,
+    CONNECTING,
+    SYNCING,
+    POLLING,
+    WRITING,
+    DEGRADED,
+    COUNT
+};
+
+enum class LinkEvent : uint8_t {
+    UART_READY,         // UART configured as 8E1
+    UART_LOST,          // UART could not be configured
+    CONNECT_ACK,        // 0x7a received
+    CYCLE_COMPLETE,     // a full request cycle ended
+    WRITE_SENT,         // a 0x41 set packet was written
+    WRITE_DONE,         // 0x61 ACK received
+    PROBE_MISSED,       // a liveness probe was not answered
+    RESPONSE_OK,        // any valid frame received
+    LINK_LOST,          // the heatpump is considered disconnected
+};
+
+struct linkTransition {
+    LinkState from;
+    LinkEvent event;
+    LinkState to;
+};
+
+static const uint8_t LINK_STATE_COUNT = static_cast<uint8_t>(LinkState::COUNT);
+
+struct linkStateMachine {
+
+    LinkState state = LinkState::UART_DOWN;
+    LinkState degradedFrom = LinkState::POLLING;                       // where a recovered link goes back
+    uint32_t enteredMs = 0;
+    uint32_t timeInStateMs[LINK_STATE_COUNT] = {};                      // closed periods only
+    uint32_t transitionCounts[LINK_STATE_COUNT][LINK_STATE_COUNT] = {}; // [from][to]
+
+    void init();
+    bool handle(LinkEvent event);
+    bool is(LinkState s) const;
+    bool isHeatpumpConnected() const;
+    uint32_t getTimeInState(LinkState s);
+    uint32_t getTransitionCount(LinkState from, LinkState to) const;
+    void logStats();
+
+    static const char* getStateName(LinkState s);
+};
@@ -0,0 +1,47 @@
+#include "liveness_management.h"
+#include "cn105_clock.h"
+
+void livenessManagement::init() {
+    probePending = false;
+    nonResponseCounter = 0;
+}
+
+// any valid frame of the heatpump
+void livenessManagement::responseReceived() {
+    probePending = false;
+    nonResponseCounter = 0;
+}
+
+bool livenessManagement::isLinkLost() const {
+    return nonResponseCounter >= maxMissedProbes;
+}
+
+LivenessAction livenessManagement::check(uint32_t lastResponseMs, uint32_t rttMs) {
+    if (probeIntervalMs == 0) {
+        return LivenessAction::NONE;
+    }
+
+    uint32_t now = cn105Millis();
+
+    if (elapsedMs(now, lastResponseMs) < probeIntervalMs) {
+        return LivenessAction::NONE;                        // recent traffic, nothing to probe
+    }
+    if (probePending && elapsedMs(now, lastProbeMs) < probeIntervalMs + rttMs) {
+        return LivenessAction::NONE;                        // still waiting for the last probe
+    }
+
+    LivenessAction action = LivenessAction::PROBE;
+    if (probePending) {
+        nonResponseCounter++;
+        if (nonResponseCounter >= maxMissedProbes) {
+            probePending = false;
+            nonResponseCounter = 0;
+            return LivenessAction::LINK_LOST;
+        }
+        action = LivenessAction::PROBE_MISSED;
+    }
+
+    probePending = true;
+    lastProbeMs = now;
+    return action;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+
+#define MAX_DELAY_RESPONSE_FACTOR 10  // update_interval*10 seconds max without response
+
+// the nb of request without response before we declare UART is not connected anymore
+static const int MAX_NON_RESPONSE_REQ = 5;
+
+// liveness probe: when the heatpump has been silent for this long, a single status request is sent
+static const uint32_t DEFAULT_PROBE_INTERVAL_MS = 3000;
+
+enum class LivenessAction : uint8_t {
+    NONE,
+    PROBE,                  // the link is silent: a status request (0x06) is due
+    PROBE_MISSED,           // the last probe was not answered, a new one is due
+    LINK_LOST,              // maxMissedProbes probes missed in a row: reconnect
+};
+
+/**
+ * Liveness layer, independent of update_interval.
+ * Any valid frame from the heatpump proves the link is alive. When it has been silent for
+ * probeIntervalMs, a single status request (0x06) is due; if a cycle is already running,
+ * its outstanding request is the probe. Each probe left unanswered after probeIntervalMs
+ * counts as a miss, and maxMissedProbes consecutive misses mean the link is lost.
+ * The caller sends the probe and reconnects.
+*/
+struct livenessManagement {
+
+    uint32_t probeIntervalMs = DEFAULT_PROBE_INTERVAL_MS;  // 0: no probe
+    int maxMissedProbes = MAX_NON_RESPONSE_REQ;
+    // true while a liveness probe (or a cycle request acting as one) is waiting for a reply
+    bool probePending = false;
+    uint32_t lastProbeMs = 0;
+    int nonResponseCounter = 0;             // probes missed in a row
+
+    void init();
+    void responseReceived();
+    bool isLinkLost() const;
+    // rttMs: round trip of the transport, the answer to a probe comes that much later
+    LivenessAction check(uint32_t lastResponseMs, uint32_t rttMs);
+
+};
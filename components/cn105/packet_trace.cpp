@@ -0,0 +1,67 @@
+#include "packet_trace.h"
+#include "cn105_core_log.h"
+#include <string.h>
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+void packetTrace::init() {
+    nbRecorded = 0;
+}
+
+void packetTrace::record(uint32_t timestampMs, TraceDirection direction, const uint8_t* bytes, int length) {
+    packetTraceEntry& entry = entries[nbRecorded % PACKET_TRACE_ENTRIES];
+    int stored = length < PACKET_TRACE_FRAME_MAX_LEN ? length : PACKET_TRACE_FRAME_MAX_LEN;
+
+    entry.timestampMs = timestampMs;
+    entry.seq = nbRecorded;
+    entry.direction = direction;
+    entry.length = length;
+    memcpy(entry.bytes, bytes, stored);
+    nbRecorded++;
+}
+
+int packetTrace::size() {
+    return nbRecorded < (uint32_t)PACKET_TRACE_ENTRIES ? nbRecorded : PACKET_TRACE_ENTRIES;
+}
+
+const packetTraceEntry& packetTrace::get(int i) {
+    uint32_t first = nbRecorded - size();
+    return entries[(first + i) % PACKET_TRACE_ENTRIES];
+}
+
+/**
+ * one line per frame: "<seq> <timestamp ms> <RX|TX> <hex bytes>", the format read by tools/cn105_trace2pcapng.py
+*/
+void packetTrace::dump(const char* tag) {
+    char hex[PACKET_TRACE_FRAME_MAX_LEN * 3 + 1];
+    int count = size();
+
+    ESP_LOGI(tag, "packet trace: %d frame(s), %u recorded since boot", count, (unsigned int)nbRecorded);
+    for (int i = 0; i < count; i++) {
+        const packetTraceEntry& entry = get(i);
+        int stored = entry.length < PACKET_TRACE_FRAME_MAX_LEN ? entry.length : PACKET_TRACE_FRAME_MAX_LEN;
+        formatFrame(entry.bytes, stored, hex, sizeof(hex));
+        ESP_LOGI(tag, "%u %u %s %s%s", (unsigned int)entry.seq, (unsigned int)entry.timestampMs,
+            getDirectionName(entry.direction), hex, entry.length > stored ? " ..." : "");
+    }
+}
+
+size_t packetTrace::formatFrame(const uint8_t* bytes, int length, char* out, size_t outSize) {
+    size_t pos = 0;
+    for (int i = 0; i < length && pos + 3 < outSize; i++) {
+        out[pos++] = HEX_DIGITS[bytes[i] >> 4];
+        out[pos++] = HEX_DIGITS[bytes[i] & 0x0F];
+        out[pos++] = ' ';
+    }
+    if (pos > 0) {
+        pos--;                                      // no trailing space
+    }
+    if (outSize > 0) {
+        out[pos] = '\0';
+    }
+    return pos;
+}
+
+const char* packetTrace::getDirectionName(TraceDirection direction) {
+    return direction == TraceDirection::TX ? "TX" : "RX";
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+static const int PACKET_TRACE_ENTRIES = 32;
+static const int PACKET_TRACE_FRAME_MAX_LEN = 22;  // PACKET_LEN: longer frames are truncated in the trace
+
+enum class TraceDirection : uint8_t {
+    RX = 0,
+    TX,
+};
+
+struct packetTraceEntry {
+    uint32_t timestampMs;
+    uint32_t seq;
+    TraceDirection direction;
+    uint8_t length;                                 // length on the wire, may exceed the stored bytes
+    uint8_t bytes[PACKET_TRACE_FRAME_MAX_LEN];
+};
+
+/**
+ * Binary ring of the last frames exchanged with the heatpump.
+ * Recording costs a memcpy; frames are only formatted when the trace is dumped.
+ * The caller gives the timestamp.
+*/
+struct packetTrace {
+
+    packetTraceEntry entries[PACKET_TRACE_ENTRIES];
+    uint32_t nbRecorded = 0;                        // also the seq of the next entry
+
+    void init();
+    void record(uint32_t timestampMs, TraceDirection direction, const uint8_t* bytes, int length);
+    int size();
+    // i = 0 is the oldest entry still in the ring
+    const packetTraceEntry& get(int i);
+    void dump(const char* tag);
+
+    // hex dump "FC 41 01 ..." in out (3 chars per byte + null), returns the nb of chars written
+    static size_t formatFrame(const uint8_t* bytes, int length, char* out, size_t outSize);
+    static const char* getDirectionName(TraceDirection direction);
+};
@@ -0,0 +1,74 @@
+#include "state_snapshot.h"
+#include "cn105.h"
+#include "Globals.h"
+
+#include <stddef.h>
+
+using namespace esphome;
+
+static uint8_t snapshotIndexOf(const char* valuesMap[], int len, const char* value) {
+    if (value == nullptr) {
+        return SNAPSHOT_UNKNOWN;
+    }
+    for (int i = 0; i < len; i++) {
+        if (strcmp(valuesMap[i], value) == 0) {             // maps are per translation unit: compare contents
+            return i;
+        }
+    }
+    return SNAPSHOT_UNKNOWN;
+}
+
+static const char* snapshotValueOf(const char* valuesMap[], int len, uint8_t index) {
+    return index < len ? valuesMap[index] : nullptr;
+}
+
+void stateSnapshot::capture(const heatpumpSettings& settings, const heatpumpRunStates& runStates, const heatpumpStatus& status) {
+    memset(this, 0, sizeof(stateSnapshot));                 // padding included, for crc and comparisons
+    version = STATE_SNAPSHOT_VERSION;
+    power = snapshotIndexOf(POWER_MAP, 2, settings.power);
+    mode = snapshotIndexOf(MODE_MAP, 5, settings.mode);
+    fan = snapshotIndexOf(FAN_MAP, 6, settings.fan);
+    vane = snapshotIndexOf(VANE_MAP, 7, settings.vane);
+    wideVane = snapshotIndexOf(WIDEVANE_MAP, 8, settings.wideVane);
+    airflowControl = snapshotIndexOf(AIRFLOW_CONTROL_MAP, 3, runStates.airflow_control);
+    airPurifier = runStates.air_purifier;
+    nightMode = runStates.night_mode;
+    circulator = runStates.circulator;
+    operating = status.operating;
+    temperature = settings.temperature;
+    roomTemperature = status.roomTemperature;
+    outsideAirTemperature = status.outsideAirTemperature;
+    crc = computeCrc();
+}
+
+void stateSnapshot::restore(heatpumpSettings& settings, heatpumpRunStates& runStates, heatpumpStatus& status) const {
+    settings.power = snapshotValueOf(POWER_MAP, 2, power);
+    settings.mode = snapshotValueOf(MODE_MAP, 5, mode);
+    settings.fan = snapshotValueOf(FAN_MAP, 6, fan);
+    settings.vane = snapshotValueOf(VANE_MAP, 7, vane);
+    settings.wideVane = snapshotValueOf(WIDEVANE_MAP, 8, wideVane);
+    settings.temperature = temperature;
+    runStates.airflow_control = snapshotValueOf(AIRFLOW_CONTROL_MAP, 3, airflowControl);
+    runStates.air_purifier = airPurifier;
+    runStates.night_mode = nightMode;
+    runStates.circulator = circulator;
+    status.operating = operating;
+    status.roomTemperature = roomTemperature;
+    status.outsideAirTemperature = outsideAirTemperature;
+}
+
+bool stateSnapshot::isValid() const {
+    return (version == STATE_SNAPSHOT_VERSION) && (crc == computeCrc()) && (power != SNAPSHOT_UNKNOWN);
+}
+
+/**
+ * settings, run states and operating only: the temperatures change at every cycle and would
+ * write the flash as often, they are saved along with the next change of the others
+*/
+bool stateSnapshot::sameStateAs(const stateSnapshot& other) const {
+    return memcmp(this, &other, offsetof(stateSnapshot, roomTemperature)) == 0;
+}
+
+uint16_t stateSnapshot::computeCrc() const {
+    return crc16(reinterpret_cast<const uint8_t*>(this), offsetof(stateSnapshot, crc));
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+
+struct heatpumpSettings;
+struct heatpumpRunStates;
+struct heatpumpStatus;
+
+// bump it whenever the layout of stateSnapshot changes: older snapshots are then ignored
+static const uint8_t STATE_SNAPSHOT_VERSION = 1;
+static const uint8_t SNAPSHOT_UNKNOWN = 0xFF;
+
+/**
+ * Compact copy of the last confirmed state, saved in flash so that it can be published
+ * right at boot instead of leaving HA with unknown values until the first cycle.
+ * Strings are stored as indexes in their *_MAP (SNAPSHOT_UNKNOWN when not set),
+ * fast changing values (compressor frequency, power...) are not kept.
+*/
+struct stateSnapshot {
+
+    uint8_t version;
+    uint8_t power;
+    uint8_t mode;
+    uint8_t fan;
+    uint8_t vane;
+    uint8_t wideVane;
+    uint8_t airflowControl;
+    int8_t airPurifier;
+    int8_t nightMode;
+    int8_t circulator;
+    bool operating;
+    float temperature;
+    // not compared by sameStateAs(): keep them last, before crc
+    float roomTemperature;
+    float outsideAirTemperature;
+    uint16_t crc;                           // crc16 of all the bytes above
+
+    void capture(const heatpumpSettings& settings, const heatpumpRunStates& runStates, const heatpumpStatus& status);
+    void restore(heatpumpSettings& settings, heatpumpRunStates& runStates, heatpumpStatus& status) const;
+    bool isValid() const;
+    bool sameStateAs(const stateSnapshot& other) const;
+
+private:
+    uint16_t computeCrc() const;
+};
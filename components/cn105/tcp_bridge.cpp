@@ -0,0 +1,199 @@
+#ifdef USE_CN105_TCP_BRIDGE
+#include "tcp_bridge.h"
+#include "cn105_clock.h"
+#include "esphome/core/log.h"
+
+#include <errno.h>
+
+static const char* BRIDGE_TAG = "BRIDGE";
+static const uint32_t TCP_BRIDGE_SETUP_RETRY_MS = 5000;    // the network stack may not be up at boot
+
+/**
+ * non blocking listening socket; retried from loop() until the network stack takes it
+*/
+bool tcpBridge::setup() {
+    uint32_t now = cn105Millis();
+    if (this->setupTried && elapsedMs(now, this->lastSetupMs) < TCP_BRIDGE_SETUP_RETRY_MS) {
+        return false;
+    }
+    this->lastSetupMs = now;
+    this->framer.init();
+
+    this->server = esphome::socket::socket_ip(SOCK_STREAM, 0);
+    if (this->server == nullptr) {
+        if (!this->setupTried) {
+            ESP_LOGW(BRIDGE_TAG, "cannot create the socket (errno %d), retrying...", errno);
+        }
+        this->setupTried = true;
+        return false;
+    }
+    int enable = 1;
+    this->server->setsockopt(SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
+    this->server->setblocking(false);
+
+    struct sockaddr_storage addr;
+    socklen_t addrLen = esphome::socket::set_sockaddr_any((struct sockaddr*)&addr, sizeof(addr), this->port);
+    if (this->server->bind((struct sockaddr*)&addr, addrLen) != 0 || this->server->listen(1) != 0) {
+        if (!this->setupTried) {
+            ESP_LOGW(BRIDGE_TAG, "cannot listen on port %u (errno %d), retrying...", this->port, errno);
+        }
+        this->setupTried = true;
+        this->server->close();
+        this->server = nullptr;
+        return false;
+    }
+    this->setupTried = true;
+    ESP_LOGI(BRIDGE_TAG, "raw CN105 stream served on port %u", this->port);
+    return true;
+}
+
+/**
+ * a single client: a second one would interleave its frames with the first one's
+*/
+void tcpBridge::acceptClient() {
+    if (this->server == nullptr && !this->setup()) {
+        return;
+    }
+    struct sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+    std::unique_ptr<esphome::socket::Socket> sock = this->server->accept((struct sockaddr*)&addr, &addrLen);
+    if (sock == nullptr) {
+        return;
+    }
+    if (this->client != nullptr) {
+        ESP_LOGW(BRIDGE_TAG, "client %s refused, %s is connected", sock->getpeername().c_str(), this->client->getpeername().c_str());
+        sock->close();
+        return;
+    }
+    int enable = 1;
+    sock->setblocking(false);
+    sock->setsockopt(IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(int));     // a frame is a request: no Nagle delay
+    this->client = std::move(sock);
+    this->stats.nbClients++;
+    ESP_LOGI(BRIDGE_TAG, "client %s connected", this->client->getpeername().c_str());
+}
+
+/**
+ * Reads the client until a frame is complete. Nothing is read while a frame is in progress:
+ * the next ones wait in the socket, and the client is slowed down by TCP itself.
+*/
+bool tcpBridge::readFrame() {
+    if (this->client == nullptr || this->state != BridgeState::IDLE) {
+        return false;
+    }
+    uint8_t inputData;
+    for (;;) {
+        ssize_t length = this->client->read(&inputData, 1);
+        if (length == 0) {
+            this->closeClient();                    // closed by the client
+            return false;
+        }
+        if (length < 0) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN) {
+                ESP_LOGW(BRIDGE_TAG, "read error %d", errno);
+                this->closeClient();
+            }
+            return false;
+        }
+        if (!this->framer.push(inputData)) {
+            continue;
+        }
+        if (!this->framer.isChecksumValid() || this->framer.getFrameLength() > TX_FRAME_MAX_LEN) {
+            ESP_LOGW(BRIDGE_TAG, "bad frame of %d bytes from the client, dropped", this->framer.getFrameLength());
+            this->stats.nbBadFrames++;
+            this->framer.init();
+            continue;
+        }
+        this->state = BridgeState::READY;
+        this->receivedMs = cn105Millis();
+        return true;
+    }
+}
+
+// a frame of the client is on its way to the unit, or its response is awaited
+bool tcpBridge::isBusy() const {
+    return this->state == BridgeState::QUEUED || this->state == BridgeState::AWAITING;
+}
+
+void tcpBridge::queued(txHandle h) {
+    this->handle = h;
+    this->state = BridgeState::QUEUED;
+}
+
+void tcpBridge::sent() {
+    this->sentMs = cn105Millis();
+    this->state = BridgeState::AWAITING;
+
+    this->stats.nbFramesToUnit++;
+    this->stats.nbBytesToUnit += this->framer.getFrameLength();
+    this->stats.lastQueueWaitMs = elapsedMs(this->sentMs, this->receivedMs);
+    if (this->stats.lastQueueWaitMs > this->stats.maxQueueWaitMs) {
+        this->stats.maxQueueWaitMs = this->stats.lastQueueWaitMs;
+    }
+}
+
+/**
+ * the response of the unit, written as it is from the buffer of the component's framer
+*/
+void tcpBridge::forward(const uint8_t* frame, int length) {
+    this->stats.nbFramesFromUnit++;
+    this->stats.nbBytesFromUnit += length;
+    this->stats.lastLatencyMs = elapsedMs(cn105Millis(), this->receivedMs);
+    this->stats.totalLatencyMs += this->stats.lastLatencyMs;
+    if (this->stats.lastLatencyMs > this->stats.maxLatencyMs) {
+        this->stats.maxLatencyMs = this->stats.lastLatencyMs;
+    }
+    ESP_LOGD(BRIDGE_TAG, "response of %d bytes after %u ms (%u ms in queue)", length,
+        (unsigned int)this->stats.lastLatencyMs, (unsigned int)this->stats.lastQueueWaitMs);
+
+    // frames are shorter than any socket buffer: a partial write means the client stopped reading
+    if (this->client != nullptr && this->client->write(frame, length) != length) {
+        ESP_LOGW(BRIDGE_TAG, "client not reading, response dropped");
+        this->stats.nbDropped++;
+    }
+    this->reset();
+}
+
+void tcpBridge::drop() {
+    this->stats.nbDropped++;
+    this->reset();
+}
+
+void tcpBridge::timeout() {
+    ESP_LOGW(BRIDGE_TAG, "no response of the unit after %u ms", (unsigned int)TCP_BRIDGE_RESPONSE_TIMEOUT_MS);
+    this->stats.nbTimeouts++;
+    this->reset();
+}
+
+void tcpBridge::logStats() {
+    uint32_t nbResponses = this->stats.nbFramesFromUnit;
+    ESP_LOGI(BRIDGE_TAG, "clients: %u, frames to unit: %u (%u bytes), from unit: %u (%u bytes)",
+        (unsigned int)this->stats.nbClients, (unsigned int)this->stats.nbFramesToUnit, (unsigned int)this->stats.nbBytesToUnit,
+        (unsigned int)nbResponses, (unsigned int)this->stats.nbBytesFromUnit);
+    ESP_LOGI(BRIDGE_TAG, "bad frames: %u, dropped: %u, timeouts: %u", (unsigned int)this->stats.nbBadFrames,
+        (unsigned int)this->stats.nbDropped, (unsigned int)this->stats.nbTimeouts);
+    ESP_LOGI(BRIDGE_TAG, "latency: last %u ms, avg %u ms, max %u ms (queue wait max %u ms)",
+        (unsigned int)this->stats.lastLatencyMs, (unsigned int)(nbResponses > 0 ? this->stats.totalLatencyMs / nbResponses : 0),
+        (unsigned int)this->stats.maxLatencyMs, (unsigned int)this->stats.maxQueueWaitMs);
+}
+
+/**
+ * a frame already handed to the tx queue goes on: its response must still be kept from the component
+*/
+void tcpBridge::closeClient() {
+    ESP_LOGI(BRIDGE_TAG, "client %s disconnected", this->client->getpeername().c_str());
+    this->client->close();
+    this->client = nullptr;
+    if (!this->isBusy()) {
+        this->reset();
+    }
+    this->logStats();
+}
+
+void tcpBridge::reset() {
+    this->state = BridgeState::IDLE;
+    this->handle = TX_INVALID_HANDLE;
+    this->framer.init();
+}
+
+#endif
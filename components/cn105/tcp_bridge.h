@@ -0,0 +1,73 @@
+#pragma once
+#ifdef USE_CN105_TCP_BRIDGE
+#include "cn105_framer.h"
+#include "tx_queue.h"
+#include "esphome/components/socket/socket.h"
+
+#include <memory>
+
+static const uint32_t TCP_BRIDGE_RESPONSE_TIMEOUT_MS = 1000;   // the unit answers within ~200 ms
+static const uint32_t TCP_BRIDGE_READY_TIMEOUT_MS = 4000;      // like TX_SET_TIMEOUT_MS
+
+enum class BridgeState : uint8_t {
+    IDLE,                   // waiting for a frame of the client
+    READY,                  // a complete frame of the client waits for a gap in the poll cycle
+    QUEUED,                 // handed to the tx queue
+    AWAITING,               // sent, the next frame of the unit is its response
+};
+
+struct tcpBridgeStats {
+    uint32_t nbClients = 0;
+    uint32_t nbFramesToUnit = 0;
+    uint32_t nbFramesFromUnit = 0;
+    uint32_t nbBytesToUnit = 0;
+    uint32_t nbBytesFromUnit = 0;
+    uint32_t nbBadFrames = 0;               // checksum errors and frames too long for the tx queue
+    uint32_t nbDropped = 0;                 // no gap found in time, or the client could not take the response
+    uint32_t nbTimeouts = 0;                // sent, but not answered
+    uint32_t lastLatencyMs = 0;             // from the client frame to its response
+    uint32_t maxLatencyMs = 0;
+    uint32_t totalLatencyMs = 0;
+    uint32_t lastQueueWaitMs = 0;           // part of it spent waiting for the poll cycle
+    uint32_t maxQueueWaitMs = 0;
+};
+
+/**
+ * Serves the raw CN105 byte stream on a TCP port, like ser2net, to one client at a time
+ * (cn105ctl or any other CN105 tool through socat). The client frames are not written to the
+ * UART by the bridge: the component hands them to its tx queue between two poll cycles, and
+ * holds its own frames until the unit has answered, so the half-duplex line is never shared.
+ * The bytes of the client are framed where they land and the responses are written from the
+ * component's framer: the tx queue owns the only copy of a frame.
+*/
+struct tcpBridge {
+
+    uint16_t port = 0;
+    std::unique_ptr<esphome::socket::Socket> server;
+    std::unique_ptr<esphome::socket::Socket> client;
+    cn105Framer framer;                     // frame of the client
+    BridgeState state = BridgeState::IDLE;
+    txHandle handle = TX_INVALID_HANDLE;
+    uint32_t receivedMs = 0;                // the client frame was complete
+    uint32_t sentMs = 0;
+    uint32_t lastSetupMs = 0;
+    bool setupTried = false;
+    tcpBridgeStats stats;
+
+    bool setup();
+    void acceptClient();
+    bool readFrame();                       // true once a valid frame of the client is READY
+    bool isBusy() const;
+    void queued(txHandle h);
+    void sent();
+    void forward(const uint8_t* frame, int length);
+    void drop();
+    void timeout();
+    void logStats();
+
+private:
+    void closeClient();
+    void reset();
+};
+
+#endif
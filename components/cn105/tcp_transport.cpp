@@ -0,0 +1,208 @@
+#ifdef USE_CN105_TCP_TRANSPORT
+#include "tcp_transport.h"
+#include "cn105_clock.h"
+#include "esphome/core/log.h"
+
+#include <errno.h>
+#include <string.h>
+
+static const char* TCP_TRANSPORT_TAG = "TCP";
+
+/**
+ * starts a non blocking connection; true only if the bridge accepted it right away
+*/
+bool tcpTransport::open() {
+    if (this->connected) {
+        return true;
+    }
+    if (this->connecting) {
+        return false;                                   // poll() completes it
+    }
+
+    this->sock = esphome::socket::socket_ip(SOCK_STREAM, 0);
+    if (this->sock == nullptr) {
+        ESP_LOGW(TCP_TRANSPORT_TAG, "cannot create the socket: %s", strerror(errno));
+        return false;
+    }
+    this->sock->setblocking(false);
+
+    int enable = 1;
+    this->sock->setsockopt(IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(int));   // a frame is a request: no Nagle delay
+    // the liveness probes of the component see a silent unit, the keepalive a silent bridge
+    this->sock->setsockopt(SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(int));
+#if defined(TCP_KEEPIDLE) && defined(TCP_KEEPINTVL) && defined(TCP_KEEPCNT)
+    int idle = TCP_TRANSPORT_KEEPALIVE_IDLE_S;
+    int interval = TCP_TRANSPORT_KEEPALIVE_INTERVAL_S;
+    int count = TCP_TRANSPORT_KEEPALIVE_COUNT;
+    this->sock->setsockopt(IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(int));
+    this->sock->setsockopt(IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(int));
+    this->sock->setsockopt(IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(int));
+#endif
+
+    this->addrLen = esphome::socket::set_sockaddr((struct sockaddr*)&this->addr, sizeof(this->addr), this->host, this->port);
+    if (this->addrLen == 0) {
+        ESP_LOGE(TCP_TRANSPORT_TAG, "%s is not an IP address", this->host.c_str());
+        this->close();
+        return false;
+    }
+
+    this->connectStartMs = cn105Millis();
+    if (this->sock->connect((struct sockaddr*)&this->addr, this->addrLen) == 0) {
+        this->connectionUp();
+        return true;
+    }
+    if (errno != EINPROGRESS) {
+        ESP_LOGW(TCP_TRANSPORT_TAG, "cannot connect to %s:%u: %s", this->host.c_str(), this->port, strerror(errno));
+        this->close();
+        return false;
+    }
+    ESP_LOGI(TCP_TRANSPORT_TAG, "connecting to %s:%u...", this->host.c_str(), this->port);
+    this->connecting = true;
+    return false;
+}
+
+void tcpTransport::close() {
+    if (this->sock != nullptr) {
+        this->sock->close();
+        this->sock = nullptr;
+    }
+    this->connecting = false;
+    this->connected = false;
+    this->rxLength = 0;
+    this->rxIndex = 0;
+}
+
+/**
+ * A connection in progress is completed by calling connect() again: EISCONN once it is
+ * established, EALREADY (or EINPROGRESS) meanwhile, the error of the handshake otherwise.
+*/
+TransportEvent tcpTransport::poll() {
+    if (this->wasLost) {
+        this->wasLost = false;
+        return TransportEvent::DOWN;
+    }
+    if (!this->connecting) {
+        return TransportEvent::NONE;
+    }
+
+    if (this->sock->connect((struct sockaddr*)&this->addr, this->addrLen) == 0 || errno == EISCONN) {
+        this->connectionUp();
+        return TransportEvent::UP;
+    }
+    if (errno != EALREADY && errno != EINPROGRESS) {
+        ESP_LOGW(TCP_TRANSPORT_TAG, "cannot connect to %s:%u: %s", this->host.c_str(), this->port, strerror(errno));
+        this->close();
+    } else if (elapsedMs(cn105Millis(), this->connectStartMs) > TCP_TRANSPORT_CONNECT_TIMEOUT_MS) {
+        ESP_LOGW(TCP_TRANSPORT_TAG, "cannot connect to %s:%u: no answer", this->host.c_str(), this->port);
+        this->close();
+    }
+    return TransportEvent::NONE;
+}
+
+int tcpTransport::available() {
+    if (this->rxIndex >= this->rxLength && !this->fill()) {
+        return 0;
+    }
+    return this->rxLength - this->rxIndex;
+}
+
+bool tcpTransport::readByte(uint8_t* data) {
+    if (this->rxIndex >= this->rxLength && !this->fill()) {
+        return false;
+    }
+    *data = this->rxBuffer[this->rxIndex++];
+    return true;
+}
+
+/**
+ * frames are far shorter than the socket buffer: a write that does not fit means the bridge is
+ * gone (the keepalive will tell), so the frame is dropped rather than blocking loop(). Part of a
+ * frame would leave the unit out of sync with the next one: the connection is dropped instead.
+*/
+void tcpTransport::write(const uint8_t* data, int length) {
+    if (!this->connected) {
+        return;
+    }
+    ssize_t written = this->sock->write(data, length);
+    if (written < 0) {
+        if (errno != EWOULDBLOCK && errno != EAGAIN) {
+            this->lost(strerror(errno));
+        } else {
+            ESP_LOGW(TCP_TRANSPORT_TAG, "socket buffer full, frame of %d bytes dropped", length);
+        }
+        return;
+    }
+    this->nbBytesOut += written;
+    if (written != length) {
+        this->lost("short write, half a frame sent");
+        return;
+    }
+    this->sampleKernelRtt();
+}
+
+uint32_t tcpTransport::getFrameDurationMs(int length) {
+    return computeFrameDurationMs(length, this->baudRate, 11);      // 8E1
+}
+
+uint32_t tcpTransport::getRttMs() {
+    return this->rtt.avg;
+}
+
+void tcpTransport::logStats() {
+    ESP_LOGI(TCP_TRANSPORT_TAG, "%s:%u %s, connections: %u, lost: %u, bytes in: %u, out: %u", this->host.c_str(), this->port,
+        this->connected ? "connected" : (this->connecting ? "connecting" : "disconnected"),
+        (unsigned int)this->nbConnections, (unsigned int)this->nbLost, (unsigned int)this->nbBytesIn, (unsigned int)this->nbBytesOut);
+    ESP_LOGI(TCP_TRANSPORT_TAG, "round trip: last %u ms, avg %u ms, min %u ms, max %u ms (%u samples)",
+        (unsigned int)this->rtt.last, (unsigned int)this->rtt.avg, (unsigned int)this->rtt.min, (unsigned int)this->rtt.max,
+        (unsigned int)this->rtt.count);
+}
+
+// reads what the socket holds; false when there is nothing to read
+bool tcpTransport::fill() {
+    if (!this->connected) {
+        return false;
+    }
+    ssize_t length = this->sock->read(this->rxBuffer, TCP_TRANSPORT_RX_BUFFER_LEN);
+    if (length > 0) {
+        this->rxLength = length;
+        this->rxIndex = 0;
+        this->nbBytesIn += length;
+        return true;
+    }
+    if (length == 0) {
+        this->lost("closed by the bridge");
+    } else if (errno != EWOULDBLOCK && errno != EAGAIN) {
+        this->lost(strerror(errno));
+    }
+    return false;
+}
+
+// reported to the component by the next poll()
+void tcpTransport::lost(const char* reason) {
+    ESP_LOGW(TCP_TRANSPORT_TAG, "connection to %s:%u lost: %s", this->host.c_str(), this->port, reason);
+    this->nbLost++;
+    this->close();
+    this->wasLost = true;
+}
+
+void tcpTransport::connectionUp() {
+    this->connecting = false;
+    this->connected = true;
+    this->rxLength = 0;
+    this->rxIndex = 0;
+    this->nbConnections++;
+    this->rtt.add(elapsedMs(cn105Millis(), this->connectStartMs));       // SYN / SYN-ACK, at the loop resolution
+    ESP_LOGI(TCP_TRANSPORT_TAG, "connected to %s:%u (handshake %u ms)", this->host.c_str(), this->port, (unsigned int)this->rtt.last);
+}
+
+void tcpTransport::sampleKernelRtt() {
+#ifdef TCP_INFO
+    struct tcp_info info;
+    socklen_t length = sizeof(info);
+    if (this->sock->getsockopt(IPPROTO_TCP, TCP_INFO, &info, &length) == 0 && info.tcpi_rtt > 0) {
+        this->rtt.add((info.tcpi_rtt + 500) / 1000);                   // smoothed by the kernel, in µs
+    }
+#endif
+}
+
+#endif
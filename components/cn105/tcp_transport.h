@@ -0,0 +1,65 @@
+#pragma once
+#ifdef USE_CN105_TCP_TRANSPORT
+#include "cn105_transport.h"
+#include "esphome/components/socket/socket.h"
+
+#include <memory>
+#include <string>
+
+static const uint32_t TCP_TRANSPORT_CONNECT_TIMEOUT_MS = 5000;
+static const uint32_t TCP_TRANSPORT_KEEPALIVE_IDLE_S = 10;         // a silent peer is probed after this...
+static const uint32_t TCP_TRANSPORT_KEEPALIVE_INTERVAL_S = 2;      // ...every this...
+static const uint32_t TCP_TRANSPORT_KEEPALIVE_COUNT = 3;           // ...and dropped after this many misses
+static const int TCP_TRANSPORT_RX_BUFFER_LEN = 64;
+
+/**
+ * A serial to TCP bridge in front of the unit (ser2net, an ESP01 running esp-link or the
+ * tcp_bridge_port of this component, socat on a computer), reached by its IP address.
+ * Connections are non blocking: open() starts one, poll() tells when it is up or lost.
+ * The reconnections are paced by the component, like the connection packets.
+ *
+ * The round trip of the transport is kept apart from the unit's turnaround: it is sampled on
+ * the TCP handshake of each connection, and refreshed from the kernel's estimate where the
+ * stack exposes it (TCP_INFO, host platform). It is known at the loop resolution otherwise.
+*/
+struct tcpTransport : cn105Transport {
+    std::string host;
+    uint16_t port = 0;
+    uint32_t baudRate = 2400;               // serial line of the bridge, 8E1
+
+    std::unique_ptr<esphome::socket::Socket> sock;
+    struct sockaddr_storage addr;
+    socklen_t addrLen = 0;
+    bool connecting = false;
+    bool connected = false;
+    bool wasLost = false;                   // not reported by poll() yet
+    uint32_t connectStartMs = 0;
+    uint8_t rxBuffer[TCP_TRANSPORT_RX_BUFFER_LEN];
+    int rxLength = 0;
+    int rxIndex = 0;
+
+    latencyStats rtt;
+    uint32_t nbConnections = 0;
+    uint32_t nbLost = 0;
+    uint32_t nbBytesIn = 0;
+    uint32_t nbBytesOut = 0;
+
+    const char* getName() override { return "tcp"; }
+    bool open() override;
+    void close() override;
+    TransportEvent poll() override;
+    int available() override;
+    bool readByte(uint8_t* data) override;
+    void write(const uint8_t* data, int length) override;
+    uint32_t getFrameDurationMs(int length) override;
+    uint32_t getRttMs() override;
+    void logStats() override;
+
+private:
+    bool fill();
+    void lost(const char* reason);
+    void connectionUp();
+    void sampleKernelRtt();
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "tx_queue.h"
+#include "cn105_clock.h"
+#include "cn105_core_log.h"
+
+#include <string.h>
+
+static const char* TX_QUEUE_TAG = "CN105";
+
+void txQueue::init() {
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        slots[i].used = false;
+    }
+    for (int i = 0; i < TX_HISTORY_LEN; i++) {
+        history[i] = TX_INVALID_HANDLE;
+    }
+    historyIndex = 0;
+}
+
+txHandle txQueue::enqueue(const uint8_t* bytes, int length, TxPriority priority, uint32_t timeoutMs, bool checkIsActive) {
+    if (length <= 0 || length > TX_FRAME_MAX_LEN) {
+        ESP_LOGE(TX_QUEUE_TAG, "tx queue: invalid frame length %d", length);
+        nbRejected++;
+        return TX_INVALID_HANDLE;
+    }
+
+    txFrame* frame = findFreeSlot(priority);
+    if (frame == nullptr) {
+        ESP_LOGW(TX_QUEUE_TAG, "tx queue is full, frame 0x%02X dropped", length > 1 ? bytes[1] : 0);
+        nbRejected++;
+        return TX_INVALID_HANDLE;
+    }
+
+    lastHandle++;
+    if (lastHandle == TX_INVALID_HANDLE) {
+        lastHandle++;
+    }
+
+    frame->used = true;
+    frame->handle = lastHandle;
+    frame->priority = priority;
+    frame->checkIsActive = checkIsActive;
+    frame->length = length;
+    memcpy(frame->bytes, bytes, length);
+    frame->seq = ++lastSeq;
+    frame->enqueuedMs = cn105Millis();
+    frame->timeoutMs = timeoutMs;
+    nbQueued++;
+    return frame->handle;
+}
+
+/**
+ * a free slot, or when the queue is full, the slot of the oldest frame of lower priority
+*/
+txFrame* txQueue::findFreeSlot(TxPriority priority) {
+    txFrame* victim = nullptr;
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        if (!slots[i].used) {
+            return &slots[i];
+        }
+        if ((slots[i].priority < priority) &&
+            ((victim == nullptr) || (slots[i].priority < victim->priority) ||
+                ((slots[i].priority == victim->priority) && (slots[i].seq < victim->seq)))) {
+            victim = &slots[i];
+        }
+    }
+    if (victim != nullptr) {
+        ESP_LOGW(TX_QUEUE_TAG, "tx queue is full, evicting frame 0x%02X", victim->bytes[1]);
+        complete(victim, TxStatus::EVICTED);
+    }
+    return victim;
+}
+
+txFrame* txQueue::next() {
+    uint32_t now = cn105Millis();
+    txFrame* best = nullptr;
+
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        txFrame* frame = &slots[i];
+        if (!frame->used) {
+            continue;
+        }
+        if (elapsedMs(now, frame->enqueuedMs) >= frame->timeoutMs) {
+            ESP_LOGW(TX_QUEUE_TAG, "tx queue: frame 0x%02X expired before it could be sent", frame->bytes[1]);
+            complete(frame, TxStatus::EXPIRED);
+            continue;
+        }
+        if ((best == nullptr) || (frame->priority > best->priority) ||
+            ((frame->priority == best->priority) && (frame->seq < best->seq))) {
+            best = frame;
+        }
+    }
+    return best;
+}
+
+void txQueue::complete(txFrame* frame, TxStatus status) {
+    switch (status) {
+    case TxStatus::SENT:
+        nbSent++;
+        break;
+    case TxStatus::EXPIRED:
+        nbExpired++;
+        break;
+    case TxStatus::EVICTED:
+        nbEvicted++;
+        break;
+    default:
+        break;
+    }
+    remember(frame->handle, status);
+    frame->used = false;
+}
+
+void txQueue::remember(txHandle handle, TxStatus status) {
+    history[historyIndex] = handle;
+    historyStatus[historyIndex] = status;
+    historyIndex = (historyIndex + 1) % TX_HISTORY_LEN;
+}
+
+TxStatus txQueue::getStatus(txHandle handle) {
+    if (handle == TX_INVALID_HANDLE) {
+        return TxStatus::UNKNOWN;
+    }
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        if (slots[i].used && slots[i].handle == handle) {
+            return TxStatus::QUEUED;
+        }
+    }
+    for (int i = 0; i < TX_HISTORY_LEN; i++) {
+        if (history[i] == handle) {
+            return historyStatus[i];
+        }
+    }
+    return TxStatus::UNKNOWN;
+}
+
+int txQueue::size() {
+    int count = 0;
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        count += slots[i].used ? 1 : 0;
+    }
+    return count;
+}
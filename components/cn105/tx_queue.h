@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+static const int TX_QUEUE_SLOTS = 8;                // fixed pool, no heap use
+static const int TX_FRAME_MAX_LEN = 22;             // PACKET_LEN, the longest frame we send
+static const int TX_HISTORY_LEN = 8;                // completed frames whose status can still be queried
+
+// how long a frame may wait in the tx queue for the link before being dropped
+static const uint32_t TX_REQUEST_TIMEOUT_MS = 1000;     // info requests, a new cycle will ask again
+static const uint32_t TX_SET_TIMEOUT_MS = 4000;         // set packets, worth waiting for a reconnection
+static const uint32_t TX_CONNECT_TIMEOUT_MS = 1000;
+
+typedef uint16_t txHandle;
+static const txHandle TX_INVALID_HANDLE = 0;
+
+// among queued frames, the highest priority is sent first, then the oldest
+// (not LOW/HIGH: Arduino.h defines them as macros)
+enum class TxPriority : uint8_t {
+    PRIO_LOW = 0,           // info requests of the polling cycle
+    PRIO_NORMAL,            // set packets (settings, remote temperature, run states, functions)
+    PRIO_HIGH,              // connection packet
+};
+
+enum class TxStatus : uint8_t {
+    UNKNOWN = 0,            // invalid handle, or completed too long ago
+    QUEUED,
+    SENT,
+    EXPIRED,                // deadline reached before the link could take it
+    EVICTED,                // pushed out of a full queue by a more important frame
+};
+
+struct txFrame {
+    bool used = false;
+    txHandle handle = TX_INVALID_HANDLE;
+    TxPriority priority = TxPriority::PRIO_LOW;
+    bool checkIsActive = true;              // only sent while the heatpump is answering (false for connect)
+    uint8_t length = 0;
+    uint8_t bytes[TX_FRAME_MAX_LEN];
+    uint32_t seq = 0;
+    uint32_t enqueuedMs = 0;
+    uint32_t timeoutMs = 0;
+};
+
+/**
+ * Owned transmit queue: writers hand over a copy of their frame and get a handle they can poll
+ * (getStatus) to know whether it was sent. Frames are serialised to the UART from loop() only.
+*/
+struct txQueue {
+
+    txFrame slots[TX_QUEUE_SLOTS];
+    txHandle history[TX_HISTORY_LEN] = {};
+    TxStatus historyStatus[TX_HISTORY_LEN] = {};
+    int historyIndex = 0;
+    txHandle lastHandle = TX_INVALID_HANDLE;
+    uint32_t lastSeq = 0;
+
+    uint32_t nbQueued = 0;
+    uint32_t nbSent = 0;
+    uint32_t nbExpired = 0;
+    uint32_t nbEvicted = 0;
+    uint32_t nbRejected = 0;
+
+    void init();
+    txHandle enqueue(const uint8_t* bytes, int length, TxPriority priority, uint32_t timeoutMs, bool checkIsActive);
+    txFrame* next();                        // the frame to send now, expired frames are released on the way
+    void complete(txFrame* frame, TxStatus status);
+    TxStatus getStatus(txHandle handle);
+    int size();
+
+private:
+    txFrame* findFreeSlot(TxPriority priority);
+    void remember(txHandle handle, TxStatus status);
+};
@@ -0,0 +1,36 @@
+#include "uart_transport.h"
+#include "esphome/core/log.h"
+
+static const char* UART_TRANSPORT_TAG = "CN105";
+
+// SERIAL_8E1
+bool uartTransport::open() {
+    ESP_LOGI(UART_TRANSPORT_TAG, "setupUART() with baudrate %u", (unsigned int)this->uart->get_baud_rate());
+
+    if (this->uart->get_data_bits() == 8 &&
+        this->uart->get_parity() == esphome::uart::UART_CONFIG_PARITY_EVEN &&
+        this->uart->get_stop_bits() == 1) {
+        ESP_LOGD(UART_TRANSPORT_TAG, "UART est configuré en SERIAL_8E1");
+        return true;
+    }
+    ESP_LOGW(UART_TRANSPORT_TAG, "UART n'est pas configuré en SERIAL_8E1");
+    return false;
+}
+
+int uartTransport::available() {
+    return this->uart->available();
+}
+
+bool uartTransport::readByte(uint8_t* data) {
+    return this->uart->read_byte(data);
+}
+
+void uartTransport::write(const uint8_t* data, int length) {
+    this->uart->write_array(data, length);
+}
+
+uint32_t uartTransport::getFrameDurationMs(int length) {
+    uint32_t bitsPerByte = 1 + this->uart->get_data_bits() + this->uart->get_stop_bits() +
+        (this->uart->get_parity() == esphome::uart::UART_CONFIG_PARITY_NONE ? 0 : 1);
+    return computeFrameDurationMs(length, this->uart->get_baud_rate(), bitsPerByte);
+}
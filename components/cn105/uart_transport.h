@@ -0,0 +1,17 @@
+#pragma once
+#include "cn105_transport.h"
+#include "esphome/components/uart/uart.h"
+
+/**
+ * The UART of the ESP, wired to the CN105 connector: always open once configured as 8E1
+*/
+struct uartTransport : cn105Transport {
+    esphome::uart::UARTComponent* uart = nullptr;
+
+    const char* getName() override { return "uart"; }
+    bool open() override;
+    int available() override;
+    bool readByte(uint8_t* data) override;
+    void write(const uint8_t* data, int length) override;
+    uint32_t getFrameDurationMs(int length) override;
+};
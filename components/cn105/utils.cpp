@@ -1,5 +1,8 @@
 #include "cn105.h"
 #include "Globals.h"
+#ifdef USE_LOGGER
+#include "esphome/components/logger/logger.h"
+#endif
 
 using namespace esphome;
 
@@ -149,74 +152,29 @@ void CN105Climate::debugSettingsAndStatus(const char* settingName, heatpumpSetti
 
 
 
-void CN105Climate::hpPacketDebug(uint8_t* packet, unsigned int length, const char* packetDirection) {
-    char buffer[4]; // Small buffer to store each byte as text
-    char outputBuffer[length * 4 + 1]; // Buffer to store all bytes as text
-
-    // Initialisation du tampon de sortie avec une chaîne vide
-    outputBuffer[0] = '\0';
+/**
+ * records every frame in the binary trace; the live READ/WRITE log line is only formatted
+ * when debug logs are compiled in and the logger lets them through for that tag at runtime
+ * (level of the logger, or its logs: filter)
+*/
+void CN105Climate::hpPacketDebug(const uint8_t* packet, unsigned int length, TraceDirection direction) {
+    this->trace.record(cn105Millis(), direction, packet, length);
 
-    for (unsigned int i = 0; i < length; i++) {
-        snprintf(buffer, sizeof(buffer), "%02X ", packet[i]); // Using snprintf to avoid buffer overflows
-        strcat(outputBuffer, buffer);
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG && defined(USE_LOGGER)
+    const char* tag = direction == TraceDirection::TX ? "WRITE" : "READ";
+    if (logger::global_logger == nullptr || logger::global_logger->level_for(tag) < ESPHOME_LOG_LEVEL_DEBUG) {
+        return;
     }
-
-    char outputForSensor[15];
-    strncpy(outputForSensor, outputBuffer, 14);
-    outputForSensor[14] = '\0'; // Ajouter un caract
-
-    /*if (strcasecmp(packetDirection, "WRITE") == 0) {
-        this->last_sent_packet_sensor->publish_state(outputForSensor);
-    }*/
-
-    ESP_LOGD(packetDirection, "%s", outputBuffer);
+    char hex[MAX_DATA_BYTES * 3 + 1];
+    packetTrace::formatFrame(packet, length, hex, sizeof(hex));
+    ESP_LOGD(tag, "%s", hex);
+#endif
 }
 
-
-int CN105Climate::lookupByteMapIndex(const int valuesMap[], int len, int lookupValue, const char* debugInfo) {
-    for (int i = 0; i < len; i++) {
-        if (valuesMap[i] == lookupValue) {
-            return i;
-        }
-    }
-    ESP_LOGW("lookup", "%s caution value %d not found, returning -1", debugInfo, lookupValue);
-    //esphome::delay(200);
-    return -1;
-}
-int CN105Climate::lookupByteMapIndex(const char* valuesMap[], int len, const char* lookupValue, const char* debugInfo) {
-    for (int i = 0; i < len; i++) {
-        if (strcasecmp(valuesMap[i], lookupValue) == 0) {
-            return i;
-        }
-    }
-    ESP_LOGW("lookup", "%s caution value %s not found, returning -1", debugInfo, lookupValue);
-    //esphome::delay(200);
-    return -1;
+void CN105Climate::dumpPacketTrace() {
+    this->trace.dump(LOG_TRACE_TAG);
 }
-const char* CN105Climate::lookupByteMapValue(const char* valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo, const char* defaultValue) {
-    for (int i = 0; i < len; i++) {
-        if (byteMap[i] == byteValue) {
-            return valuesMap[i];
-        }
-    }
-
-    if (defaultValue != nullptr) {
-        return defaultValue;
-    } else {
-        ESP_LOGW("lookup", "%s caution: value %d not found, returning value at index 0", debugInfo, byteValue);
-        return valuesMap[0];
-    }
 
-}
-int CN105Climate::lookupByteMapValue(const int valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo) {
-    for (int i = 0; i < len; i++) {
-        if (byteMap[i] == byteValue) {
-            return valuesMap[i];
-        }
-    }
-    ESP_LOGW("lookup", "%s caution: value %d not found, returning value at index 0", debugInfo, byteValue);
-    return valuesMap[0];
-}
 
 #ifndef USE_ESP32
 /**
@@ -307,15 +265,15 @@ void CN105Climate::testCase1() {
     ESP_LOGI("testMutex", "verrouillage du mutex...");
     this->esp8266Mutex = true;
     this->testEmulateMutex("testMutex", std::bind(&CN105Climate::logDelegate, this));
-    CUSTOM_DELAY(testDelay);
+    cn105Delay(testDelay);
     ESP_LOGI("testMutex", "Déverrouillage du mutex...");
     this->esp8266Mutex = false;
-    CUSTOM_DELAY(200);
+    cn105Delay(200);
     ESP_LOGI("testMutex", "verrouillage du mutex...");
     this->esp8266Mutex = true;
     this->testEmulateMutex("testMutex", std::bind(&CN105Climate::logDelegate, this));
     ESP_LOGI("testMutex", "blocage de 2,5s...");
-    CUSTOM_DELAY(2500);
+    cn105Delay(2500);
     ESP_LOGI("testMutex", "fin du test");
 
 #endif
@@ -0,0 +1,53 @@
+#include "wanted_settings.h"
+#include "cn105_encoders.h"
+
+#include <string.h>
+
+const char* mergeWideVane(wantedHeatpumpSettings& wanted, const heatpumpSettings& current) {
+    if (wanted.wideVane) {
+        if (strcmp(wanted.wideVane, lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, 0x80 & 0x0F)) == 0 && !current.iSee) {
+            wanted.wideVane = current.wideVane;
+        }
+        return wanted.wideVane;
+    } else {
+        return current.wideVane;
+    }
+}
+
+void mergeWantedSettings(uint8_t* packet, wantedHeatpumpSettings& wanted, const heatpumpSettings& current, bool tempMode, bool wideVaneAdj) {
+    wanted.hasBeenSent = true;
+
+    // only the wanted fields are written (see encodeSettings)
+    heatpumpSettings merged{};
+    merged = wanted;
+    if (merged.wideVane != nullptr) {
+        merged.wideVane = mergeWideVane(wanted, current);
+    }
+    encodeSettings(packet, merged, tempMode, wideVaneAdj);
+}
+
+void mergeWantedRunStates(uint8_t* packet, const wantedHeatpumpRunStates& wanted) {
+    // all the wanted run states are written (see encodeRunStates), even the ones equal to the last
+    // read: a switch turned on then off before the unit was read again would be lost otherwise
+    heatpumpRunStates merged{};
+    merged.resetSettings();
+    merged.airflow_control = wanted.airflow_control;
+    if (wanted.air_purifier > -1) {
+        merged.air_purifier = wanted.air_purifier ? 1 : 0;
+    }
+    if (wanted.night_mode > -1) {
+        merged.night_mode = wanted.night_mode ? 1 : 0;
+    }
+    if (wanted.circulator > -1) {
+        merged.circulator = wanted.circulator ? 1 : 0;
+    }
+    encodeRunStates(packet, merged);
+}
+
+void consumeWantedSettings(wantedHeatpumpSettings& wanted) {
+    wanted.resetSettings();
+}
+
+void consumeWantedRunStates(wantedHeatpumpRunStates& wanted) {
+    wanted.resetSettings();
+}
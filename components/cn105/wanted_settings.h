@@ -0,0 +1,18 @@
+#pragma once
+#include "cn105_types.h"
+
+/**
+ * The wanted settings and run states of the component, merged with the last known state of the
+ * unit into the frames that are written, then consumed. The caller holds the settings lock, if any.
+*/
+
+// wide vane to write: the wanted one, except AIRFLOW CONTROL without iSee, replaced by the current one
+const char* mergeWideVane(wantedHeatpumpSettings& wanted, const heatpumpSettings& current);
+// 0x41 0x01 of the wanted settings (see encodeSettings()), which are marked as sent
+void mergeWantedSettings(uint8_t* packet, wantedHeatpumpSettings& wanted, const heatpumpSettings& current, bool tempMode, bool wideVaneAdj);
+// 0x41 0x08 of the wanted run states (see encodeRunStates())
+void mergeWantedRunStates(uint8_t* packet, const wantedHeatpumpRunStates& wanted);
+
+// once written and published: nothing is wanted until the next change
+void consumeWantedSettings(wantedHeatpumpSettings& wanted);
+void consumeWantedRunStates(wantedHeatpumpRunStates& wanted);
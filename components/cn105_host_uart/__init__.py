@@ -0,0 +1,31 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import uart
+from esphome.const import CONF_ID, CONF_BAUD_RATE, CONF_PORT
+from esphome.core import coroutine
+
+# UART of the host platform: the cn105 climate runs as a Linux process, on a tty or on the
+# pseudo-terminal of tools/emulator/cn105_emulator_pty (see host-test.yaml)
+AUTO_LOAD = ["uart"]
+MULTI_CONF = True
+
+CN105HostUART = cg.global_ns.class_("CN105HostUART", uart.UARTComponent, cg.Component)
+
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(CN105HostUART),
+            cv.Required(CONF_PORT): cv.string,
+            cv.Optional(CONF_BAUD_RATE, default=2400): cv.int_range(min=1),
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    cv.only_on(["host"]),
+)
+
+
+@coroutine
+def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    yield cg.register_component(var, config)
+    cg.add(var.set_port(config[CONF_PORT]))
+    cg.add(var.set_baud_rate(config[CONF_BAUD_RATE]))
@@ -0,0 +1,188 @@
+#ifdef USE_HOST
+#include "host_uart.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace esphome {
+
+    static const char* HOST_UART_TAG = "HOST_UART";
+    static const int READ_TIMEOUT_MS = 100;     // read_array() waits this long for missing bytes
+    static const int WRITE_MARGIN_MS = 100;     // write_array() waits the frame time plus this for a full line
+
+    static speed_t toSpeed(uint32_t baudRate) {
+        switch (baudRate) {
+        case 1200: return B1200;
+        case 2400: return B2400;
+        case 4800: return B4800;
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        default: return B0;
+        }
+    }
+
+    void CN105HostUART::setup() {
+        this->fd_ = open(this->port_.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (this->fd_ < 0) {
+            ESP_LOGE(HOST_UART_TAG, "cannot open %s: %s", this->port_.c_str(), strerror(errno));
+            this->mark_failed();
+            return;
+        }
+        if (!this->configureLine()) {
+            ESP_LOGE(HOST_UART_TAG, "cannot configure %s: %s", this->port_.c_str(), strerror(errno));
+            close(this->fd_);
+            this->fd_ = -1;
+            this->mark_failed();
+        }
+    }
+
+    /**
+     * raw mode with the settings of the UARTComponent; a pty transmits no bits,
+     * so the parity is dropped when its kernel refuses it
+    */
+    bool CN105HostUART::configureLine() {
+        struct termios tio;
+        if (tcgetattr(this->fd_, &tio) != 0) {
+            return false;
+        }
+        cfmakeraw(&tio);
+        tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag |= this->data_bits_ == 7 ? CS7 : this->data_bits_ == 6 ? CS6 : this->data_bits_ == 5 ? CS5 : CS8;
+        if (this->parity_ != uart::UART_CONFIG_PARITY_NONE) {
+            tio.c_cflag |= PARENB;
+        }
+        if (this->parity_ == uart::UART_CONFIG_PARITY_ODD) {
+            tio.c_cflag |= PARODD;
+        }
+        if (this->stop_bits_ == 2) {
+            tio.c_cflag |= CSTOPB;
+        }
+        speed_t speed = toSpeed(this->baud_rate_);
+        if (speed == B0) {
+            ESP_LOGW(HOST_UART_TAG, "baud rate %u not supported, using 2400", (unsigned int)this->baud_rate_);
+            speed = B2400;
+        }
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        if (tcsetattr(this->fd_, TCSANOW, &tio) == 0) {
+            return true;
+        }
+        tio.c_cflag &= ~(PARENB | PARODD);
+        this->parityIgnored_ = true;
+        return tcsetattr(this->fd_, TCSANOW, &tio) == 0;
+    }
+
+    void CN105HostUART::dump_config() {
+        ESP_LOGCONFIG(HOST_UART_TAG, "Host UART:");
+        ESP_LOGCONFIG(HOST_UART_TAG, "  Port: %s", this->port_.c_str());
+        ESP_LOGCONFIG(HOST_UART_TAG, "  Baud Rate: %u", (unsigned int)this->baud_rate_);
+        ESP_LOGCONFIG(HOST_UART_TAG, "  Data Bits: %u, Stop Bits: %u, Parity: %s", this->data_bits_, this->stop_bits_,
+            this->parity_ == uart::UART_CONFIG_PARITY_NONE ? "NONE" : this->parity_ == uart::UART_CONFIG_PARITY_EVEN ? "EVEN" : "ODD");
+        if (this->parityIgnored_) {
+            ESP_LOGCONFIG(HOST_UART_TAG, "  Parity refused by the device (pty), ignored");
+        }
+    }
+
+    /**
+     * the line drains at the baud rate: past the time of the frame plus a margin, the other side
+     * is not reading and the rest is dropped rather than blocking the loop
+    */
+    void CN105HostUART::write_array(const uint8_t* data, size_t len) {
+        if (this->fd_ < 0) {
+            return;
+        }
+        uint32_t bitsPerByte = 1 + this->data_bits_ + (this->parity_ != uart::UART_CONFIG_PARITY_NONE ? 1 : 0) + this->stop_bits_;
+        uint32_t timeoutMs = (len * bitsPerByte * 1000 + this->baud_rate_ - 1) / this->baud_rate_ + WRITE_MARGIN_MS;
+        uint32_t startMs = millis();
+        size_t total = len;
+        while (len > 0) {
+            ssize_t written = write(this->fd_, data, len);
+            if (written < 0 && errno == EAGAIN) {
+                uint32_t elapsed = millis() - startMs;
+                if (elapsed >= timeoutMs) {
+                    ESP_LOGW(HOST_UART_TAG, "write timed out, %u of %u bytes dropped", (unsigned int)len, (unsigned int)total);
+                    return;
+                }
+                struct pollfd pfd = { this->fd_, POLLOUT, 0 };
+                poll(&pfd, 1, timeoutMs - elapsed);
+                continue;
+            }
+            if (written < 0) {
+                ESP_LOGW(HOST_UART_TAG, "write: %s", strerror(errno));
+                return;
+            }
+            data += written;
+            len -= written;
+        }
+    }
+
+    bool CN105HostUART::peek_byte(uint8_t* data) {
+        if (!this->hasPeek_) {
+            if (this->fd_ < 0 || read(this->fd_, &this->peek_, 1) != 1) {
+                return false;
+            }
+            this->hasPeek_ = true;
+        }
+        *data = this->peek_;
+        return true;
+    }
+
+    /**
+     * all or nothing, as the UARTComponent of the ESP platforms: waits up to READ_TIMEOUT_MS for
+     * len bytes, and consumes none when they are not there
+    */
+    bool CN105HostUART::read_array(uint8_t* data, size_t len) {
+        uint32_t startMs = millis();
+        while ((size_t)this->available() < len) {
+            if (this->fd_ < 0 || millis() - startMs >= (uint32_t)READ_TIMEOUT_MS) {
+                ESP_LOGW(HOST_UART_TAG, "read timed out, %d of %u bytes available", this->available(), (unsigned int)len);
+                return false;
+            }
+            poll(nullptr, 0, 1);
+        }
+        if (len > 0 && this->hasPeek_) {
+            *data++ = this->peek_;
+            this->hasPeek_ = false;
+            len--;
+        }
+        while (len > 0 && this->fd_ >= 0) {
+            ssize_t length = read(this->fd_, data, len);
+            if (length > 0) {
+                data += length;
+                len -= length;
+                continue;
+            }
+            if (length == 0 || errno != EAGAIN) {
+                return false;                   // closed by the other side, or an error
+            }
+        }
+        return len == 0;
+    }
+
+    int CN105HostUART::available() {
+        int pending = 0;
+        if (this->fd_ < 0 || ioctl(this->fd_, FIONREAD, &pending) != 0) {
+            pending = 0;
+        }
+        return pending + (this->hasPeek_ ? 1 : 0);
+    }
+
+    void CN105HostUART::flush() {
+        if (this->fd_ >= 0) {
+            tcdrain(this->fd_);
+        }
+    }
+
+}
+#endif
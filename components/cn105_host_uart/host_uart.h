@@ -0,0 +1,41 @@
+#pragma once
+#ifdef USE_HOST
+#include "esphome/core/component.h"
+#include "esphome/components/uart/uart.h"
+
+#include <string>
+
+namespace esphome {
+
+    /**
+     * UART of the host platform, on a tty: a USB serial adapter wired to the CN105 connector, or the
+     * slave side of the pseudo-terminal of cn105_emulator_pty. Raw, non blocking, with the data bits,
+     * parity and stop bits set on it by the cn105 climate (8E1).
+    */
+    class CN105HostUART : public uart::UARTComponent, public Component {
+    public:
+        void set_port(const std::string& port) { this->port_ = port; }
+
+        void setup() override;
+        void dump_config() override;
+        float get_setup_priority() const override { return setup_priority::BUS; }
+
+        void write_array(const uint8_t* data, size_t len) override;
+        bool peek_byte(uint8_t* data) override;
+        bool read_array(uint8_t* data, size_t len) override;
+        int available() override;
+        void flush() override;
+
+    protected:
+        void check_logger_conflict() override {}            // the logger writes to stdout
+        bool configureLine();
+
+        std::string port_;
+        int fd_ = -1;
+        bool hasPeek_ = false;
+        uint8_t peek_ = 0;
+        bool parityIgnored_ = false;                        // ptys of some kernels refuse PARENB
+    };
+
+}
+#endif
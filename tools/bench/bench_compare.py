@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""Compares two JSON outputs of cn105_bench (or cn105_latency) and flags the regressions.
+
+    python3 tools/bench/bench_compare.py baseline.json current.json [--threshold 10]
+
+Exits with 1 when a benchmark is slower than the baseline by more than the threshold (in %).
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as input_file:
+        report = json.load(input_file)
+    times = {}
+    for bench in report["benchmarks"]:
+        # with --benchmark_repetitions, the median is the value to compare
+        if bench.get("run_type") == "aggregate" and bench.get("aggregate_name") != "median":
+            continue
+        times[bench["run_name"] if bench.get("run_type") == "aggregate" else bench["name"]] = bench["cpu_time"]
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0, help="regression threshold in %% (default 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+    print("%-60s %12s %12s %8s" % ("benchmark", "baseline", "current", "change"))
+    for name, time in current.items():
+        if name not in baseline:
+            print("%-60s %12s %12.1f %8s" % (name, "-", time, "new"))
+            continue
+        change = (time - baseline[name]) * 100.0 / baseline[name] if baseline[name] > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-60s %12.1f %12.1f %+7.1f%%%s" % (name, baseline[name], time, change, flag))
+    for name in baseline:
+        if name not in current:
+            print("%-60s %12.1f %12s %8s" % (name, baseline[name], "-", "removed"))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,272 @@
+/**
+ * Micro-benchmarks of the hot paths of the component, run on the host against the protocol core:
+ * framing (parse() per byte), checksum, decoding of the info responses with the state comparison
+ * (cn105State::decodeInfoResponse() and applyInfoResponse(), as getDataFromResponsePacket() calls them), encoding of the requests (createPacket(), createInfoPacket()),
+ * map lookups and the packet trace of hpPacketDebug().
+ * Publications go to a sink that only counts them: the ESPHome publish_state() cost is not measured.
+ *
+ * Built by the CMakeLists.txt at the root of the repository with -DCN105_BENCH=ON (target cn105_bench),
+ * see tools/README.md for the JSON output and the comparison of two runs.
+*/
+#include "cn105_framer.h"
+#include "cn105_decoders.h"
+#include "cn105_encoders.h"
+#include "cn105_state.h"
+#include "packet_trace.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <vector>
+
+extern int cn105_host_log_level;
+
+// responses documented in hp_readings.cpp (same frames as the fuzz seed corpus)
+static const uint8_t SETTINGS_FRAME[] = { 0xFC, 0x62, 0x01, 0x30, 0x10, 0x02, 0x00, 0x00, 0x01, 0x03, 0x0B, 0x00, 0x00, 0x00, 0x00, 0x03, 0xAA, 0x00, 0x00, 0x00, 0x00, 0x9F };
+static const uint8_t ROOM_TEMPERATURE_FRAME[] = { 0xFC, 0x62, 0x01, 0x30, 0x10, 0x03, 0x00, 0x00, 0x0E, 0x00, 0x94, 0xB0, 0xB0, 0xFE, 0x42, 0x00, 0x01, 0x0A, 0x64, 0x00, 0x00, 0xA9 };
+static const uint8_t STATUS_FRAME[] = { 0xFC, 0x62, 0x01, 0x30, 0x10, 0x06, 0x00, 0x00, 0x00, 0x01, 0x00, 0x08, 0x05, 0x50, 0x00, 0x00, 0x42, 0x00, 0x00, 0x00, 0x00, 0xB7 };
+static const uint8_t STAGE_FRAME[] = { 0xFC, 0x62, 0x01, 0x30, 0x10, 0x09, 0x00, 0x00, 0x00, 0x02, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50 };
+static const uint8_t HVAC_OPTIONS_FRAME[] = { 0xFC, 0x62, 0x01, 0x30, 0x10, 0x42, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18 };
+
+/**
+ * Stands for the climate and sensors publish_state() calls of the component
+*/
+struct publishSink {
+    uint32_t nbPublished = 0;
+
+    void publish(uint32_t changed) {
+        for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+            if (changed & (1UL << i)) {
+                this->nbPublished++;
+            }
+        }
+        benchmark::DoNotOptimize(this->nbPublished);
+    }
+
+    // the settings are published at once, by the climate entity
+    void publishClimate() {
+        this->nbPublished++;
+        benchmark::DoNotOptimize(this->nbPublished);
+    }
+};
+
+static std::vector<uint8_t> makeFrame(const uint8_t* frame, int length) {
+    return std::vector<uint8_t>(frame, frame + length);
+}
+
+// copy of the frame with one data byte changed and the checksum fixed, to alternate with the original
+static std::vector<uint8_t> makeChangedFrame(const uint8_t* frame, int length, int dataIndex) {
+    std::vector<uint8_t> changed = makeFrame(frame, length);
+    changed[5 + dataIndex] ^= 0x01;
+    changed[length - 1] = computeChecksum(changed.data(), length - 1);
+    return changed;
+}
+
+//#region framing
+
+// parse() of the component: bytes go through the framer, a complete frame is checked
+static void BM_ParsePerByte(benchmark::State& bench) {
+    std::vector<uint8_t> stream;
+    const uint8_t* frames[] = { SETTINGS_FRAME, ROOM_TEMPERATURE_FRAME, STATUS_FRAME, STAGE_FRAME, HVAC_OPTIONS_FRAME };
+    for (const uint8_t* frame : frames) {
+        stream.insert(stream.end(), frame, frame + PACKET_LEN);
+    }
+    cn105Framer framer;
+    framer.init();
+    int nbFrames = 0;
+
+    for (auto _ : bench) {
+        for (uint8_t b : stream) {
+            if (framer.push(b)) {
+                nbFrames += framer.isChecksumValid();
+                framer.init();
+            }
+        }
+        benchmark::DoNotOptimize(nbFrames);
+    }
+    bench.SetBytesProcessed(bench.iterations() * stream.size());
+    bench.SetItemsProcessed(bench.iterations() * stream.size());    // items/s: bytes, i.e. parse() calls
+}
+BENCHMARK(BM_ParsePerByte);
+
+static void BM_Checksum(benchmark::State& bench) {
+    for (auto _ : bench) {
+        benchmark::DoNotOptimize(computeChecksum(SETTINGS_FRAME, PACKET_LEN - 1));
+    }
+}
+BENCHMARK(BM_Checksum);
+
+//#endregion
+
+//#region decoding
+
+/**
+ * One response decoded into the state model and the changes published, through the calls of
+ * CN105Climate::getDataFromResponsePacket(): the settings of 0x02 are only compared, as
+ * heatpumpUpdate() does before publishing them.
+ * range(0): 0 the same frame every time (nothing changes, the common case),
+ * 1 alternating with a frame that differs by one byte (every call publishes)
+*/
+static void benchResponse(benchmark::State& bench, const uint8_t* frame, int changedDataIndex) {
+    std::vector<uint8_t> frames[2] = { makeFrame(frame, PACKET_LEN), makeFrame(frame, PACKET_LEN) };
+    if (bench.range(0) == 1) {
+        frames[1] = makeChangedFrame(frame, PACKET_LEN, changedDataIndex);
+    }
+    decodeOptions options{ true, false };
+    cn105State state;
+    state.init();
+    publishSink sink;
+    unsigned int i = 0;
+
+    for (auto _ : bench) {
+        infoResponse response = state.decodeInfoResponse(frames[i++ & 1].data() + 5, options);
+        uint32_t changed = state.applyInfoResponse(response);
+        sink.publish(changed);
+        if (response.code == 0x02 && response.settings.settings != state.settings) {
+            state.settings = response.settings.settings;
+            sink.publishClimate();
+        }
+    }
+    bench.counters["published"] = benchmark::Counter(sink.nbPublished, benchmark::Counter::kAvgIterations);
+}
+
+static void BM_InfoResponseSettings(benchmark::State& bench) {
+    benchResponse(bench, SETTINGS_FRAME, 11);      // setpoint, 0.5°C format
+}
+BENCHMARK(BM_InfoResponseSettings)->Arg(0)->Arg(1);
+
+static void BM_InfoResponseRoomTemperature(benchmark::State& bench) {
+    benchResponse(bench, ROOM_TEMPERATURE_FRAME, 6);  // room temperature, 0.5°C format
+}
+BENCHMARK(BM_InfoResponseRoomTemperature)->Arg(0)->Arg(1);
+
+static void BM_InfoResponseStatus(benchmark::State& bench) {
+    benchResponse(bench, STATUS_FRAME, 3);         // compressor frequency
+}
+BENCHMARK(BM_InfoResponseStatus)->Arg(0)->Arg(1);
+
+static void BM_InfoResponseStage(benchmark::State& bench) {
+    benchResponse(bench, STAGE_FRAME, 4);          // stage (0x09 response)
+}
+BENCHMARK(BM_InfoResponseStage)->Arg(0)->Arg(1);
+
+static void BM_InfoResponseHVACOptions(benchmark::State& bench) {
+    benchResponse(bench, HVAC_OPTIONS_FRAME, 1);   // air purifier
+}
+BENCHMARK(BM_InfoResponseHVACOptions)->Arg(0)->Arg(1);
+
+//#endregion
+
+//#region encoding
+
+// createPacket() with every field wanted
+static void BM_CreatePacket(benchmark::State& bench) {
+    heatpumpSettings wanted{};
+    wanted.power = POWER_MAP[1];
+    wanted.mode = MODE_MAP[2];
+    wanted.temperature = 21.5f;
+    wanted.fan = FAN_MAP[3];
+    wanted.vane = VANE_MAP[6];
+    wanted.wideVane = WIDEVANE_MAP[2];
+    uint8_t packet[PACKET_LEN];
+
+    for (auto _ : bench) {
+        benchmark::DoNotOptimize(wanted);
+        encodeSettings(packet, wanted, true, false);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+BENCHMARK(BM_CreatePacket);
+
+static void BM_CreateInfoPacket(benchmark::State& bench) {
+    uint8_t packet[PACKET_LEN];
+    int i = 0;
+
+    for (auto _ : bench) {
+        encodeInfoRequest(packet, INFOMODE[i++ % INFOMODE_LEN]);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+BENCHMARK(BM_CreateInfoPacket);
+
+static void BM_SendRemoteTemperature(benchmark::State& bench) {
+    uint8_t packet[PACKET_LEN];
+    float temperature = 20.5f;
+
+    for (auto _ : bench) {
+        benchmark::DoNotOptimize(temperature);
+        encodeRemoteTemperature(packet, temperature);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+BENCHMARK(BM_SendRemoteTemperature);
+
+//#endregion
+
+//#region lookups
+
+// range(0): index of the looked up entry, the lookups are linear
+static void BM_LookupByteMapValue(benchmark::State& bench) {
+    uint8_t byteValue = WIDEVANE[bench.range(0)];
+    for (auto _ : bench) {
+        benchmark::DoNotOptimize(byteValue);
+        benchmark::DoNotOptimize(lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, byteValue));
+    }
+}
+BENCHMARK(BM_LookupByteMapValue)->Arg(0)->Arg(7);
+
+static void BM_LookupByteMapIndex(benchmark::State& bench) {
+    const char* value = WIDEVANE_MAP[bench.range(0)];
+    for (auto _ : bench) {
+        benchmark::DoNotOptimize(value);
+        benchmark::DoNotOptimize(lookupByteMapIndex(WIDEVANE_MAP, 8, value));
+    }
+}
+BENCHMARK(BM_LookupByteMapIndex)->Arg(0)->Arg(7);
+
+static void BM_LookupByteMapIndexInt(benchmark::State& bench) {
+    int value = TEMP_MAP[bench.range(0)];
+    for (auto _ : bench) {
+        benchmark::DoNotOptimize(value);
+        benchmark::DoNotOptimize(lookupByteMapIndex(TEMP_MAP, 16, value));
+    }
+}
+BENCHMARK(BM_LookupByteMapIndexInt)->Arg(0)->Arg(15);
+
+//#endregion
+
+//#region packet debug
+
+/**
+ * hpPacketDebug(): the frame is recorded in the trace ring, and formatted for the READ/WRITE
+ * line when the log level is DEBUG or more (range(0) = 1); the log output itself is not measured.
+*/
+static void BM_HpPacketDebug(benchmark::State& bench) {
+    packetTrace trace;
+    trace.init();
+    char hex[MAX_DATA_BYTES * 3 + 1];
+    bool format = bench.range(0) == 1;
+    uint32_t now = 0;
+
+    for (auto _ : bench) {
+        trace.record(now++, TraceDirection::RX, SETTINGS_FRAME, PACKET_LEN);
+        if (format) {
+            packetTrace::formatFrame(SETTINGS_FRAME, PACKET_LEN, hex, sizeof(hex));
+            benchmark::DoNotOptimize(hex);
+        }
+    }
+}
+BENCHMARK(BM_HpPacketDebug)->Arg(0)->Arg(1);
+
+//#endregion
+
+int main(int argc, char** argv) {
+    cn105_host_log_level = 0;       // the logs of the core would be measured otherwise
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
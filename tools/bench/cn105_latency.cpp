@@ -0,0 +1,414 @@
+/**
+ * End to end latency of the control path, against a unit on a serial line: normally the emulator
+ * served on a pseudo-terminal (cn105_emulator_pty -B, for the transmission time at 2400 bauds).
+ *
+ * The component is simulatedComponent, the loop of CN105Climate that cn105_simulate, cn105_soak and
+ * cn105_faults run too (tx queue priorities and deadlines, info cycles, liveness probes, link state
+ * machine, wanted settings merged by mergeWantedSettings()), here on a serialTransport in real time:
+ * loop() runs every 16 ms as under ESPHome, and again at once while frames come in. A command is a
+ * new setpoint given as by control(); it waits for the debounce, for the end of a running cycle and
+ * for the line to be free, is written, acknowledged (0x61), and is confirmed when a settings
+ * response (0x02) of a later cycle carries it, which is when the component publishes it.
+ *
+ * Conditions:
+ *   idle       a command shortly after a cycle ended
+ *   mid-cycle  a command just after a cycle started
+ *   storm      bursts of commands closer than the debounce and the cycles (coalesced)
+ *   sustained  a new command as soon as the previous one is acknowledged, for a given duration
+ *
+ * usage: cn105_latency [-n samples] [-i interval_ms] [-d debounce_ms] [-b burst] [-s storm_period_ms]
+ *                      [-t sustained_s] [-j out.json] [-v] device
+ *
+ * The JSON has the layout of Google Benchmark (times in ms, lower is better), so that
+ * bench_compare.py compares two runs. Built by the CMakeLists.txt at the root of the repository
+ * (target cn105_latency).
+*/
+#include "cn105_clock.h"
+#include "serial_port.h"
+#include "simulated_component.h"
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+extern int cn105_host_log_level;
+
+static const uint32_t LOOP_PERIOD_MS = 16;              // ESPHome calls loop() about every 16 ms
+static const uint32_t COMMAND_TIMEOUT_MS = 30000;
+static const uint32_t IDLE_DELAY_MS = 200;              // idle condition: command this long after a cycle ended
+
+struct command {
+    float setpoint;
+    uint32_t issuedMs;
+    uint32_t sentMs;
+    uint32_t ackMs;
+    uint32_t confirmedMs;
+    int packet;                     // index in sentPackets, -1 until written
+    bool acked;
+    bool confirmed;
+};
+
+struct sentPacket {
+    float setpoint;
+    bool acked;
+};
+
+/**
+ * The commands given to the component and what became of them, read from its counters and its
+ * state model after each loop()
+*/
+struct controlPath {
+    simulatedComponent& component;
+    serialTransport& line;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    float wantedSetpoint = 0;
+    std::vector<command> commands;
+    std::vector<sentPacket> sentPackets;
+    uint32_t nbWritesSent = 0;
+    uint32_t nbAcks = 0;
+
+    controlPath(simulatedComponent& component, serialTransport& line) : component(component), line(line) {}
+
+    uint32_t now() const {
+        return this->component.clock.nowMs;
+    }
+
+    // control(): the setpoint becomes the wanted one, the debounce restarts
+    void control(float setpoint) {
+        command issued{};
+        issued.setpoint = setpoint;
+        issued.issuedMs = this->now();
+        issued.packet = -1;
+        this->commands.push_back(issued);
+        this->wantedSetpoint = setpoint;
+
+        heatpumpSettings wanted{};
+        wanted.resetSettings();
+        wanted.temperature = setpoint;
+        this->component.setWantedSettings(wanted, true);
+    }
+
+    // the settings frames written carry the setpoint wanted when loop() started
+    void onWritesSent(float setpoint) {
+        uint32_t now = this->now();
+        for (; this->nbWritesSent < this->component.nbWritesSent; this->nbWritesSent++) {
+            this->sentPackets.push_back({ setpoint, false });
+            for (command& pending : this->commands) {
+                if (pending.packet < 0) {
+                    pending.packet = this->sentPackets.size() - 1;
+                    pending.sentMs = now;
+                }
+            }
+        }
+    }
+
+    void onAcks() {
+        uint32_t now = this->now();
+        for (; this->nbAcks < this->component.nbAcks; this->nbAcks++) {
+            for (size_t i = 0; i < this->sentPackets.size(); i++) {
+                if (!this->sentPackets[i].acked) {
+                    this->sentPackets[i].acked = true;
+                    for (command& pending : this->commands) {
+                        if (pending.packet == (int)i) {
+                            pending.acked = true;
+                            pending.ackMs = now;
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // a published setpoint confirms the last acknowledged packet that carried it, and the older ones
+    void onSettings() {
+        float setpoint = this->component.state.settings.temperature;
+        int confirmed = -1;
+        for (size_t i = 0; i < this->sentPackets.size(); i++) {
+            if (this->sentPackets[i].acked && this->sentPackets[i].setpoint == setpoint) {
+                confirmed = i;
+            }
+        }
+        uint32_t now = this->now();
+        for (command& pending : this->commands) {
+            if (!pending.confirmed && pending.acked && pending.packet <= confirmed) {
+                pending.confirmed = true;
+                pending.confirmedMs = now;
+            }
+        }
+    }
+
+    // one call of loop() by ESPHome, at the real time
+    void loop() {
+        this->component.clock.set((uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - this->start).count());
+        bool more = true;
+        while (more) {
+            float setpoint = this->wantedSetpoint;
+            more = this->component.loop();
+            this->onWritesSent(setpoint);
+            this->onAcks();
+            this->onSettings();
+        }
+    }
+
+    // runs the loop until the condition holds or the timeout expires, false on timeout
+    template <typename Condition>
+    bool runUntil(Condition condition, uint32_t timeoutMs) {
+        uint32_t start = this->now();
+        while (!condition()) {
+            if (elapsedMs(this->now(), start) >= timeoutMs) {
+                return false;
+            }
+            struct pollfd pfd = { this->line.fd, POLLIN, 0 };
+            poll(&pfd, 1, LOOP_PERIOD_MS);
+            this->loop();
+        }
+        return true;
+    }
+
+    void runFor(uint32_t durationMs) {
+        this->runUntil([]() { return false; }, durationMs);
+    }
+
+    bool allConfirmed() const {
+        for (const command& pending : this->commands) {
+            if (!pending.confirmed) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct commandLatencies {
+    std::string name;
+    std::vector<double> toWire;
+    std::vector<double> toAck;
+    std::vector<double> total;
+    uint32_t nbLost = 0;
+
+    static double percentile(std::vector<double> values, double p) {
+        if (values.empty()) {
+            return NAN;
+        }
+        std::sort(values.begin(), values.end());
+        size_t rank = (size_t)std::ceil(p / 100 * values.size());
+        return values[rank > 0 ? rank - 1 : 0];
+    }
+
+    static double mean(const std::vector<double>& values) {
+        double sum = 0;
+        for (double value : values) {
+            sum += value;
+        }
+        return values.empty() ? NAN : sum / values.size();
+    }
+
+    void add(const std::vector<command>& commands) {
+        for (const command& done : commands) {
+            if (!done.confirmed) {
+                this->nbLost++;
+                continue;
+            }
+            this->toWire.push_back(elapsedMs(done.sentMs, done.issuedMs));
+            this->toAck.push_back(elapsedMs(done.ackMs, done.issuedMs));
+            this->total.push_back(elapsedMs(done.confirmedMs, done.issuedMs));
+        }
+    }
+};
+
+// setpoints in whole degrees, always different from the previous one
+static float nextSetpoint() {
+    static int step = 0;
+    return 17 + (step++ % 9);
+}
+
+static void runIdle(controlPath& path, int samples, commandLatencies& stats) {
+    for (int i = 0; i < samples; i++) {
+        uint32_t cycles = path.component.nbCompleteCycles;
+        path.runUntil([&]() { return path.component.nbCompleteCycles > cycles; }, COMMAND_TIMEOUT_MS);
+        path.runFor(IDLE_DELAY_MS);
+        path.commands.clear();
+        path.control(nextSetpoint());
+        path.runUntil([&]() { return path.allConfirmed(); }, COMMAND_TIMEOUT_MS);
+        stats.add(path.commands);
+    }
+}
+
+static void runMidCycle(controlPath& path, int samples, commandLatencies& stats) {
+    for (int i = 0; i < samples; i++) {
+        uint32_t cycles = path.component.nbCycles;
+        path.runUntil([&]() { return path.component.nbCycles > cycles; }, COMMAND_TIMEOUT_MS);
+        path.commands.clear();
+        path.control(nextSetpoint());
+        path.runUntil([&]() { return path.allConfirmed(); }, COMMAND_TIMEOUT_MS);
+        stats.add(path.commands);
+    }
+}
+
+static void runStorm(controlPath& path, int samples, int burst, uint32_t periodMs, commandLatencies& stats) {
+    for (int i = 0; i < samples; i++) {
+        path.commands.clear();
+        for (int j = 0; j < burst; j++) {
+            path.control(nextSetpoint());
+            path.runFor(periodMs);
+        }
+        path.runUntil([&]() { return path.allConfirmed(); }, COMMAND_TIMEOUT_MS);
+        stats.add(path.commands);
+    }
+}
+
+// a new command as soon as the previous one is acknowledged: commands per minute the link takes
+static void runSustained(controlPath& path, uint32_t durationMs, uint32_t& nbAcked, uint32_t& nbConfirmed) {
+    path.commands.clear();
+    uint32_t start = cn105Millis();
+    while (elapsedMs(cn105Millis(), start) < durationMs) {
+        path.control(nextSetpoint());
+        path.runUntil([&]() { return path.commands.back().acked; }, COMMAND_TIMEOUT_MS);
+    }
+    nbAcked = 0;
+    nbConfirmed = 0;
+    for (const command& done : path.commands) {
+        nbAcked += done.acked;
+    }
+    path.runUntil([&]() { return path.allConfirmed(); }, COMMAND_TIMEOUT_MS);
+    for (const command& done : path.commands) {
+        nbConfirmed += done.confirmed;
+    }
+}
+
+static void printStats(const commandLatencies& stats) {
+    printf("%-10s %5zu %4u %8.0f %8.0f %8.0f %8.0f %8.0f %8.0f\n", stats.name.c_str(), stats.total.size(), stats.nbLost,
+        commandLatencies::mean(stats.toWire), commandLatencies::mean(stats.toAck),
+        commandLatencies::percentile(stats.total, 50), commandLatencies::percentile(stats.total, 95),
+        commandLatencies::percentile(stats.total, 99), commandLatencies::percentile(stats.total, 100));
+}
+
+static void writeJsonEntry(FILE* out, bool& first, const std::string& name, double ms) {
+    if (std::isnan(ms)) {
+        return;
+    }
+    fprintf(out, "%s    { \"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": 1, "
+        "\"real_time\": %.1f, \"cpu_time\": %.1f, \"time_unit\": \"ms\" }", first ? "" : ",\n", name.c_str(), name.c_str(), ms, ms);
+    first = false;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [-n samples] [-i interval_ms] [-d debounce_ms] [-b burst] [-s storm_period_ms] [-t sustained_s] [-j out.json] [-v] device\n"
+        "  -n  samples per condition, default 20\n"
+        "  -i  update interval, default 2000 ms\n"
+        "  -d  debounce delay, default 100 ms\n"
+        "  -b  commands per storm burst, default 8\n"
+        "  -s  period of the commands of a burst, default 50 ms\n"
+        "  -t  duration of the sustained run, default 60 s (0: skipped)\n"
+        "  -j  results in the JSON format of Google Benchmark, for bench_compare.py\n"
+        "  -v  logs of the core on stderr\n", name);
+}
+
+int main(int argc, char** argv) {
+    int samples = 20;
+    uint32_t intervalMs = 2000;
+    uint32_t debounceMs = 100;
+    int burst = 8;
+    uint32_t stormPeriodMs = 50;
+    uint32_t sustainedS = 60;
+    const char* jsonPath = nullptr;
+    bool verbose = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:i:d:b:s:t:j:vh")) != -1) {
+        switch (opt) {
+        case 'n': samples = atoi(optarg); break;
+        case 'i': intervalMs = atol(optarg); break;
+        case 'd': debounceMs = atol(optarg); break;
+        case 'b': burst = atoi(optarg); break;
+        case 's': stormPeriodMs = atol(optarg); break;
+        case 't': sustainedS = atol(optarg); break;
+        case 'j': jsonPath = optarg; break;
+        case 'v': verbose = true; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc - 1 || samples <= 0 || burst <= 0 || intervalMs == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    cn105_host_log_level = verbose ? 5 : 1;
+
+    serialTransport line(argv[optind]);
+    if (!line.open()) {
+        perror(argv[optind]);
+        return 1;
+    }
+    virtualClock clock;
+    cn105InstallClock(&clock);
+    simulatedComponent component(line, clock, { true, false });
+    component.updateIntervalMs = intervalMs;
+    component.debounceDelayMs = debounceMs;
+    controlPath path(component, line);
+    path.loop();
+    component.setup();
+    if (!path.runUntil([&]() { return component.isConnected(); }, 5000)) {
+        fprintf(stderr, "%s: no answer to the connect request\n", argv[optind]);
+        return 1;
+    }
+    // a first complete cycle, as the component does before taking commands
+    path.runUntil([&]() { return component.nbCompleteCycles > 0; }, COMMAND_TIMEOUT_MS);
+
+    commandLatencies idle, midCycle, storm;
+    idle.name = "idle";
+    midCycle.name = "mid-cycle";
+    storm.name = "storm";
+    runIdle(path, samples, idle);
+    runMidCycle(path, samples, midCycle);
+    runStorm(path, std::max(1, samples / burst), burst, stormPeriodMs, storm);
+
+    printf("update interval %u ms, debounce %u ms, latencies in ms (control -> confirmed by a 0x02)\n",
+        (unsigned int)intervalMs, (unsigned int)debounceMs);
+    printf("%-10s %5s %4s %8s %8s %8s %8s %8s %8s\n", "condition", "n", "lost", "to wire", "to ack", "p50", "p95", "p99", "max");
+    printStats(idle);
+    printStats(midCycle);
+    printStats(storm);
+
+    uint32_t nbAcked = 0, nbConfirmed = 0;
+    if (sustainedS > 0) {
+        runSustained(path, sustainedS * 1000, nbAcked, nbConfirmed);
+        printf("sustained: %.1f commands/min acknowledged, %u of %u confirmed\n",
+            nbAcked * 60.0 / sustainedS, nbConfirmed, nbAcked);
+    }
+
+    if (jsonPath != nullptr) {
+        FILE* out = fopen(jsonPath, "w");
+        if (out == nullptr) {
+            perror(jsonPath);
+            return 1;
+        }
+        bool first = true;
+        fprintf(out, "{\n  \"context\": { \"update_interval_ms\": %u, \"debounce_ms\": %u },\n  \"benchmarks\": [\n",
+            (unsigned int)intervalMs, (unsigned int)debounceMs);
+        for (const commandLatencies* stats : { &idle, &midCycle, &storm }) {
+            writeJsonEntry(out, first, "latency/" + stats->name + "/p50", commandLatencies::percentile(stats->total, 50));
+            writeJsonEntry(out, first, "latency/" + stats->name + "/p95", commandLatencies::percentile(stats->total, 95));
+            writeJsonEntry(out, first, "latency/" + stats->name + "/p99", commandLatencies::percentile(stats->total, 99));
+        }
+        if (nbAcked > 0) {
+            writeJsonEntry(out, first, "sustained/ms_per_command", sustainedS * 1000.0 / nbAcked);
+        }
+        fprintf(out, "\n  ]\n}\n");
+        fclose(out);
+    }
+    line.close();
+    cn105InstallClock(nullptr);
+    return 0;
+}
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Convert CN105 frames found in ESPHome logs into a pcapng capture.
+
+Two kinds of log lines are understood:
+
+* packet trace dumps (``packet_trace_button`` / ``dumpPacketTrace()``)::
+
+    [12:00:01][I][TRACE:043]: 17 123456 TX FC 42 01 30 10 02 00 ... 7B
+
+  their timestamp is the ESP uptime in ms, exact to the millisecond.
+
+* live ``READ`` / ``WRITE`` debug lines::
+
+    [12:00:01.250][D][WRITE:123]: FC 42 01 30 10 02 00 ... 7B
+
+  they only carry the time of the log line, when the logger prints one.
+
+Frames are written with the LINKTYPE_USER0 (147) link type, a millisecond
+timestamp resolution and the direction in the epb_flags option
+(inbound = received from the heatpump, outbound = sent by the ESP).
+Open the result in Wireshark with tools/wireshark/cn105.lua loaded.
+
+Usage: cn105_trace2pcapng.py [-o capture.pcapng] [logfile ...]
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LINKTYPE_USER0 = 147
+
+BLOCK_SHB = 0x0A0D0D0A
+BLOCK_IDB = 0x00000001
+BLOCK_EPB = 0x00000006
+
+OPT_ENDOFOPT = 0
+OPT_COMMENT = 1
+OPT_IF_TSRESOL = 9
+OPT_EPB_FLAGS = 2
+
+EPB_INBOUND = 0x1
+EPB_OUTBOUND = 0x2
+
+HEX_FRAME = r"((?:[0-9A-Fa-f]{2}[ ]?)+)"
+TRACE_LINE = re.compile(r"\[TRACE[^\]]*\]:?\s+(\d+) (\d+) (RX|TX) " + HEX_FRAME)
+LIVE_LINE = re.compile(r"\[(READ|WRITE)[^\]]*\]:?\s+" + HEX_FRAME)
+LOG_TIME = re.compile(r"\[(\d{2}):(\d{2}):(\d{2})(?:\.(\d{1,3}))?\]")
+
+
+def pad4(data):
+    return data + b"\x00" * (-len(data) % 4)
+
+
+def option(code, value):
+    return struct.pack("<HH", code, len(value)) + pad4(value)
+
+
+def block(block_type, body):
+    length = 12 + len(body)
+    return struct.pack("<II", block_type, length) + body + struct.pack("<I", length)
+
+
+def section_header(comment):
+    body = struct.pack("<IHHq", 0x1A2B3C4D, 1, 0, -1)
+    body += option(OPT_COMMENT, comment.encode()) + option(OPT_ENDOFOPT, b"")
+    return block(BLOCK_SHB, body)
+
+
+def interface_description():
+    body = struct.pack("<HHI", LINKTYPE_USER0, 0, 0)
+    body += option(OPT_IF_TSRESOL, bytes([3])) + option(OPT_ENDOFOPT, b"")  # 10^-3 s
+    return block(BLOCK_IDB, body)
+
+
+def enhanced_packet(timestamp_ms, outbound, frame):
+    body = struct.pack("<IIIII", 0, timestamp_ms >> 32, timestamp_ms & 0xFFFFFFFF, len(frame), len(frame))
+    body += pad4(frame)
+    flags = EPB_OUTBOUND if outbound else EPB_INBOUND
+    body += option(OPT_EPB_FLAGS, struct.pack("<I", flags)) + option(OPT_ENDOFOPT, b"")
+    return block(BLOCK_EPB, body)
+
+
+def log_time_ms(line):
+    match = LOG_TIME.search(line)
+    if match is None:
+        return None
+    hours, minutes, seconds, millis = match.groups()
+    millis = int((millis or "0").ljust(3, "0"))
+    return ((int(hours) * 60 + int(minutes)) * 60 + int(seconds)) * 1000 + millis
+
+
+def parse_frames(lines):
+    """Yields (timestamp_ms, outbound, frame) for every frame found in the log lines."""
+    seen_trace = set()
+    last_ms = 0
+    for line in lines:
+        match = TRACE_LINE.search(line)
+        if match:
+            seq = int(match.group(1))
+            if seq in seen_trace:  # consecutive dumps overlap
+                continue
+            seen_trace.add(seq)
+            last_ms = int(match.group(2))
+            yield last_ms, match.group(3) == "TX", bytes.fromhex(match.group(4))
+            continue
+
+        match = LIVE_LINE.search(line)
+        if match:
+            timestamp = log_time_ms(line)
+            last_ms = timestamp if timestamp is not None else last_ms + 1
+            yield last_ms, match.group(1) == "WRITE", bytes.fromhex(match.group(2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("logs", nargs="*", help="ESPHome log files (stdin when omitted)")
+    parser.add_argument("-o", "--output", default="cn105.pcapng", help="pcapng file to write")
+    args = parser.parse_args()
+
+    lines = []
+    if args.logs:
+        for path in args.logs:
+            with open(path, encoding="utf-8", errors="replace") as log:
+                lines.extend(log)
+    else:
+        lines = sys.stdin.readlines()
+
+    frames = list(parse_frames(lines))
+
+    with open(args.output, "wb") as capture:
+        capture.write(section_header("CN105 frames extracted from ESPHome logs"))
+        capture.write(interface_description())
+        for timestamp_ms, outbound, frame in frames:
+            capture.write(enhanced_packet(timestamp_ms, outbound, frame))
+
+    print(f"{len(frames)} frame(s) written to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,568 @@
+/**
+ * Command line client of a unit on a serial line: a USB serial adapter wired to the CN105 connector
+ * (/dev/ttyUSB0) or the pseudo-terminal of cn105_emulator_pty. It speaks through the framer, the
+ * encoders, the decoders and the state model of the component, so that a protocol fix is checked
+ * here before being flashed.
+ *
+ * usage: cn105ctl [-t timeout_ms] [-f] [-v] device command [args...]
+ *   connect                           handshake (0x5A), prints the time to its ACK
+ *   get settings|room|status|stage|options|functions
+ *   set key=value...                  power, mode (OFF powers off), temp, fan, vane, widevane
+ *   remote-temp celsius               remote room temperature, 0 to go back to the internal sensor
+ *   watch [interval_s]                info cycles of the component, prints the fields that change
+ *   bench [count] [info_code]         round trip time of the info requests, with a histogram
+ *
+ * Every command but connect starts with the handshake: the unit ignores the requests before it.
+ * Built by the CMakeLists.txt at the root of the repository (target cn105ctl).
+*/
+#include "cn105_clock.h"
+#include "cn105_encoders.h"
+#include "cn105_framer.h"
+#include "cn105_scheduler.h"
+#include "heatpumpFunctions.h"
+#include "info_response.h"
+#include "serial_port.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+extern int cn105_host_log_level;
+
+static const uint8_t CONNECT_ACK_COMMAND = 0x7a;
+static const uint8_t SET_ACK_COMMAND = 0x61;
+static const uint8_t INFO_RESPONSE_COMMAND = 0x62;
+static const int ANY_INFO_CODE = -1;
+static const int HISTOGRAM_BUCKETS = 10;
+static const int HISTOGRAM_WIDTH = 50;
+
+static const uint32_t FIELDS_SETTINGS = FIELD_POWER | FIELD_MODE | FIELD_TEMPERATURE | FIELD_FAN | FIELD_VANE |
+FIELD_WIDE_VANE | FIELD_ISEE | FIELD_AIRFLOW_CONTROL;
+static const uint32_t FIELDS_ROOM = FIELD_ROOM_TEMPERATURE | FIELD_OUTSIDE_AIR_TEMPERATURE | FIELD_RUNTIME_HOURS;
+static const uint32_t FIELDS_OPERATION = FIELD_OPERATING | FIELD_COMPRESSOR_FREQUENCY | FIELD_INPUT_POWER | FIELD_KWH;
+static const uint32_t FIELDS_STAGE = FIELD_STAGE | FIELD_SUB_MODE | FIELD_AUTO_SUB_MODE;
+static const uint32_t FIELDS_OPTIONS = FIELD_AIR_PURIFIER | FIELD_NIGHT_MODE | FIELD_CIRCULATOR;
+
+/**
+ * get targets: info code of the request and fields of the state model it fills
+*/
+struct infoTarget {
+    const char* name;
+    uint8_t infoCode;
+    uint32_t fields;
+};
+
+static const infoTarget INFO_TARGETS[] = {
+    { "settings", 0x02, FIELDS_SETTINGS },
+    { "room", 0x03, FIELDS_ROOM },
+    { "status", 0x06, FIELDS_OPERATION },
+    { "stage", 0x09, FIELDS_STAGE },
+    { "options", 0x42, FIELDS_OPTIONS },
+    { "functions", FUNCTIONS_GET_PART1, 0 },
+};
+
+static const infoTarget* findInfoTarget(const char* name) {
+    for (const infoTarget& target : INFO_TARGETS) {
+        if (strcmp(target.name, name) == 0) {
+            return &target;
+        }
+    }
+    return nullptr;
+}
+
+static const infoTarget* findInfoTarget(uint8_t infoCode) {
+    for (const infoTarget& target : INFO_TARGETS) {
+        if (target.infoCode == infoCode) {
+            return &target;
+        }
+    }
+    return nullptr;
+}
+
+static double nowMsPrecise() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * The serial line and its framer: a request is written, then the frames are read until the
+ * expected one; the other frames (late answers to a previous request) are skipped.
+*/
+struct cn105Link {
+    int fd = -1;
+    uint32_t timeoutMs = 2000;
+    cn105Framer framer;
+    uint32_t nbBadFrames = 0;
+    double lastRttMs = 0;                   // from the end of the write to the last byte of the answer
+
+    bool open(const char* path) {
+        this->fd = openSerialPort(path);
+        if (this->fd < 0) {
+            fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        this->framer.init();
+        return true;
+    }
+
+    bool write(const uint8_t* bytes, int length) {
+        tcflush(this->fd, TCIFLUSH);        // stale bytes would be taken for the answer
+        this->framer.init();
+        while (length > 0) {
+            ssize_t written = ::write(this->fd, bytes, length);
+            if (written < 0 && errno == EAGAIN) {
+                struct pollfd pfd = { this->fd, POLLOUT, 0 };
+                poll(&pfd, 1, this->timeoutMs);
+                continue;
+            }
+            if (written < 0) {
+                perror("write");
+                return false;
+            }
+            bytes += written;
+            length -= written;
+        }
+        tcdrain(this->fd);
+        return true;
+    }
+
+    // next valid frame of the command (and info code for the 0x62), false on timeout
+    bool waitFrame(uint8_t command, int infoCode) {
+        double startMs = nowMsPrecise();
+        for (;;) {
+            double remainingMs = startMs + this->timeoutMs - nowMsPrecise();
+            if (remainingMs <= 0) {
+                return false;
+            }
+            struct pollfd pfd = { this->fd, POLLIN, 0 };
+            if (poll(&pfd, 1, (int)remainingMs + 1) <= 0) {
+                continue;
+            }
+            uint8_t byte;
+            while (read(this->fd, &byte, 1) == 1) {
+                if (!this->framer.push(byte)) {
+                    continue;
+                }
+                bool expected = this->isExpected(command, infoCode);
+                this->framer.init();
+                if (expected) {
+                    this->lastRttMs = nowMsPrecise() - startMs;
+                    return true;
+                }
+            }
+        }
+    }
+
+    bool isExpected(uint8_t command, int infoCode) {
+        if (!this->framer.isChecksumValid()) {
+            this->nbBadFrames++;
+            return false;
+        }
+        if (this->framer.getCommand() != command) {
+            return false;
+        }
+        if (command != INFO_RESPONSE_COMMAND) {
+            return true;
+        }
+        return this->framer.getDataLength() >= INFO_RESPONSE_DATA_LEN
+            && (infoCode == ANY_INFO_CODE || this->framer.getData()[0] == infoCode);
+    }
+
+    bool exchange(const uint8_t* bytes, int length, uint8_t command, int infoCode, uint8_t* data = nullptr) {
+        if (!this->write(bytes, length) || !this->waitFrame(command, infoCode)) {
+            return false;
+        }
+        if (data != nullptr) {
+            memcpy(data, this->framer.getData(), INFO_RESPONSE_DATA_LEN);
+        }
+        return true;
+    }
+
+    bool connect() {
+        if (this->exchange(CONNECT, CONNECT_LEN, CONNECT_ACK_COMMAND, ANY_INFO_CODE)) {
+            return true;
+        }
+        fprintf(stderr, "no answer to the connection request after %u ms\n", (unsigned int)this->timeoutMs);
+        return false;
+    }
+
+    bool requestInfo(uint8_t infoCode, uint8_t* data) {
+        uint8_t packet[PACKET_LEN];
+        encodeInfoRequest(packet, infoCode);
+        return this->exchange(packet, PACKET_LEN, INFO_RESPONSE_COMMAND, infoCode, data);
+    }
+
+    bool set(const uint8_t* packet) {
+        return this->exchange(packet, PACKET_LEN, SET_ACK_COMMAND, ANY_INFO_CODE);
+    }
+};
+
+struct cn105Ctl {
+    cn105Link link;
+    decodeOptions options{ true, false };
+    cn105State state;
+    bool tempMode = true;
+
+    void printFields(uint32_t fields) {
+        char value[32];
+        for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+            StateField field = static_cast<StateField>(1UL << i);
+            if (fields & field) {
+                formatStateField(this->state, field, value, sizeof(value));
+                printf("%s = %s\n", cn105State::getFieldName(field), value);
+            }
+        }
+    }
+
+    bool get(const infoTarget& target, bool print) {
+        uint8_t data[INFO_RESPONSE_DATA_LEN];
+        if (!this->link.requestInfo(target.infoCode, data)) {
+            fprintf(stderr, "no answer to the %s request (0x%02X)\n", target.name, target.infoCode);
+            return false;
+        }
+        bool known;
+        applyInfoResponse(data, this->options, this->state, known);
+        if (target.infoCode == 0x02) {
+            this->tempMode = decodeSettings(data, this->options).tempMode;
+        }
+        if (print) {
+            this->printFields(target.fields);
+        }
+        return true;
+    }
+
+    bool getFunctions() {
+        uint8_t data[INFO_RESPONSE_DATA_LEN];
+        heatpumpFunctions functions;
+        if (!this->link.requestInfo(FUNCTIONS_GET_PART1, data)) {
+            fprintf(stderr, "no answer to the functions request (0x20)\n");
+            return false;
+        }
+        functions.setData1(&data[1]);
+        if (!this->link.requestInfo(FUNCTIONS_GET_PART2, data)) {
+            fprintf(stderr, "no answer to the functions request (0x22)\n");
+            return false;
+        }
+        functions.setData2(&data[1]);
+        // as CN105Climate::functionsArrived(): 0 is a code the unit does not support
+        heatpumpFunctionCodes codes = functions.getAllCodes();
+        for (int i = 0; i < MAX_FUNCTION_CODE_COUNT; i++) {
+            int value = codes.valid[i] ? functions.getValue(codes.code[i]) : 0;
+            if (value > 0) {
+                printf("%d = %d\n", codes.code[i], value);
+            }
+        }
+        return true;
+    }
+
+    bool watch(uint32_t intervalS);
+    bool bench(int count, uint8_t infoCode);
+};
+
+// entry of the map that matches value, case insensitive; nullptr (and the accepted values printed) if none
+static const char* parseMapValue(const char* key, const char* value, const char* valuesMap[], int len) {
+    for (int i = 0; i < len; i++) {
+        if (strcasecmp(valuesMap[i], value) == 0) {
+            return valuesMap[i];
+        }
+    }
+    fprintf(stderr, "%s: unknown value %s, expected one of:", key, value);
+    for (int i = 0; i < len; i++) {
+        fprintf(stderr, " %s", valuesMap[i]);
+    }
+    fprintf(stderr, "\n");
+    return nullptr;
+}
+
+/**
+ * key=value arguments of set into wanted settings, as CN105Climate::controlMode() and the others:
+ * a mode powers the unit on, unless power is given, and mode=OFF powers it off
+*/
+static bool parseSettings(int argc, char** argv, heatpumpSettings& wanted) {
+    wanted.resetSettings();
+    const char* power = nullptr;
+    for (int i = 0; i < argc; i++) {
+        char* value = strchr(argv[i], '=');
+        if (value == nullptr) {
+            fprintf(stderr, "expected key=value, got %s\n", argv[i]);
+            return false;
+        }
+        *value++ = '\0';
+        const char* key = argv[i];
+        const char* parsed = value;
+        if (strcmp(key, "power") == 0) {
+            parsed = power = parseMapValue(key, value, POWER_MAP, 2);
+        } else if (strcmp(key, "mode") == 0) {
+            if (strcasecmp(value, "OFF") == 0) {
+                wanted.power = POWER_MAP[0];
+                continue;
+            }
+            parsed = wanted.mode = parseMapValue(key, value, MODE_MAP, 5);
+            if (parsed != nullptr && wanted.power == nullptr) {
+                wanted.power = POWER_MAP[1];
+            }
+        } else if (strcmp(key, "temp") == 0) {
+            char* end;
+            wanted.temperature = strtof(value, &end);
+            if (*end != '\0' || wanted.temperature < 16 || wanted.temperature > 31) {
+                fprintf(stderr, "temp: %s is not a setpoint between 16 and 31 °C\n", value);
+                return false;
+            }
+        } else if (strcmp(key, "fan") == 0) {
+            parsed = wanted.fan = parseMapValue(key, value, FAN_MAP, 6);
+        } else if (strcmp(key, "vane") == 0) {
+            parsed = wanted.vane = parseMapValue(key, value, VANE_MAP, 7);
+        } else if (strcmp(key, "widevane") == 0) {
+            parsed = wanted.wideVane = parseMapValue(key, value, WIDEVANE_MAP, 8);
+        } else {
+            fprintf(stderr, "unknown setting %s (power, mode, temp, fan, vane, widevane)\n", key);
+            return false;
+        }
+        if (parsed == nullptr) {
+            return false;
+        }
+    }
+    if (power != nullptr) {
+        wanted.power = power;
+    }
+    return true;
+}
+
+/**
+ * The info cycle of the component (cn105Scheduler), one every interval: the state is printed,
+ * then the fields that change, as they would be published. A request without answer ends the cycle, except the
+ * HVAC options, that are not asked again.
+*/
+bool cn105Ctl::watch(uint32_t intervalS) {
+    cn105Scheduler scheduler;
+    scheduler.init();
+    cycleContext context{ true, true, false };
+    bool firstCycle = true;                 // the whole state first, then the changes
+    this->state.init();
+
+    for (;;) {
+        uint32_t cycleStartMs = cn105Millis();
+        int request = scheduler.firstRequest();
+        while (request != SCHEDULER_NO_REQUEST) {
+            uint8_t infoCode = INFOMODE[request];
+            uint8_t data[INFO_RESPONSE_DATA_LEN];
+            if (!this->link.requestInfo(infoCode, data)) {
+                if (infoCode == 0x42) {
+                    context.hvacOptionsEnabled = false;
+                    request = scheduler.onResponse(0x42, context).request;
+                    continue;
+                }
+                if (infoCode != 0x09) {
+                    fprintf(stderr, "no answer to 0x%02X\n", infoCode);
+                }
+                break;
+            }
+            bool known;
+            uint32_t changed = applyInfoResponse(data, this->options, this->state, known);
+            if (firstCycle) {
+                const infoTarget* target = findInfoTarget(infoCode);
+                changed |= target != nullptr ? target->fields : 0;
+            }
+            if (changed != 0) {
+                time_t now = time(nullptr);
+                char stamp[16];
+                strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&now));
+                char value[32];
+                for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+                    StateField field = static_cast<StateField>(1UL << i);
+                    if (changed & field) {
+                        formatStateField(this->state, field, value, sizeof(value));
+                        printf("%s  %s = %s\n", stamp, cn105State::getFieldName(field), value);
+                    }
+                }
+                fflush(stdout);
+            }
+            cycleStep step = scheduler.onResponse(infoCode, context);
+            if (step.standbyGivenUp) {
+                context.standbyUnsupported = true;
+            }
+            request = step.request;
+        }
+        firstCycle = false;
+        uint32_t elapsed = elapsedMs(cn105Millis(), cycleStartMs);
+        if (elapsed < intervalS * 1000) {
+            cn105Delay(intervalS * 1000 - elapsed);
+        }
+    }
+    return true;
+}
+
+bool cn105Ctl::bench(int count, uint8_t infoCode) {
+    std::vector<double> rtts;
+    int nbLost = 0;
+    uint8_t data[INFO_RESPONSE_DATA_LEN];
+    for (int i = 0; i < count; i++) {
+        if (this->link.requestInfo(infoCode, data)) {
+            rtts.push_back(this->link.lastRttMs);
+        } else {
+            nbLost++;
+        }
+    }
+    printf("%d requests 0x%02X, %d answered, %d lost, %u bad frames\n", count, infoCode, (int)rtts.size(), nbLost,
+        (unsigned int)this->link.nbBadFrames);
+    if (rtts.empty()) {
+        return false;
+    }
+
+    std::sort(rtts.begin(), rtts.end());
+    auto percentile = [&rtts](double p) {
+        size_t rank = (size_t)(p / 100 * rtts.size() + 0.999999);
+        return rtts[rank > 0 ? rank - 1 : 0];
+    };
+    printf("rtt ms: min %.1f  p50 %.1f  p95 %.1f  p99 %.1f  max %.1f\n", rtts.front(), percentile(50), percentile(95),
+        percentile(99), rtts.back());
+
+    double bucketMs = std::max(1.0, (rtts.back() - rtts.front()) / HISTOGRAM_BUCKETS);
+    int buckets[HISTOGRAM_BUCKETS + 1] = { 0 };
+    int largest = 0;
+    for (double rtt : rtts) {
+        int bucket = std::min(HISTOGRAM_BUCKETS, (int)((rtt - rtts.front()) / bucketMs));
+        largest = std::max(largest, ++buckets[bucket]);
+    }
+    int lastBucket = std::min(HISTOGRAM_BUCKETS, (int)((rtts.back() - rtts.front()) / bucketMs));
+    for (int i = 0; i <= lastBucket; i++) {
+        double lowMs = rtts.front() + i * bucketMs;
+        printf("%7.1f - %7.1f |%-*s %d\n", lowMs, lowMs + bucketMs, HISTOGRAM_WIDTH,
+            std::string(buckets[i] * HISTOGRAM_WIDTH / largest, '#').c_str(), buckets[i]);
+    }
+    return nbLost == 0;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [-t timeout_ms] [-f] [-v] device command [args...]\n"
+        "  connect                           handshake, prints the time to its ACK\n"
+        "  get settings|room|status|stage|options|functions\n"
+        "  set key=value...                  power=ON|OFF mode=HEAT|DRY|COOL|FAN|AUTO|OFF temp=21.5\n"
+        "                                    fan=AUTO|QUIET|1..4 vane=... widevane=...\n"
+        "  remote-temp celsius               0 to go back to the internal sensor\n"
+        "  watch [interval_s]                info cycles, default every 2 s, prints the changes\n"
+        "  bench [count] [info_code]         round trip time, default 100 requests of 0x02\n"
+        "  -t  answer timeout, default 2000 ms\n"
+        "  -f  fahrenheit support mode of the decoders\n"
+        "  -v  logs of the decoders on stderr\n", name);
+}
+
+int main(int argc, char** argv) {
+    cn105Ctl ctl;
+    int opt;
+
+    cn105_host_log_level = 1;
+    while ((opt = getopt(argc, argv, "+t:fvh")) != -1) {
+        switch (opt) {
+        case 't': ctl.link.timeoutMs = atol(optarg); break;
+        case 'f': ctl.options.fahrenheitSupport = true; break;
+        case 'v': cn105_host_log_level = 5; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (argc - optind < 2 || ctl.link.timeoutMs == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char* device = argv[optind];
+    const char* command = argv[optind + 1];
+    char** args = &argv[optind + 2];
+    int nbArgs = argc - optind - 2;
+
+    const infoTarget* target = nullptr;
+    heatpumpSettings wanted{};
+    float remoteTemperature = 0;
+    uint32_t intervalS = 2;
+    int count = 100;
+    uint8_t infoCode = 0x02;
+    if (strcmp(command, "get") == 0) {
+        target = nbArgs == 1 ? findInfoTarget(args[0]) : nullptr;
+        if (target == nullptr) {
+            usage(argv[0]);
+            return 2;
+        }
+    } else if (strcmp(command, "set") == 0) {
+        if (nbArgs == 0) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (!parseSettings(nbArgs, args, wanted)) {
+            return 2;
+        }
+    } else if (strcmp(command, "remote-temp") == 0) {
+        if (nbArgs != 1) {
+            usage(argv[0]);
+            return 2;
+        }
+        remoteTemperature = atof(args[0]);
+    } else if (strcmp(command, "watch") == 0) {
+        if (nbArgs > 1 || (nbArgs == 1 && (intervalS = atol(args[0])) == 0)) {
+            usage(argv[0]);
+            return 2;
+        }
+    } else if (strcmp(command, "bench") == 0) {
+        if (nbArgs > 2 || (nbArgs >= 1 && (count = atoi(args[0])) <= 0)) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (nbArgs == 2) {
+            infoCode = strtol(args[1], nullptr, 16);
+        }
+    } else if (strcmp(command, "connect") != 0 || nbArgs != 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    ctl.state.init();
+    if (!ctl.link.open(device) || !ctl.link.connect()) {
+        return 1;
+    }
+    if (strcmp(command, "connect") == 0) {
+        printf("connected, ACK in %.1f ms\n", ctl.link.lastRttMs);
+        return 0;
+    }
+    if (target != nullptr) {
+        bool ok = target->infoCode == FUNCTIONS_GET_PART1 ? ctl.getFunctions() : ctl.get(*target, true);
+        return ok ? 0 : 1;
+    }
+    if (strcmp(command, "set") == 0) {
+        // the setpoint format of the unit comes with its settings
+        const infoTarget& settings = INFO_TARGETS[0];
+        uint8_t packet[PACKET_LEN];
+        if (!ctl.get(settings, false)) {
+            return 1;
+        }
+        encodeSettings(packet, wanted, ctl.tempMode, false);
+        if (!ctl.link.set(packet)) {
+            fprintf(stderr, "settings not acknowledged\n");
+            return 1;
+        }
+        printf("acknowledged in %.1f ms\n", ctl.link.lastRttMs);
+        return ctl.get(settings, true) ? 0 : 1;
+    }
+    if (strcmp(command, "remote-temp") == 0) {
+        uint8_t packet[PACKET_LEN];
+        encodeRemoteTemperature(packet, remoteTemperature);
+        if (!ctl.link.set(packet)) {
+            fprintf(stderr, "remote temperature not acknowledged\n");
+            return 1;
+        }
+        printf("acknowledged in %.1f ms\n", ctl.link.lastRttMs);
+        return 0;
+    }
+    if (strcmp(command, "watch") == 0) {
+        return ctl.watch(intervalS) ? 0 : 1;
+    }
+    return ctl.bench(count, infoCode) ? 0 : 1;
+}
@@ -0,0 +1,400 @@
+#include "cn105_emulator.h"
+#include "cn105_core_log.h"
+#include "cn105_decoders.h"
+#include "serial_port.h"
+
+#include <math.h>
+#include <string.h>
+
+static const char* EMU_TAG = "EMU";
+
+static const uint8_t CONNECT_ACK_COMMAND = 0x7a;
+static const uint8_t SET_ACK_COMMAND = 0x61;
+static const uint8_t INFO_RESPONSE_COMMAND = 0x62;
+
+/**
+ * Presets of the emulated units, the latencies are the ones seen in captures
+*/
+static const emulatedModel MODELS[] = {
+    { "generic", "recent unit: 0.5°C format, wide vane, every info code answered",
+        30, 40, true, true, false, false, { 0 } },
+    { "legacy", "older unit: 1°C format, no wide vane, no stage, HVAC options nor functions",
+        60, 80, false, false, false, false, { 0x09, 0x42, 0x20, 0x22, 0 } },
+    { "msz-ln", "MSZ-LN: i-See sensor, airflow control, HVAC options (air purifier, night mode)",
+        30, 40, true, true, true, false, { 0 } },
+    { "msz-rw", "MSZ-RW: energy reporting, no wide vane, no HVAC options",
+        40, 50, true, false, false, false, { 0x42, 0 } },
+    { "slow", "generic unit answering late, with the transmission time at 2400 bauds",
+        250, 300, true, true, false, true, { 0 } },
+    { nullptr, nullptr, 0, 0, false, false, false, false, { 0 } },
+};
+
+const emulatedModel* cn105EmulatedModels() {
+    return MODELS;
+}
+
+const emulatedModel* findEmulatedModel(const char* name) {
+    for (const emulatedModel* model = MODELS; model->name != nullptr; model++) {
+        if (strcmp(model->name, name) == 0) {
+            return model;
+        }
+    }
+    return nullptr;
+}
+
+bool emulatedModel::answers(uint8_t infoCode) const {
+    for (int i = 0; i < EMULATOR_MAX_UNSUPPORTED && this->unsupportedInfoCodes[i] != 0; i++) {
+        if (this->unsupportedInfoCodes[i] == infoCode) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isInMap(const uint8_t byteMap[], int len, uint8_t value) {
+    for (int i = 0; i < len; i++) {
+        if (byteMap[i] == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t clampByte(float value, int min, int max) {
+    int rounded = (int)lroundf(value);
+    return (uint8_t)(rounded < min ? min : (rounded > max ? max : rounded));
+}
+
+// 0.5°C format: temp * 2 + 128
+static uint8_t encodeHalfDegrees(float temperature) {
+    return clampByte(temperature * 2 + 128, 1, 255);
+}
+
+void emulatedUnit::init() {
+    this->connected = false;
+    this->power = POWER[0];
+    this->mode = MODE[0];
+    this->setpoint = 21.0f;
+    this->fan = FAN[0];
+    this->vane = VANE[0];
+    this->wideVane = WIDEVANE[2];
+    this->wideVaneAdj = false;
+    this->airflowControl = AIRFLOW_CONTROL[0];
+    this->airPurifier = false;
+    this->nightMode = false;
+    this->circulator = false;
+    this->roomTemperature = 20.0f;
+    this->remoteTemperature = 0;
+    this->outsideAirTemperature = 8.0f;
+    this->operating = false;
+    this->compressorFrequency = 0;
+    this->inputPower = 0;
+    this->energyKwh = 0;
+    this->runtimeMinutes = 0;
+    this->stage = STAGE[0];
+    this->subMode = SUB_MODE[0];
+    this->autoSubMode = AUTO_SUB_MODE[0];
+    // codes 101 to 128, value 1, the last byte of each part is 0 (see CN105Climate::setFunctions)
+    memset(this->functions, 0, sizeof(this->functions));
+    for (int code = 101; code <= 128; code++) {
+        int i = code - 101;
+        int index = i < 14 ? i : i + 1;
+        this->functions[index] = ((code - 100) << 2) + 1;
+    }
+}
+
+float emulatedUnit::getControlTemperature() const {
+    return this->remoteTemperature > 0 ? this->remoteTemperature : this->roomTemperature;
+}
+
+void cn105Emulator::init(const emulatedModel& model, uint32_t nowMs) {
+    this->model = model;
+    this->unit.init();
+    if (!model.wideVane) {
+        this->unit.wideVane = 0;
+    }
+    memset(&this->stats, 0, sizeof(this->stats));
+    this->framer.init();
+    this->output.clear();
+    this->lastTickMs = nowMs;
+    this->timeScale = 1;
+    this->plant.init();
+    this->plant.step(0, this->unit);
+}
+
+void cn105Emulator::receive(uint32_t nowMs, const uint8_t* bytes, int length) {
+    this->tick(nowMs);
+    for (int i = 0; i < length; i++) {
+        if (this->framer.push(bytes[i])) {
+            this->processFrame(nowMs);
+            this->framer.init();
+        }
+    }
+}
+
+void cn105Emulator::tick(uint32_t nowMs) {
+    uint32_t elapsedMs = nowMs - this->lastTickMs;
+    this->lastTickMs = nowMs;
+    this->plant.step(elapsedMs / 1000.0f * this->timeScale, this->unit);
+}
+
+bool cn105Emulator::getNextDueMs(uint32_t& dueMs) const {
+    if (this->output.empty()) {
+        return false;
+    }
+    dueMs = this->output.front().dueMs;
+    return true;
+}
+
+int cn105Emulator::takeOutput(uint32_t nowMs, std::vector<uint8_t>& out) {
+    int length = 0;
+    while (!this->output.empty() && (int32_t)(nowMs - this->output.front().dueMs) >= 0) {
+        const std::vector<uint8_t>& bytes = this->output.front().bytes;
+        out.insert(out.end(), bytes.begin(), bytes.end());
+        length += bytes.size();
+        this->output.pop_front();
+    }
+    return length;
+}
+
+bool cn105Emulator::takeFrame(uint32_t nowMs, std::vector<uint8_t>& frame) {
+    if (this->output.empty() || (int32_t)(nowMs - this->output.front().dueMs) < 0) {
+        return false;
+    }
+    frame.swap(this->output.front().bytes);
+    this->output.pop_front();
+    return true;
+}
+
+void cn105Emulator::buildFrame(uint8_t command, const uint8_t* data, int dataLength, std::vector<uint8_t>& frame) {
+    frame.assign({ 0xfc, command, 0x01, 0x30, (uint8_t)dataLength });
+    frame.insert(frame.end(), data, data + dataLength);
+    frame.push_back(computeChecksum(frame.data(), frame.size()));
+}
+
+/**
+ * data of the 0x62 response to an info request, the layouts are the ones of cn105_decoders.cpp
+*/
+void cn105Emulator::buildInfoData(uint8_t infoCode, uint8_t* data) const {
+    const emulatedUnit& unit = this->unit;
+    memset(data, 0, INFO_RESPONSE_DATA_LEN);
+    data[0] = infoCode;
+
+    switch (infoCode) {
+    case 0x02:
+        data[3] = unit.power;
+        data[4] = unit.mode + (this->model.iSee ? 0x08 : 0x00);
+        data[5] = 31 - clampByte(unit.setpoint, 16, 31);       // TEMP
+        data[6] = unit.fan;
+        data[7] = unit.vane;
+        if (this->model.wideVane) {
+            data[10] = unit.wideVane | (unit.wideVaneAdj ? 0x80 : 0x00);
+        }
+        if (this->model.tempMode) {
+            data[11] = encodeHalfDegrees(unit.setpoint);
+        }
+        if (this->model.iSee) {
+            data[14] = unit.airflowControl;
+        }
+        break;
+    case 0x03: {
+        float room = unit.getControlTemperature();
+        uint32_t runtime = (uint32_t)unit.runtimeMinutes;
+        data[3] = clampByte(room - 10, 0, 31);                  // ROOM_TEMP
+        data[5] = isnan(unit.outsideAirTemperature) ? 0 : encodeHalfDegrees(unit.outsideAirTemperature);
+        if (this->model.tempMode) {
+            data[6] = encodeHalfDegrees(room);
+        }
+        data[11] = runtime >> 16;
+        data[12] = runtime >> 8;
+        data[13] = runtime;
+    }
+        break;
+    case 0x05:
+        data[3] = TIMER_MODE[0];
+        break;
+    case 0x06: {
+        uint32_t energy = (uint32_t)(unit.energyKwh * 10);
+        data[3] = unit.compressorFrequency;
+        data[4] = unit.operating;
+        data[5] = unit.inputPower >> 8;
+        data[6] = unit.inputPower;
+        data[7] = energy >> 8;
+        data[8] = energy;
+    }
+        break;
+    case 0x09:
+        data[3] = unit.subMode;
+        data[4] = unit.stage;
+        data[5] = unit.autoSubMode;
+        break;
+    case 0x20:
+        memcpy(&data[1], unit.functions, EMULATOR_FUNCTIONS_LEN / 2);
+        break;
+    case 0x22:
+        memcpy(&data[1], unit.functions + EMULATOR_FUNCTIONS_LEN / 2, EMULATOR_FUNCTIONS_LEN / 2);
+        break;
+    case 0x42:
+        data[1] = unit.airPurifier;
+        data[2] = unit.nightMode;
+        data[3] = unit.circulator;
+        break;
+    default:        // 0x04, 0x10: unknown content, zeros
+        break;
+    }
+}
+
+void cn105Emulator::processFrame(uint32_t nowMs) {
+    this->stats.nbFramesIn++;
+    if (!this->framer.isChecksumValid()) {
+        this->stats.nbBadChecksums++;       // a real unit ignores them
+        return;
+    }
+    const uint8_t* data = this->framer.getData();
+    uint8_t command = this->framer.getCommand();
+
+    if (command == CONNECT[1]) {
+        uint8_t ack = 0;
+        ESP_LOGI(EMU_TAG, "connect request, answering 0x7a");
+        this->unit.connected = true;
+        this->queue(nowMs + this->getLatency(this->model.responseLatencyMs, 7), CONNECT_ACK_COMMAND, &ack, 1);
+        return;
+    }
+    if (!this->unit.connected || this->framer.getDataLength() < 1) {
+        ESP_LOGD(EMU_TAG, "command 0x%02X before the connection, ignored", command);
+        this->stats.nbUnanswered++;
+        return;
+    }
+
+    if (command == INFOHEADER[1]) {
+        if (!this->model.answers(data[0])) {
+            ESP_LOGD(EMU_TAG, "info code 0x%02X not supported by %s, no answer", data[0], this->model.name);
+            this->stats.nbUnanswered++;
+            return;
+        }
+        uint8_t response[INFO_RESPONSE_DATA_LEN];
+        this->buildInfoData(data[0], response);
+        this->queue(nowMs + this->getLatency(this->model.responseLatencyMs, PACKET_LEN), INFO_RESPONSE_COMMAND, response, INFO_RESPONSE_DATA_LEN);
+        this->stats.nbResponses++;
+        return;
+    }
+
+    if (command == HEADER[1] && this->framer.getDataLength() >= INFO_RESPONSE_DATA_LEN) {
+        switch (data[0]) {
+        case 0x01:
+            this->applySettings(data);
+            break;
+        case 0x07:
+            this->applyRemoteTemperature(data);
+            break;
+        case 0x08:
+            this->applyRunStates(data);
+            break;
+        case FUNCTIONS_SET_PART1:
+            memcpy(this->unit.functions, &data[1], EMULATOR_FUNCTIONS_LEN / 2);
+            ESP_LOGI(EMU_TAG, "functions part 1 set");
+            break;
+        case FUNCTIONS_SET_PART2:
+            memcpy(this->unit.functions + EMULATOR_FUNCTIONS_LEN / 2, &data[1], EMULATOR_FUNCTIONS_LEN / 2);
+            ESP_LOGI(EMU_TAG, "functions part 2 set");
+            break;
+        default:
+            ESP_LOGW(EMU_TAG, "set packet 0x%02X unknown, acknowledged anyway", data[0]);
+            break;
+        }
+        this->plant.step(0, this->unit);
+        uint8_t ack[INFO_RESPONSE_DATA_LEN] = { data[0] };
+        this->queue(nowMs + this->getLatency(this->model.ackLatencyMs, PACKET_LEN), SET_ACK_COMMAND, ack, INFO_RESPONSE_DATA_LEN);
+        this->stats.nbAcks++;
+        return;
+    }
+
+    ESP_LOGW(EMU_TAG, "command 0x%02X (%d bytes) unknown, ignored", command, this->framer.getDataLength());
+    this->stats.nbUnanswered++;
+}
+
+/**
+ * 0x41 0x01: the flags of data[1] and data[2] tell which fields are written (see encodeSettings)
+*/
+void cn105Emulator::applySettings(const uint8_t* data) {
+    emulatedUnit& unit = this->unit;
+    if ((data[1] & CONTROL_PACKET_1[0]) && isInMap(POWER, 2, data[3])) {
+        unit.power = data[3];
+    }
+    if ((data[1] & CONTROL_PACKET_1[1]) && isInMap(MODE, 5, data[4])) {
+        unit.mode = data[4];
+    }
+    if (data[1] & CONTROL_PACKET_1[2]) {
+        if (data[14] != 0) {
+            unit.setpoint = (data[14] - 128) / 2.0f;
+        } else if (isInMap(TEMP, 16, data[5])) {
+            unit.setpoint = TEMP_MAP[data[5]];
+        }
+    }
+    if ((data[1] & CONTROL_PACKET_1[3]) && isInMap(FAN, 6, data[6])) {
+        unit.fan = data[6];
+    }
+    if ((data[1] & CONTROL_PACKET_1[4]) && isInMap(VANE, 7, data[7])) {
+        unit.vane = data[7];
+    }
+    if ((data[2] & CONTROL_PACKET_2[0]) && this->model.wideVane && isInMap(WIDEVANE, 8, data[13] & 0x0F)) {
+        unit.wideVane = data[13] & 0x0F;
+        unit.wideVaneAdj = (data[13] & 0x80) != 0;
+    }
+    ESP_LOGI(EMU_TAG, "settings: power %s, mode %s, setpoint %.1f, fan %s, vane %s, wide vane %s",
+        lookupByteMapValue(POWER_MAP, POWER, 2, unit.power), lookupByteMapValue(MODE_MAP, MODE, 5, unit.mode),
+        unit.setpoint, lookupByteMapValue(FAN_MAP, FAN, 6, unit.fan), lookupByteMapValue(VANE_MAP, VANE, 7, unit.vane),
+        this->model.wideVane ? lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, unit.wideVane) : "-");
+}
+
+// 0x41 0x07: data[1] = 0x01 and data[3] in the 0.5°C format, or data[1] = 0 for the internal sensor
+void cn105Emulator::applyRemoteTemperature(const uint8_t* data) {
+    if (data[1] == 0x01 && data[3] > 128) {
+        this->unit.remoteTemperature = (data[3] - 128) / 2.0f;
+        ESP_LOGI(EMU_TAG, "remote temperature %.1f", this->unit.remoteTemperature);
+    } else {
+        this->unit.remoteTemperature = 0;
+        ESP_LOGI(EMU_TAG, "remote temperature cleared, internal sensor used");
+    }
+}
+
+// 0x41 0x08: flags in data[1] (airflow control) and data[2] (switches), see encodeRunStates
+void cn105Emulator::applyRunStates(const uint8_t* data) {
+    emulatedUnit& unit = this->unit;
+    if ((data[1] & RUN_STATE_PACKET_1[4]) && isInMap(AIRFLOW_CONTROL, 3, data[6])) {
+        unit.airflowControl = data[6];
+    }
+    if (data[2] & RUN_STATE_PACKET_2[1]) {
+        unit.airPurifier = data[12] != 0;
+    }
+    if (data[2] & RUN_STATE_PACKET_2[2]) {
+        unit.nightMode = data[13] != 0;
+    }
+    if (data[2] & RUN_STATE_PACKET_2[3]) {
+        unit.circulator = data[14] != 0;
+    }
+    ESP_LOGI(EMU_TAG, "run states: airflow %s, air purifier %d, night mode %d, circulator %d",
+        lookupByteMapValue(AIRFLOW_CONTROL_MAP, AIRFLOW_CONTROL, 3, unit.airflowControl),
+        unit.airPurifier, unit.nightMode, unit.circulator);
+}
+
+/**
+ * The unit answers one frame at a time: a response is never due before the end of the previous one
+*/
+void cn105Emulator::queue(uint32_t dueMs, uint8_t command, const uint8_t* data, int dataLength) {
+    emulatorFrame frame;
+    buildFrame(command, data, dataLength, frame.bytes);
+    if (!this->output.empty()) {
+        uint32_t previousEnd = this->output.back().dueMs + this->getLatency(0, this->output.back().bytes.size());
+        if ((int32_t)(previousEnd - dueMs) > 0) {
+            dueMs = previousEnd;
+        }
+    }
+    frame.dueMs = dueMs;
+    this->output.push_back(frame);
+}
+
+// 8E1: 11 bits per byte at 2400 bauds
+uint32_t cn105Emulator::getLatency(uint32_t latencyMs, int frameLength) const {
+    return latencyMs + (this->model.lineSpeed ? getSerialFrameDurationMs(frameLength) : 0);
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "cn105_framer.h"
+#include "thermal_model.h"
+
+#include <stddef.h>
+
+#include <deque>
+#include <vector>
+
+/**
+ * Emulation of the CN105 side of a Mitsubishi indoor unit, for the host tools.
+ * It answers the connect request and the info requests (0x42) from its own state, applies the set
+ * packets (0x41: settings, remote temperature, run states, functions) and acknowledges them.
+ * It is transport agnostic: bytes come in with receive(), responses are queued with their due time
+ * (latency of the emulated model) and taken with takeOutput(). See cn105_emulator_pty.cpp.
+ * The status (room temperature, compressor, power, stage, counters) is driven by a thermal model
+ * (thermal_model.h), that can run faster than the protocol clock (timeScale).
+*/
+
+static const int EMULATOR_MAX_UNSUPPORTED = 8;
+static const int EMULATOR_FUNCTIONS_LEN = 30;       // two parts of 15 bytes (0x20/0x22)
+
+/**
+ * Behaviour of an emulated unit. The presets are listed by cn105EmulatedModels().
+*/
+struct emulatedModel {
+    const char* name;
+    const char* description;
+    uint32_t responseLatencyMs;     // request -> start of the response
+    uint32_t ackLatencyMs;          // set packet -> 0x61 ack
+    bool tempMode;                  // setpoint and room temperature in the 0.5°C format
+    bool wideVane;
+    bool iSee;
+    bool lineSpeed;                 // add the transmission time at 2400 bauds 8E1 to the latencies
+    uint8_t unsupportedInfoCodes[EMULATOR_MAX_UNSUPPORTED];    // info codes left unanswered, 0 terminated
+
+    bool answers(uint8_t infoCode) const;
+};
+
+/**
+ * State of the emulated unit, in protocol terms (map bytes, °C)
+*/
+struct emulatedUnit {
+    bool connected;
+    uint8_t power;                  // POWER
+    uint8_t mode;                   // MODE
+    float setpoint;
+    uint8_t fan;                    // FAN
+    uint8_t vane;                   // VANE
+    uint8_t wideVane;               // WIDEVANE
+    bool wideVaneAdj;
+    uint8_t airflowControl;         // AIRFLOW_CONTROL
+    bool airPurifier;
+    bool nightMode;
+    bool circulator;
+    float roomTemperature;          // measured by the unit
+    float remoteTemperature;        // 0: not set, the unit uses its own sensor
+    float outsideAirTemperature;    // NAN: no outside sensor
+    bool operating;
+    uint8_t compressorFrequency;
+    uint16_t inputPower;            // W
+    float energyKwh;
+    float runtimeMinutes;
+    uint8_t stage;                  // STAGE
+    uint8_t subMode;                // SUB_MODE
+    uint8_t autoSubMode;            // AUTO_SUB_MODE
+    uint8_t functions[EMULATOR_FUNCTIONS_LEN];
+
+    void init();
+    // temperature the unit regulates on: the remote one when it has been set
+    float getControlTemperature() const;
+};
+
+struct emulatorStats {
+    uint32_t nbFramesIn;
+    uint32_t nbBadChecksums;
+    uint32_t nbResponses;
+    uint32_t nbAcks;
+    uint32_t nbUnanswered;          // unsupported info codes, requests before the connection, unknown frames
+};
+
+struct emulatorFrame {
+    uint32_t dueMs;
+    std::vector<uint8_t> bytes;
+};
+
+struct cn105Emulator {
+    emulatedModel model;
+    emulatedUnit unit;
+    emulatorStats stats;
+    thermalModel plant;
+    float timeScale;                // simulated seconds per second of the protocol clock
+
+    // nowMs: time of the protocol clock at which the emulation starts
+    void init(const emulatedModel& model, uint32_t nowMs = 0);
+    // bytes written by the ESP at nowMs
+    void receive(uint32_t nowMs, const uint8_t* bytes, int length);
+    // advances the thermal model to nowMs
+    void tick(uint32_t nowMs);
+    // due time of the next queued response, false if none
+    bool getNextDueMs(uint32_t& dueMs) const;
+    // nb of responses queued and not taken yet
+    size_t getPendingCount() const { return this->output.size(); }
+    // appends the responses due at nowMs to out, returns the nb of bytes appended
+    int takeOutput(uint32_t nowMs, std::vector<uint8_t>& out);
+    // replaces frame with the next response due at nowMs, false if none (see faulty_uart.h)
+    bool takeFrame(uint32_t nowMs, std::vector<uint8_t>& frame);
+
+    // response frames, also used by the tools that script a unit without the serial link
+    static void buildFrame(uint8_t command, const uint8_t* data, int dataLength, std::vector<uint8_t>& frame);
+    void buildInfoData(uint8_t infoCode, uint8_t* data) const;
+
+private:
+    cn105Framer framer;
+    std::deque<emulatorFrame> output;
+    uint32_t lastTickMs;
+
+    void processFrame(uint32_t nowMs);
+    void applySettings(const uint8_t* data);
+    void applyRemoteTemperature(const uint8_t* data);
+    void applyRunStates(const uint8_t* data);
+    void queue(uint32_t dueMs, uint8_t command, const uint8_t* data, int dataLength);
+    uint32_t getLatency(uint32_t latencyMs, int frameLength) const;
+};
+
+// presets, terminated by an entry whose name is nullptr
+const emulatedModel* cn105EmulatedModels();
+const emulatedModel* findEmulatedModel(const char* name);
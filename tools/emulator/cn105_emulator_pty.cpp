@@ -0,0 +1,243 @@
+/**
+ * Emulated CN105 unit on a pseudo-terminal: the component (or any serial tool) opens the
+ * slave side as if it were the UART wired to the heatpump.
+ *
+ * usage: cn105_emulator_pty [-m model] [-l latency_ms] [-u code,code...] [-t room_temp] [-s scenario] [-x time_scale] [-F faults] [-B] [-L link] [-v] [-M]
+ *   -m  emulated model (-M lists them), default generic
+ *   -l  response latency in ms, overrides the one of the model (the acks keep their offset)
+ *   -B  add the transmission time at 2400 bauds to the latencies (a pty transmits at once)
+ *   -u  info codes left unanswered, overrides the ones of the model (e.g. -u 0x09,0x42)
+ *   -t  initial room temperature in °C
+ *   -s  scenario applied on the simulated time (emulator_scenario.h), e.g. tools/emulator/scenarios/winter_day.txt
+ *   -x  simulated seconds per second, default 1 (e.g. -x 60: an hour of the scenario per minute)
+ *   -F  line faults on the frames sent to the component (faulty_uart.h), e.g. -F drop=0.01,silence=0.001
+ *   -L  symlink created to the slave device (e.g. /tmp/cn105), removed on exit
+ *   -v  logs the frames and the emulator decisions on stderr
+ *
+ * Built by the CMakeLists.txt at the root of the repository (target cn105_emulator_pty).
+*/
+#include "cn105_emulator.h"
+#include "emulator_scenario.h"
+#include "faulty_uart.h"
+#include "serial_port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <string>
+
+extern int cn105_host_log_level;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-m model] [-l latency_ms] [-u code,code...] [-t room_temp] [-s scenario] [-x time_scale] [-F faults] [-B] [-L link] [-v] [-M]\n", name);
+}
+
+static void listModels() {
+    for (const emulatedModel* model = cn105EmulatedModels(); model->name != nullptr; model++) {
+        printf("%-10s %s (%u ms)\n", model->name, model->description, (unsigned int)model->responseLatencyMs);
+    }
+}
+
+static bool parseUnsupported(const char* list, emulatedModel& model) {
+    memset(model.unsupportedInfoCodes, 0, sizeof(model.unsupportedInfoCodes));
+    int count = 0;
+    std::string codes(list);
+    size_t start = 0;
+    while (start < codes.size()) {
+        size_t end = codes.find(',', start);
+        std::string code = codes.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        long value = strtol(code.c_str(), nullptr, 0);
+        if (value <= 0 || value > 0xff || count >= EMULATOR_MAX_UNSUPPORTED - 1) {
+            return false;
+        }
+        model.unsupportedInfoCodes[count++] = value;
+        start = end == std::string::npos ? codes.size() : end + 1;
+    }
+    return true;
+}
+
+static void logFrame(const char* direction, const uint8_t* bytes, int length) {
+    std::string hex;
+    char byte[4];
+    for (int i = 0; i < length; i++) {
+        snprintf(byte, sizeof(byte), i == 0 ? "%02X" : " %02X", bytes[i]);
+        hex += byte;
+    }
+    fprintf(stderr, "%s %s\n", direction, hex.c_str());
+}
+
+int main(int argc, char** argv) {
+    const emulatedModel* preset = findEmulatedModel("generic");
+    long latencyMs = -1;
+    const char* unsupported = nullptr;
+    const char* link = nullptr;
+    float roomTemperature = NAN;
+    const char* scenarioPath = nullptr;
+    const char* faults = nullptr;
+    float timeScale = 1;
+    bool verbose = false;
+    bool lineSpeed = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:l:u:t:s:x:F:L:BvMh")) != -1) {
+        switch (opt) {
+        case 'm':
+            preset = findEmulatedModel(optarg);
+            if (preset == nullptr) {
+                fprintf(stderr, "unknown model %s\n", optarg);
+                listModels();
+                return 2;
+            }
+            break;
+        case 'l': latencyMs = atol(optarg); break;
+        case 'u': unsupported = optarg; break;
+        case 't': roomTemperature = atof(optarg); break;
+        case 's': scenarioPath = optarg; break;
+        case 'x': timeScale = atof(optarg); break;
+        case 'F': faults = optarg; break;
+        case 'L': link = optarg; break;
+        case 'B': lineSpeed = true; break;
+        case 'v': verbose = true; break;
+        case 'M': listModels(); return 0;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    emulatedModel model = *preset;
+    if (latencyMs >= 0) {
+        model.ackLatencyMs = latencyMs + (model.ackLatencyMs - model.responseLatencyMs);
+        model.responseLatencyMs = latencyMs;
+    }
+    model.lineSpeed = model.lineSpeed || lineSpeed;
+    if (unsupported != nullptr && !parseUnsupported(unsupported, model)) {
+        fprintf(stderr, "bad list of info codes: %s\n", unsupported);
+        return 2;
+    }
+    if (timeScale <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    emulatorScenario scenario;
+    std::string error;
+    if (scenarioPath != nullptr && !scenario.load(scenarioPath, error)) {
+        fprintf(stderr, "%s: %s\n", scenarioPath, error.c_str());
+        return 2;
+    }
+    faultyUart uart;
+    uart.init();
+    if (faults != nullptr && !uart.configure(faults, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    cn105_host_log_level = verbose ? 5 : 2;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+    const char* slaveName = ptsname(master);
+    // the slave stays open here too: the master would read EIO each time the component closes it
+    int slave = open(slaveName, O_RDWR | O_NOCTTY);
+    if (slave < 0 || !configureSerialLine(slave)) {
+        perror(slaveName);
+        return 1;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    if (link != nullptr) {
+        unlink(link);
+        if (symlink(slaveName, link) != 0) {
+            perror(link);
+            return 1;
+        }
+    }
+
+    cn105Emulator emulator;
+    emulator.init(model);
+    if (!std::isnan(roomTemperature)) {
+        emulator.unit.roomTemperature = roomTemperature;
+    }
+    emulator.timeScale = timeScale;
+    scenario.apply(0, emulator);
+    printf("emulating %s on %s%s%s\n", model.name, slaveName, link != nullptr ? " -> " : "", link != nullptr ? link : "");
+    fflush(stdout);
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    auto start = std::chrono::steady_clock::now();
+    auto nowMs = [&start]() {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+    uint8_t buffer[256];
+    std::vector<uint8_t> out;
+
+    while (!stopRequested) {
+        int timeoutMs = 1000;
+        uint32_t dueMs;
+        if (emulator.getNextDueMs(dueMs)) {
+            int32_t wait = (int32_t)(dueMs - nowMs());
+            timeoutMs = wait > 0 ? wait : 0;
+        }
+        struct pollfd pfd = { master, POLLIN, 0 };
+        int ready = poll(&pfd, 1, timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            ssize_t length = read(master, buffer, sizeof(buffer));
+            if (length > 0) {
+                if (verbose) {
+                    logFrame("RX", buffer, length);
+                }
+                emulator.receive(nowMs(), buffer, length);
+            }
+        }
+
+        emulator.tick(nowMs());
+        scenario.apply(emulator.plant.simulatedS, emulator);
+        out.clear();
+        int length = uart.isEnabled() ? uart.takeOutput(emulator, nowMs(), out) : emulator.takeOutput(nowMs(), out);
+        if (length > 0) {
+            if (verbose) {
+                logFrame("TX", out.data(), out.size());
+            }
+            if (write(master, out.data(), out.size()) < 0 && errno != EAGAIN) {
+                perror("write");
+            }
+        }
+    }
+
+    if (link != nullptr) {
+        unlink(link);
+    }
+    close(slave);
+    close(master);
+    printf("frames in: %u (bad checksums %u), responses: %u, acks: %u, unanswered: %u\n",
+        (unsigned int)emulator.stats.nbFramesIn, (unsigned int)emulator.stats.nbBadChecksums,
+        (unsigned int)emulator.stats.nbResponses, (unsigned int)emulator.stats.nbAcks,
+        (unsigned int)emulator.stats.nbUnanswered);
+    if (uart.isEnabled()) {
+        printf("faults:");
+        for (int fault = FAULT_DROP_BYTE; fault < FAULT_CLASS_COUNT; fault++) {
+            printf(" %s %u", faultyUart::getFaultName((FaultClass)fault), (unsigned int)uart.nbInjected[fault]);
+        }
+        printf(" (%u frames)\n", (unsigned int)uart.nbFrames);
+    }
+    return 0;
+}
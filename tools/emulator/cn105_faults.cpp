@@ -0,0 +1,236 @@
+/**
+ * Recovery from line faults: the component against the emulated unit on a virtual clock, with a
+ * faultyUart (faulty_uart.h) between them. For each fault class, episodes are run one after the
+ * other on the same link: a fault is injected on the next frame of the unit, then the loop runs
+ * until the component decodes a valid frame again.
+ *
+ * The loop is the one of the component (simulated_component.h), with its own pieces: the tx queue,
+ * cycleManagement and cn105Scheduler for the info cycles, livenessManagement for the probes
+ * (reconnection after maxMissedProbes misses) and connectionManagement for the backoff.
+ *
+ * For each class it reports the recovery in frames (frames of the unit lost from the faulty one
+ * on, 0 when the faulty frame itself is decoded) and in ms (from the faulty frame to the next
+ * valid one), with the reconnections. When the probes give the link up, the reconnection goes
+ * through the path of the component (reconnectUART(), connection packets paced by the backoff,
+ * 0x7a): it reports when the link was given up (from the last frame of the unit) and the time to
+ * reconnect (from the faulty frame to the 0x7a), with the connection packets it took.
+ *
+ * It fails (exit 1) when an episode does not recover within RECOVERY_LIMIT_MS, goes over the
+ * budget of its class (FAULT_BUDGETS), gives the link up later than the probes should, or
+ * reconnects later than the backoff allows once the line is back.
+ *
+ * usage: cn105_faults [-n episodes] [-m model] [-i interval_ms] [-S silence_ms] [-s seed] [-v]
+ *
+ * Built by the CMakeLists.txt at the root of the repository (target cn105_faults).
+*/
+#include "faulty_uart.h"
+#include "simulated_component.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+extern int cn105_host_log_level;
+
+static const uint32_t RECOVERY_LIMIT_MS = 300000;
+static const uint32_t STEP_MS = 100;                    // the harness checks the episode at this pace
+static const uint32_t RECONNECT_SLACK_MS = 1000;        // connection packet, 0x7a and loop pace
+static const float REMOTE_TEMPERATURE = 20.5f;
+
+/**
+ * Regression guard: the worst recovery accepted for each class (the framer as it is: a byte lost
+ * or a truncated frame swallows the start of the next one, a wrong length byte up to 3 frames).
+ * A response lost stalls its cycle until the cycle timeout, and no request is sent meanwhile: when
+ * the end of a truncated frame swallows the replies of two cycles, the probes may give the link up
+ * (1 to 2 % of the episodes), and the reconnection resets the framer.
+ * The frames lost in a silence depend on its duration, only its reconnections are bounded.
+*/
+struct faultBudget {
+    FaultClass fault;
+    uint32_t maxLostFrames;
+    uint32_t maxReconnections;
+};
+
+static const faultBudget FAULT_BUDGETS[] = {
+    { FAULT_DROP_BYTE, 2, 0 },
+    { FAULT_FLIP_BIT, 3, 0 },
+    { FAULT_TRUNCATE, 4, 1 },
+    { FAULT_DUPLICATE, 0, 0 },
+    { FAULT_SILENCE, UINT32_MAX, 1 },
+    { FAULT_GARBAGE, 3, 0 },
+};
+
+struct recoveryStats {
+    std::vector<double> lostFrames;
+    std::vector<double> recoveryMs;
+    std::vector<double> linkLostMs;         // from the last frame of the unit to the link given up
+    std::vector<double> reconnectMs;        // from the faulty frame to the 0x7a
+    std::vector<double> connectAttempts;
+    uint32_t nbReconnections = 0;
+    uint32_t nbStuck = 0;
+
+    static double percentile(std::vector<double> values, double p) {
+        if (values.empty()) {
+            return 0;
+        }
+        std::sort(values.begin(), values.end());
+        size_t rank = (size_t)(p / 100 * values.size() + 0.999999);
+        return values[rank > 0 ? rank - 1 : 0];
+    }
+};
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [-n episodes] [-m model] [-i interval_ms] [-S silence_ms] [-s seed] [-v]\n"
+        "  -n  episodes per fault class, default 200\n"
+        "  -m  emulated model, default generic\n"
+        "  -i  update interval of the component, default 2000 ms\n"
+        "  -S  duration of a silence, default 60000 ms (long enough for a reconnection)\n"
+        "  -s  seed of the faults and of the gaps between them, default 1\n"
+        "  -v  logs of the faults and of the decoders on stderr\n", name);
+}
+
+int main(int argc, char** argv) {
+    const emulatedModel* model = findEmulatedModel("generic");
+    int nbEpisodes = 200;
+    uint32_t intervalMs = 2000;
+    uint32_t silenceMs = 60000;
+    uint32_t seed = 1;
+    int opt;
+
+    cn105_host_log_level = 1;
+    while ((opt = getopt(argc, argv, "n:m:i:S:s:vh")) != -1) {
+        switch (opt) {
+        case 'n': nbEpisodes = atoi(optarg); break;
+        case 'm':
+            model = findEmulatedModel(optarg);
+            if (model == nullptr) {
+                fprintf(stderr, "unknown model %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'i': intervalMs = atol(optarg); break;
+        case 'S': silenceMs = atol(optarg); break;
+        case 's': seed = atol(optarg); break;
+        case 'v': cn105_host_log_level = 5; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc || nbEpisodes <= 0 || intervalMs == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    srand(seed);
+
+    virtualClock clock;
+    cn105InstallClock(&clock);
+    cn105Emulator emulator;
+    emulator.init(*model, clock.nowMs);
+    faultyUart uart;
+    uart.init(seed);
+    uart.silenceMs = silenceMs;
+    simulatedComponent component(emulator, clock);
+    component.line->uart = &uart;
+    component.updateIntervalMs = intervalMs;
+    component.setup();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    int failures = 0;
+
+    // the link is given up when the last of the probes is missed, probe intervals after the last frame
+    uint32_t maxLinkLostMs = component.liveness.probeIntervalMs * (component.liveness.maxMissedProbes + 1) + STEP_MS;
+    // once the line is back, the next connection packet goes at most one backoff delay later
+    uint32_t maxBackoffMs = CONNECT_RETRY_MAX_MS * (100 + CONNECT_RETRY_JITTER_PERCENT) / 100 + RECONNECT_SLACK_MS;
+
+    printf("%-10s %8s   %-20s   %-26s %-13s %-17s %-26s %s\n", "fault", "episodes", "lost frames p50/p95/max", "recovery ms p50/p95/max",
+        "reconnections", "link lost ms max", "reconnect ms p50/p95/max", "attempts max");
+    for (const faultBudget& budget : FAULT_BUDGETS) {
+        recoveryStats stats;
+        for (int episode = 0; episode < nbEpisodes; episode++) {
+            // back in sync, then a few clean cycles so that the fault falls on any kind of frame
+            uint32_t gapFrames = component.nbFrames + 4 + rand() % 16;
+            while (!component.isConnected() || component.nbFrames < gapFrames) {
+                component.runUntil(clock.nowMs + STEP_MS);
+            }
+
+            uint32_t nbInjected = uart.nbInjected[budget.fault];
+            uint32_t nbReconnections = component.nbLinkLost;
+            uart.inject(budget.fault);
+            if (rand() % 4 == 0) {
+                component.setRemoteTemperature(REMOTE_TEMPERATURE);     // sent at the end of the cycle: the fault may fall on its 0x61 ack
+            }
+            while (uart.nbInjected[budget.fault] == nbInjected) {
+                component.runUntil(clock.nowMs + STEP_MS);
+            }
+            // back in sync, and connected again when the probes gave the link up
+            bool stuck = false;
+            while ((component.recoveredFault != uart.lastFaultFrame || !component.isConnected()) && !stuck) {
+                component.runUntil(clock.nowMs + STEP_MS);
+                stuck = elapsedMs(clock.nowMs, uart.lastFaultMs) > RECOVERY_LIMIT_MS;
+            }
+
+            uint32_t lostFrames = component.recoveryFrames;
+            uint32_t reconnections = component.nbLinkLost - nbReconnections;
+            stats.nbReconnections += reconnections;
+            if (stuck) {
+                stats.nbStuck++;
+                continue;
+            }
+            stats.lostFrames.push_back(lostFrames);
+            stats.recoveryMs.push_back(component.recoveryMs);
+            if (reconnections > 0) {
+                uint32_t linkLostMs = elapsedMs(component.lastLinkLostMs, component.connection.lostMs);
+                uint32_t reconnectMs = elapsedMs(component.lastConnectAckMs, uart.lastFaultMs);
+                uint32_t lineBackMs = uart.lastFaultMs + (budget.fault == FAULT_SILENCE ? silenceMs : 0);
+                uint32_t lateMs = elapsedMs(component.lastConnectAckMs,
+                    isTimeReached(lineBackMs, component.lastLinkLostMs) ? lineBackMs : component.lastLinkLostMs);
+                stats.linkLostMs.push_back(linkLostMs);
+                stats.reconnectMs.push_back(reconnectMs);
+                stats.connectAttempts.push_back(component.lastConnectAttempts);
+                if (linkLostMs > maxLinkLostMs) {
+                    fprintf(stderr, "FAIL: %s episode %d: link given up %u ms after the last frame (max %u)\n",
+                        faultyUart::getFaultName(budget.fault), episode, (unsigned int)linkLostMs, (unsigned int)maxLinkLostMs);
+                    failures++;
+                }
+                if (lateMs > maxBackoffMs) {
+                    fprintf(stderr, "FAIL: %s episode %d: reconnected %u ms after the line was back (max %u)\n",
+                        faultyUart::getFaultName(budget.fault), episode, (unsigned int)lateMs, (unsigned int)maxBackoffMs);
+                    failures++;
+                }
+            }
+            if (lostFrames > budget.maxLostFrames || reconnections > budget.maxReconnections) {
+                fprintf(stderr, "FAIL: %s episode %d: %u frames lost, %u reconnections (budget %u, %u)\n",
+                    faultyUart::getFaultName(budget.fault), episode, (unsigned int)lostFrames, (unsigned int)reconnections,
+                    (unsigned int)budget.maxLostFrames, (unsigned int)budget.maxReconnections);
+                failures++;
+            }
+        }
+
+        printf("%-10s %8d   %6.0f %6.0f %6.0f   %8.0f %8.0f %8.0f   %-13u %16.0f   %8.0f %8.0f %8.0f   %12.0f\n",
+            faultyUart::getFaultName(budget.fault), nbEpisodes,
+            recoveryStats::percentile(stats.lostFrames, 50), recoveryStats::percentile(stats.lostFrames, 95),
+            recoveryStats::percentile(stats.lostFrames, 100), recoveryStats::percentile(stats.recoveryMs, 50),
+            recoveryStats::percentile(stats.recoveryMs, 95), recoveryStats::percentile(stats.recoveryMs, 100),
+            (unsigned int)stats.nbReconnections, recoveryStats::percentile(stats.linkLostMs, 100),
+            recoveryStats::percentile(stats.reconnectMs, 50), recoveryStats::percentile(stats.reconnectMs, 95),
+            recoveryStats::percentile(stats.reconnectMs, 100), recoveryStats::percentile(stats.connectAttempts, 100));
+        if (stats.nbStuck > 0) {
+            fprintf(stderr, "FAIL: %s: %u episodes without a valid frame after %u s\n", faultyUart::getFaultName(budget.fault),
+                (unsigned int)stats.nbStuck, (unsigned int)(RECOVERY_LIMIT_MS / 1000));
+            failures++;
+        }
+    }
+
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    fprintf(stderr, "%u frames sent, %u bad frames, %u frames of the unit in %.1f s\n",
+        (unsigned int)component.nbRequests, (unsigned int)component.nbBadFrames, (unsigned int)uart.nbFrames, wallS);
+    if (failures > 0) {
+        return 1;
+    }
+    fprintf(stderr, "PASS: every fault recovered within its budget\n");
+    return 0;
+}
@@ -0,0 +1,207 @@
+/**
+ * Closed loop simulation of an emulated unit driven by a scenario, on a virtual clock:
+ * a simulated day runs in a few seconds.
+ *
+ * The virtual clock is installed as the clock of the core (cn105_clock.h) and the polling is paced
+ * by the cycleManagement of the component. -w starts the clock shortly before the wraparound of
+ * the 32 bit ms counter (49.7 days of uptime) to check that the polling goes on across it.
+ *
+ * The unit is polled by the loop of the component (simulated_component.h: its tx queue, info
+ * cycles, liveness probes and reconnections), the responses go through the framer and the
+ * decoders of the component, and the decoded state is written as CSV. With -r, the remote
+ * temperature is given periodically from a room sensor (the true room temperature plus an
+ * offset), as a Home Assistant sensor would, and sent by the component at the end of a cycle.
+ *
+ * usage: cn105_simulate [-m model] [-i interval_s] [-r offset] [-R remote_period_s] [-p period_s] [-o out.csv] [-w] [-v] scenario
+ *
+ * Built by the CMakeLists.txt at the root of the repository (target cn105_simulate).
+*/
+#include "emulator_scenario.h"
+#include "simulated_component.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <string>
+
+extern int cn105_host_log_level;
+
+static const uint32_t WRAPAROUND_LEAD_MS = 600000;     // -w: 10 minutes before the ms counter wraps
+
+struct simulationStats {
+    uint32_t nbCompressorStarts = 0;
+    uint32_t nbDefrosts = 0;
+    uint32_t nbPreheats = 0;
+    double poweredS = 0;
+    double inBandS = 0;             // powered, within 0.5°C of the setpoint
+    float roomMin = INFINITY;
+    float roomMax = -INFINITY;
+};
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [-m model] [-i interval_s] [-r offset] [-R remote_period_s] [-p period_s] [-o out.csv] [-v] scenario\n"
+        "  -m  emulated model, default generic\n"
+        "  -i  update interval of the component, default 2 s\n"
+        "  -r  send the remote temperature: room temperature + offset (°C)\n"
+        "  -R  remote temperature period, default 60 s\n"
+        "  -p  period of the CSV lines, default 60 s\n"
+        "  -o  CSV output, default stdout\n"
+        "  -w  start the clock 10 minutes before the wraparound of the ms counter\n"
+        "  -v  logs of the emulator and of the decoders on stderr\n", name);
+}
+
+static const char* orDash(const char* value) {
+    return value != nullptr ? value : "-";
+}
+
+int main(int argc, char** argv) {
+    const emulatedModel* model = findEmulatedModel("generic");
+    double intervalS = 2;
+    double remoteOffset = NAN;
+    double remotePeriodS = 60;
+    double periodS = 60;
+    const char* outputPath = nullptr;
+    bool nearWraparound = false;
+    int opt;
+
+    cn105_host_log_level = 1;
+    while ((opt = getopt(argc, argv, "m:i:r:R:p:o:wvh")) != -1) {
+        switch (opt) {
+        case 'm':
+            model = findEmulatedModel(optarg);
+            if (model == nullptr) {
+                fprintf(stderr, "unknown model %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'i': intervalS = atof(optarg); break;
+        case 'r': remoteOffset = atof(optarg); break;
+        case 'R': remotePeriodS = atof(optarg); break;
+        case 'p': periodS = atof(optarg); break;
+        case 'o': outputPath = optarg; break;
+        case 'w': nearWraparound = true; break;
+        case 'v': cn105_host_log_level = 5; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc - 1 || intervalS < 0.001 || periodS < 0.001 || remotePeriodS < 0.001) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    emulatorScenario scenario;
+    std::string error;
+    if (!scenario.load(argv[optind], error)) {
+        fprintf(stderr, "%s: %s\n", argv[optind], error.c_str());
+        return 2;
+    }
+    FILE* output = outputPath != nullptr ? fopen(outputPath, "w") : stdout;
+    if (output == nullptr) {
+        perror(outputPath);
+        return 1;
+    }
+
+    virtualClock clock;
+    uint32_t startMs = nearWraparound ? (uint32_t)(0 - WRAPAROUND_LEAD_MS) : 0;
+    clock.set(startMs);
+    cn105InstallClock(&clock);
+
+    cn105Emulator emulator;
+    emulator.init(*model, startMs);
+    scenario.apply(0, emulator);
+    simulatedComponent component(emulator, clock);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    uint64_t endMs = (uint64_t)(scenario.endS * 1000);
+    // schedules in ms of the virtual clock, compared through elapsedMs() as the counter may wrap
+    uint32_t intervalMs = (uint32_t)(intervalS * 1000), remotePeriodMs = (uint32_t)(remotePeriodS * 1000);
+    uint32_t periodMs = (uint32_t)(periodS * 1000);
+    component.updateIntervalMs = intervalMs;
+    component.setup();
+    uint32_t lastRemoteMs = startMs - remotePeriodMs, lastLineMs = startMs - periodMs;
+    uint64_t simulatedMs = 0;
+    bool wasOperating = false;
+    const char* previousSubMode = nullptr;
+    uint32_t lastCycles = 0;
+    simulationStats stats;
+
+    fprintf(output, "time_s,time,room_true,room,outdoor,setpoint,power,mode,operating,frequency,input_w,kwh,stage,sub_mode\n");
+    while (simulatedMs < endMs) {
+        uint32_t previousMs = clock.nowMs;
+        double nowS = simulatedMs / 1000.0;
+        scenario.apply(nowS, emulator);
+
+        if (elapsedMs(clock.nowMs, lastRemoteMs) >= remotePeriodMs && !std::isnan(remoteOffset)) {
+            lastRemoteMs = clock.nowMs;
+            component.setRemoteTemperature(emulator.unit.roomTemperature + remoteOffset);
+        }
+        if (component.nbCompleteCycles != lastCycles) {
+            lastCycles = component.nbCompleteCycles;
+
+            const heatpumpSettings& settings = component.state.settings;
+            const heatpumpStatus& status = component.state.status;
+            if (status.operating && !wasOperating) {
+                stats.nbCompressorStarts++;
+            }
+            wasOperating = status.operating;
+            if (settings.sub_mode != previousSubMode && settings.sub_mode != nullptr) {
+                stats.nbDefrosts += strcmp(settings.sub_mode, SUB_MODE_MAP[1]) == 0;
+                stats.nbPreheats += strcmp(settings.sub_mode, SUB_MODE_MAP[2]) == 0;
+            }
+            previousSubMode = settings.sub_mode;
+        }
+        if (elapsedMs(clock.nowMs, lastLineMs) >= periodMs) {
+            const heatpumpSettings& settings = component.state.settings;
+            const heatpumpStatus& status = component.state.status;
+            uint32_t seconds = (uint32_t)nowS;
+            fprintf(output, "%u,%02u:%02u,%.2f,%.1f,%.1f,%.1f,%s,%s,%d,%.0f,%.0f,%.1f,%s,%s\n",
+                seconds, seconds / 3600, (seconds / 60) % 60, emulator.unit.roomTemperature, status.roomTemperature,
+                status.outsideAirTemperature, settings.temperature, orDash(settings.power), orDash(settings.mode),
+                status.operating, status.compressorFrequency, status.inputPower, status.kWh,
+                orDash(settings.stage), orDash(settings.sub_mode));
+            lastLineMs = clock.nowMs;
+        }
+
+        // the component runs until the next line or remote temperature, at most an update interval:
+        // the scenario and the statistics follow the cycles
+        uint32_t sleepMs = std::min(intervalMs, periodMs - std::min(periodMs, elapsedMs(clock.nowMs, lastLineMs)));
+        if (!std::isnan(remoteOffset)) {
+            sleepMs = std::min(sleepMs, remotePeriodMs - std::min(remotePeriodMs, elapsedMs(clock.nowMs, lastRemoteMs)));
+        }
+        component.runUntil(clock.nowMs + std::max(sleepMs, (uint32_t)1));
+        uint32_t stepMs = elapsedMs(clock.nowMs, previousMs);
+        simulatedMs += stepMs;
+        double elapsedS = stepMs / 1000.0;
+        if (emulator.unit.power == POWER[1]) {
+            stats.poweredS += elapsedS;
+            if (fabsf(emulator.unit.getControlTemperature() - emulator.unit.setpoint) <= 0.5f) {
+                stats.inBandS += elapsedS;
+            }
+            stats.roomMin = std::min(stats.roomMin, emulator.unit.roomTemperature);
+            stats.roomMax = std::max(stats.roomMax, emulator.unit.roomTemperature);
+        }
+    }
+    if (output != stdout) {
+        fclose(output);
+    }
+
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    fprintf(stderr, "simulated %.1f h in %.2f s (x%.0f), %u cycles, %u frames sent, %u cycles timed out, %u reconnections\n",
+        scenario.endS / 3600, wallS, wallS > 0 ? scenario.endS / wallS : 0.0, component.nbCycles, component.nbRequests,
+        component.nbCycleTimeouts, component.nbLinkLost);
+    if (nearWraparound) {
+        fprintf(stderr, "clock from %u to %u ms, across the wraparound\n", (unsigned int)startMs, (unsigned int)clock.nowMs);
+    }
+    fprintf(stderr, "energy %.2f kWh, %u compressor starts, %u defrosts, %u preheats\n",
+        emulator.unit.energyKwh, stats.nbCompressorStarts, stats.nbDefrosts, stats.nbPreheats);
+    if (stats.poweredS > 0) {
+        fprintf(stderr, "powered %.1f h, room %.1f to %.1f °C, %.0f%% of the time within 0.5 °C of the setpoint\n",
+            stats.poweredS / 3600, stats.roomMin, stats.roomMax, stats.inBandS * 100 / stats.poweredS);
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "component_scheduler.h"
+#include "cn105_clock.h"
+
+#include <memory>
+
+static const char* RETRY_PREFIX = "retry$";
+
+void componentScheduler::setTimeout(const std::string& name, uint32_t delayMs, std::function<void()>&& callback) {
+    this->cancelTimeout(name);
+    if (delayMs == UINT32_MAX) {                // SCHEDULER_DONT_RUN
+        return;
+    }
+    this->items.push_back({ name, cn105Millis() + delayMs, std::move(callback) });
+    if (this->items.size() > this->maxSize) {
+        this->maxSize = this->items.size();
+    }
+}
+
+bool componentScheduler::cancelTimeout(const std::string& name) {
+    for (auto it = this->items.begin(); it != this->items.end(); ++it) {
+        if (it->name == name) {
+            this->items.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void componentScheduler::setRetry(const std::string& name, uint32_t initialWaitMs, uint8_t maxAttempts,
+                                  std::function<RetryResult(uint8_t)>&& callback, float backoff) {
+    this->cancelRetry(name);
+    if (initialWaitMs == UINT32_MAX) {
+        return;
+    }
+    struct retryArgs {
+        std::function<RetryResult(uint8_t)> callback;
+        uint8_t retryCountdown;
+        uint32_t currentIntervalMs;
+        float backoff;
+        std::string name;
+    };
+    auto args = std::make_shared<retryArgs>();
+    args->callback = std::move(callback);
+    args->retryCountdown = maxAttempts;
+    args->currentIntervalMs = initialWaitMs;
+    args->backoff = backoff;
+    args->name = RETRY_PREFIX + name;
+
+    // shared with the copies of the handler that the items hold, the next attempt included
+    auto handler = std::make_shared<std::function<void()>>();
+    std::weak_ptr<std::function<void()>> next = handler;
+    *handler = [this, args, next]() {
+        if (args->callback(--args->retryCountdown) == RetryResult::DONE || args->retryCountdown <= 0) {
+            return;
+        }
+        if (auto again = next.lock()) {
+            this->setTimeout(args->name, args->currentIntervalMs, [again]() { (*again)(); });
+        }
+        args->currentIntervalMs = (uint32_t)(args->currentIntervalMs * args->backoff);
+    };
+    this->setTimeout(args->name, 0, [handler]() { (*handler)(); });
+}
+
+bool componentScheduler::cancelRetry(const std::string& name) {
+    return this->cancelTimeout(RETRY_PREFIX + name);
+}
+
+void componentScheduler::call() {
+    uint32_t now = cn105Millis();
+    // the items due when called: those that their callbacks add wait for the next call()
+    std::vector<item> due;
+    for (auto it = this->items.begin(); it != this->items.end();) {
+        if (isTimeReached(now, it->dueMs)) {
+            due.push_back(std::move(*it));
+            it = this->items.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto& entry : due) {
+        this->nbCalled++;
+        entry.callback();
+    }
+}
+
+bool componentScheduler::getNextDueMs(uint32_t& dueMs) const {
+    if (this->items.empty()) {
+        return false;
+    }
+    dueMs = this->items.front().dueMs;
+    for (const auto& entry : this->items) {
+        if (!isTimeReached(entry.dueMs, dueMs)) {
+            dueMs = entry.dueMs;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Stand-in for the scheduler of esphome::Component (set_timeout(), set_retry()), with its
+ * semantics: an item replaces the pending one of the same name, a delay of UINT32_MAX only
+ * cancels it, a retry runs at once then after initialWaitMs * backoff^n while the callback asks
+ * for it and attempts are left. Items added by a callback run at the next call().
+ *
+ * Time comes from cn105Millis(). size() is what the component holds in the scheduler of ESPHome,
+ * maxSize its high-water mark.
+*/
+enum class RetryResult { DONE, RETRY };
+
+struct componentScheduler {
+    size_t maxSize = 0;             // high-water mark, reset by the tools at will
+    uint32_t nbCalled = 0;          // callbacks run
+
+    void setTimeout(const std::string& name, uint32_t delayMs, std::function<void()>&& callback);
+    bool cancelTimeout(const std::string& name);
+    void setRetry(const std::string& name, uint32_t initialWaitMs, uint8_t maxAttempts,
+                  std::function<RetryResult(uint8_t)>&& callback, float backoff = 1.0f);
+    bool cancelRetry(const std::string& name);
+
+    // runs the items due, as App.loop() does before the loop() of the components
+    void call();
+    // due time of the next item, false when there is none
+    bool getNextDueMs(uint32_t& dueMs) const;
+    size_t size() const { return this->items.size(); }
+
+private:
+    struct item {
+        std::string name;
+        uint32_t dueMs;
+        std::function<void()> callback;
+    };
+    std::vector<item> items;
+};
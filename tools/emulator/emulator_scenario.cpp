@@ -0,0 +1,181 @@
+#include "emulator_scenario.h"
+#include "cn105_core_log.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static const char* SCENARIO_TAG = "SCENARIO";
+
+static bool parseTime(const std::string& text, double& seconds) {
+    int hours = 0, minutes = 0, secs = 0;
+    int fields = sscanf(text.c_str(), "%d:%d:%d", &hours, &minutes, &secs);
+    if (fields < 2 || hours < 0 || minutes < 0 || minutes > 59 || secs < 0 || secs > 59) {
+        return false;
+    }
+    seconds = hours * 3600.0 + minutes * 60.0 + secs;
+    return true;
+}
+
+static bool parseFloat(const std::string& text, float& value) {
+    char* end = nullptr;
+    value = strtof(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0' && !isnan(value);
+}
+
+static bool parseByte(const char* valuesMap[], const uint8_t byteMap[], int len, const std::string& text, uint8_t& value) {
+    int index = lookupByteMapIndex(valuesMap, len, text.c_str(), "scenario");
+    if (index < 0) {
+        return false;
+    }
+    value = byteMap[index];
+    return true;
+}
+
+bool emulatorScenario::load(const char* path, std::string& error) {
+    std::ifstream input(path);
+    if (!input) {
+        error = std::string("cannot read ") + path;
+        return false;
+    }
+    std::stringstream text;
+    text << input.rdbuf();
+    return this->parse(text.str(), error);
+}
+
+bool emulatorScenario::parse(const std::string& text, std::string& error) {
+    std::istringstream lines(text);
+    std::string line;
+    int lineNumber = 0;
+
+    this->events.clear();
+    this->next = 0;
+    double lastS = 0;
+    double endEventS = -1;
+
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream words(line);
+        std::string time, action, arg1, arg2;
+        if (!(words >> time)) {
+            continue;
+        }
+        words >> action >> arg1 >> arg2;
+
+        scenarioEvent event{};
+        event.line = lineNumber;
+        bool valid = parseTime(time, event.atS);
+        if (!valid) {
+            error = "line " + std::to_string(lineNumber) + ": bad time " + time;
+            return false;
+        }
+        if (action == "outdoor") {
+            event.action = SCENARIO_OUTDOOR;
+            valid = parseFloat(arg1, event.value);
+        } else if (action == "outdoor_cycle") {
+            event.action = SCENARIO_OUTDOOR_CYCLE;
+            valid = parseFloat(arg1, event.value) && parseFloat(arg2, event.value2) && event.value <= event.value2;
+        } else if (action == "room") {
+            event.action = SCENARIO_ROOM;
+            valid = parseFloat(arg1, event.value);
+        } else if (action == "gain") {
+            event.action = SCENARIO_GAIN;
+            valid = parseFloat(arg1, event.value);
+        } else if (action == "window") {
+            event.action = SCENARIO_WINDOW;
+            valid = parseFloat(arg1, event.value) && event.value >= 0;
+        } else if (action == "power") {
+            event.action = SCENARIO_POWER;
+            valid = parseByte(POWER_MAP, POWER, 2, arg1, event.byteValue);
+        } else if (action == "mode") {
+            event.action = SCENARIO_MODE;
+            valid = parseByte(MODE_MAP, MODE, 5, arg1, event.byteValue);
+        } else if (action == "fan") {
+            event.action = SCENARIO_FAN;
+            valid = parseByte(FAN_MAP, FAN, 6, arg1, event.byteValue);
+        } else if (action == "setpoint") {
+            event.action = SCENARIO_SETPOINT;
+            valid = parseFloat(arg1, event.value) && event.value >= 10 && event.value <= 31;
+        } else if (action == "remote") {
+            event.action = SCENARIO_REMOTE;
+            event.value = 0;
+            valid = arg1 == "off" || (parseFloat(arg1, event.value) && event.value > 0);
+        } else if (action == "end") {
+            event.action = SCENARIO_END;
+            endEventS = event.atS;
+        } else {
+            error = "line " + std::to_string(lineNumber) + ": unknown action '" + action + "'";
+            return false;
+        }
+        if (!valid) {
+            error = "line " + std::to_string(lineNumber) + ": bad value for " + action;
+            return false;
+        }
+        this->events.push_back(event);
+        lastS = std::max(lastS, event.atS);
+    }
+    this->endS = endEventS >= 0 ? endEventS : lastS;
+    // lines may be written in any order, events at the same time keep theirs
+    std::stable_sort(this->events.begin(), this->events.end(),
+        [](const scenarioEvent& a, const scenarioEvent& b) { return a.atS < b.atS; });
+    return true;
+}
+
+void emulatorScenario::apply(double simulatedS, cn105Emulator& emulator) {
+    emulatedUnit& unit = emulator.unit;
+    thermalModel& plant = emulator.plant;
+    bool applied = false;
+
+    while (this->next < this->events.size() && this->events[this->next].atS <= simulatedS) {
+        const scenarioEvent& event = this->events[this->next++];
+        switch (event.action) {
+        case SCENARIO_OUTDOOR:
+            plant.outdoorCycle = false;
+            unit.outsideAirTemperature = event.value;
+            break;
+        case SCENARIO_OUTDOOR_CYCLE:
+            plant.setOutdoorCycle(event.value, event.value2);
+            break;
+        case SCENARIO_ROOM:
+            unit.roomTemperature = event.value;
+            break;
+        case SCENARIO_GAIN:
+            plant.heatGainW = event.value;
+            break;
+        case SCENARIO_WINDOW:
+            plant.extraLossWPerK = event.value;
+            break;
+        case SCENARIO_POWER:
+            unit.power = event.byteValue;
+            break;
+        case SCENARIO_MODE:
+            unit.mode = event.byteValue;
+            break;
+        case SCENARIO_FAN:
+            unit.fan = event.byteValue;
+            break;
+        case SCENARIO_SETPOINT:
+            unit.setpoint = event.value;
+            break;
+        case SCENARIO_REMOTE:
+            unit.remoteTemperature = event.value;
+            break;
+        case SCENARIO_END:
+            break;
+        }
+        ESP_LOGD(SCENARIO_TAG, "line %d applied at %.0f s", event.line, simulatedS);
+        applied = true;
+    }
+    if (applied) {
+        plant.step(0, unit);            // the status follows the new settings at once
+    }
+}
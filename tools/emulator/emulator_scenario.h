@@ -0,0 +1,62 @@
+#pragma once
+#include "cn105_emulator.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Scripted events applied to an emulated unit at given simulated times: weather, room
+ * disturbances and changes made with the IR remote (outside of the component).
+ *
+ *   # comment
+ *   <time> <action> [values]          time: H:MM or H:MM:SS since the start, hours may exceed 24
+ *
+ *   outdoor <°C>                      fixed outdoor temperature
+ *   outdoor_cycle <min °C> <max °C>   daily cycle, minimum at 3:00 and maximum at 15:00
+ *   room <°C>                         room temperature (e.g. the initial one)
+ *   gain <W>                          internal gains: occupants, sun, appliances
+ *   window <W/K>                      extra losses: open window, door...
+ *   power|mode|fan <value>            settings changed on the unit, values of the *_MAP (ON, HEAT, AUTO...)
+ *   setpoint <°C>
+ *   remote <°C>|off                   remote temperature, as sent by the component
+ *   end                               end of the scenario
+ *
+ * See tools/emulator/scenarios/ for examples.
+*/
+enum ScenarioAction {
+    SCENARIO_OUTDOOR,
+    SCENARIO_OUTDOOR_CYCLE,
+    SCENARIO_ROOM,
+    SCENARIO_GAIN,
+    SCENARIO_WINDOW,
+    SCENARIO_POWER,
+    SCENARIO_MODE,
+    SCENARIO_FAN,
+    SCENARIO_SETPOINT,
+    SCENARIO_REMOTE,
+    SCENARIO_END,
+};
+
+struct scenarioEvent {
+    double atS;
+    ScenarioAction action;
+    float value;
+    float value2;
+    uint8_t byteValue;              // POWER, MODE, FAN
+    int line;
+};
+
+struct emulatorScenario {
+    std::vector<scenarioEvent> events;
+    double endS;                    // time of the end action, or of the last event
+
+    // false with a message naming the line on a syntax error
+    bool load(const char* path, std::string& error);
+    bool parse(const std::string& text, std::string& error);
+    // applies the events due at simulatedS that have not been applied yet
+    void apply(double simulatedS, cn105Emulator& emulator);
+    bool isFinished(double simulatedS) const { return simulatedS >= this->endS; }
+
+private:
+    size_t next = 0;
+};
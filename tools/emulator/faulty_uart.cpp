@@ -0,0 +1,171 @@
+#include "faulty_uart.h"
+#include "cn105_clock.h"
+#include "cn105_core_log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char* FAULT_TAG = "FAULT";
+
+static const char* FAULT_NAMES[FAULT_CLASS_COUNT] = { "none", "drop", "flip", "truncate", "duplicate", "silence", "garbage" };
+
+void faultyUart::init(uint32_t seed) {
+    memset(this->probability, 0, sizeof(this->probability));
+    memset(this->nbInjected, 0, sizeof(this->nbInjected));
+    this->silenceMs = 20000;
+    this->garbageMaxBytes = 8;
+    this->nbFrames = 0;
+    this->lastFaultFrame = 0;
+    this->lastFaultMs = 0;
+    this->forced = FAULT_NONE;
+    this->silent = false;
+    this->silentUntilMs = 0;
+    this->randomState = seed != 0 ? seed : 1;
+}
+
+bool faultyUart::configure(const char* spec, std::string& error) {
+    std::string text(spec);
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(',', start);
+        std::string item = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        start = end == std::string::npos ? text.size() : end + 1;
+
+        size_t equal = item.find('=');
+        std::string name = item.substr(0, equal);
+        char* valueEnd = nullptr;
+        const char* value = equal == std::string::npos ? "" : item.c_str() + equal + 1;
+        double number = strtod(value, &valueEnd);
+        if (equal == std::string::npos || valueEnd == value || *valueEnd != '\0' || number < 0) {
+            error = "bad fault '" + item + "'";
+            return false;
+        }
+        if (name == "silence_ms") {
+            this->silenceMs = (uint32_t)number;
+            continue;
+        }
+        if (name == "garbage_max") {
+            this->garbageMaxBytes = number >= 1 ? (int)number : 1;
+            continue;
+        }
+        if (name == "seed") {
+            this->randomState = number >= 1 ? (uint32_t)number : 1;
+            continue;
+        }
+        int fault = FAULT_DROP_BYTE;
+        while (fault < FAULT_CLASS_COUNT && name != FAULT_NAMES[fault]) {
+            fault++;
+        }
+        if (fault == FAULT_CLASS_COUNT || number > 1) {
+            error = "bad fault '" + item + "'";
+            return false;
+        }
+        this->probability[fault] = number;
+    }
+    return true;
+}
+
+bool faultyUart::isEnabled() const {
+    for (int fault = FAULT_DROP_BYTE; fault < FAULT_CLASS_COUNT; fault++) {
+        if (this->probability[fault] > 0) {
+            return true;
+        }
+    }
+    return this->forced != FAULT_NONE;
+}
+
+FaultClass faultyUart::transmit(uint32_t nowMs, const uint8_t* frame, int length, std::vector<uint8_t>& out) {
+    this->nbFrames++;
+    if (this->silent && !isTimeReached(nowMs, this->silentUntilMs)) {
+        return FAULT_SILENCE;                   // lost in the silence that is already running
+    }
+    this->silent = false;
+
+    FaultClass fault = this->drawFault();
+    if (fault == FAULT_NONE || length < 2) {
+        out.insert(out.end(), frame, frame + length);
+        return FAULT_NONE;
+    }
+    this->nbInjected[fault]++;
+    this->lastFaultFrame = this->nbFrames;
+    this->lastFaultMs = nowMs;
+    ESP_LOGD(FAULT_TAG, "%s on frame %u (%02X)", FAULT_NAMES[fault], (unsigned int)this->nbFrames, frame[1]);
+
+    size_t first = out.size();
+    switch (fault) {
+    case FAULT_DROP_BYTE: {
+        int index = this->nextRandom() % length;
+        out.insert(out.end(), frame, frame + index);
+        out.insert(out.end(), frame + index + 1, frame + length);
+        break;
+    }
+    case FAULT_FLIP_BIT:
+        out.insert(out.end(), frame, frame + length);
+        out[first + this->nextRandom() % length] ^= (uint8_t)(1 << (this->nextRandom() % 8));
+        break;
+    case FAULT_TRUNCATE:
+        out.insert(out.end(), frame, frame + 1 + this->nextRandom() % (length - 1));
+        break;
+    case FAULT_DUPLICATE:
+        out.insert(out.end(), frame, frame + length);
+        out.insert(out.end(), frame, frame + length);
+        break;
+    case FAULT_SILENCE:
+        this->silent = true;
+        this->silentUntilMs = nowMs + this->silenceMs;
+        break;
+    case FAULT_GARBAGE: {
+        int count = 1 + this->nextRandom() % this->garbageMaxBytes;
+        for (int i = 0; i < count; i++) {
+            out.push_back((uint8_t)this->nextRandom());
+        }
+        out.insert(out.end(), frame, frame + length);
+        break;
+    }
+    default:
+        break;
+    }
+    return fault;
+}
+
+int faultyUart::takeOutput(cn105Emulator& emulator, uint32_t nowMs, std::vector<uint8_t>& out) {
+    size_t first = out.size();
+    while (emulator.takeFrame(nowMs, this->frame)) {
+        this->transmit(nowMs, this->frame.data(), this->frame.size(), out);
+    }
+    return out.size() - first;
+}
+
+const char* faultyUart::getFaultName(FaultClass fault) {
+    return fault < FAULT_CLASS_COUNT ? FAULT_NAMES[fault] : "?";
+}
+
+FaultClass faultyUart::drawFault() {
+    if (this->forced != FAULT_NONE) {
+        FaultClass fault = this->forced;
+        this->forced = FAULT_NONE;
+        return fault;
+    }
+    for (int fault = FAULT_DROP_BYTE; fault < FAULT_CLASS_COUNT; fault++) {
+        if (this->probability[fault] > 0 && this->nextUniform() < this->probability[fault]) {
+            return (FaultClass)fault;
+        }
+    }
+    return FAULT_NONE;
+}
+
+/**
+ * xorshift32: the same faults for the same seed, whatever the platform
+*/
+uint32_t faultyUart::nextRandom() {
+    uint32_t x = this->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    this->randomState = x;
+    return x;
+}
+
+float faultyUart::nextUniform() {
+    return (this->nextRandom() >> 8) / 16777216.0f;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "cn105_emulator.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Line faults between the emulated unit and the component: a decorator of the output of
+ * cn105Emulator, that the host tools take instead of takeOutput() (cn105_emulator_pty -F,
+ * cn105_faults, simulatedComponent::uart).
+ *
+ * Each frame of the unit goes through transmit(), that applies at most one fault, drawn with the
+ * probabilities of the spec, or the one forced by inject():
+ *   drop       a byte of the frame is lost
+ *   flip       a bit of a byte is flipped
+ *   truncate   the end of the frame is lost
+ *   duplicate  the frame is sent twice
+ *   silence    nothing reaches the component for silence_ms (this frame included)
+ *   garbage    random bytes (0xFC may be one of them) before the frame
+ *
+ * spec: comma separated <fault>=<probability per frame>, silence_ms=<ms>, garbage_max=<bytes>,
+ * seed=<n>, e.g. "drop=0.01,flip=0.01,silence=0.001,silence_ms=20000"
+*/
+enum FaultClass : uint8_t {
+    FAULT_NONE,
+    FAULT_DROP_BYTE,
+    FAULT_FLIP_BIT,
+    FAULT_TRUNCATE,
+    FAULT_DUPLICATE,
+    FAULT_SILENCE,
+    FAULT_GARBAGE,
+    FAULT_CLASS_COUNT
+};
+
+struct faultyUart {
+    float probability[FAULT_CLASS_COUNT];
+    uint32_t silenceMs;
+    int garbageMaxBytes;
+
+    uint32_t nbFrames;                          // frames of the unit, faulty or not
+    uint32_t nbInjected[FAULT_CLASS_COUNT];
+    uint32_t lastFaultFrame;                    // nbFrames of the frame that took the last fault
+    uint32_t lastFaultMs;
+
+    void init(uint32_t seed = 1);
+    bool configure(const char* spec, std::string& error);
+    bool isEnabled() const;
+    // the next frame takes this fault, whatever the probabilities
+    void inject(FaultClass fault) { this->forced = fault; }
+
+    // appends to out what reaches the component of a frame sent at nowMs, returns the fault applied
+    FaultClass transmit(uint32_t nowMs, const uint8_t* frame, int length, std::vector<uint8_t>& out);
+    // same as cn105Emulator::takeOutput(), through the faults
+    int takeOutput(cn105Emulator& emulator, uint32_t nowMs, std::vector<uint8_t>& out);
+
+    static const char* getFaultName(FaultClass fault);
+
+private:
+    FaultClass forced;
+    bool silent;
+    uint32_t silentUntilMs;
+    uint32_t randomState;
+    std::vector<uint8_t> frame;
+
+    FaultClass drawFault();
+    uint32_t nextRandom();
+    float nextUniform();
+};
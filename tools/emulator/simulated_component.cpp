@@ -0,0 +1,493 @@
+#include "simulated_component.h"
+#include "cn105_core_log.h"
+#include "cn105_encoders.h"
+#include "cn105_protocol.h"
+#include "info_response.h"
+#include "wanted_settings.h"
+
+#include <algorithm>
+
+static const char* SIM_TAG = "SIM";
+
+bool emulatorTransport::open() {
+    this->isOpen = true;
+    return true;
+}
+
+void emulatorTransport::close() {
+    this->isOpen = false;
+    this->rx.clear();
+    this->rxIndex = 0;
+}
+
+/**
+ * frame by frame, to know which frame of the unit the component gets back in sync with
+*/
+int emulatorTransport::available() {
+    if (!this->isOpen) {
+        return 0;
+    }
+    while (this->rxIndex >= this->rx.size()) {
+        this->rx.clear();
+        this->rxIndex = 0;
+        if (this->uart == nullptr) {
+            if (this->emulator.takeOutput(this->clock.nowMs, this->rx) == 0) {
+                return 0;
+            }
+        } else {
+            if (!this->emulator.takeFrame(this->clock.nowMs, this->frame)) {
+                return 0;
+            }
+            this->uart->transmit(this->clock.nowMs, this->frame.data(), this->frame.size(), this->rx);
+        }
+    }
+    return this->rx.size() - this->rxIndex;
+}
+
+bool emulatorTransport::readByte(uint8_t* data) {
+    if (this->available() == 0) {
+        return false;
+    }
+    *data = this->rx[this->rxIndex++];
+    return true;
+}
+
+void emulatorTransport::write(const uint8_t* data, int length) {
+    if (this->isOpen) {
+        this->emulator.receive(this->clock.nowMs, data, length);
+    }
+}
+
+uint32_t emulatorTransport::getFrameDurationMs(int length) {
+    return computeFrameDurationMs(length, 2400, 11);       // 8E1
+}
+
+simulatedComponent::simulatedComponent(cn105Emulator& emulator, virtualClock& clock) :
+    clock(clock), emulator(&emulator), line(new emulatorTransport(emulator, clock)), transport(*this->line) {
+    this->init({ emulator.model.wideVane, false });
+}
+
+simulatedComponent::simulatedComponent(cn105Transport& transport, virtualClock& clock, const decodeOptions& options) :
+    clock(clock), transport(transport) {
+    this->init(options);
+}
+
+void simulatedComponent::init(const decodeOptions& options) {
+    this->framer.init();
+    this->state.init();
+    this->options = options;
+    this->scheduler.init();
+    this->transmitQueue.init();
+    this->wantedSettings.resetSettings();
+    this->wantedSettings.lastChange = 0;
+}
+
+void simulatedComponent::setup() {
+    // the firmware boots with a ms counter near 0, the tools may start the clock anywhere
+    this->txCompleteMs = this->clock.nowMs;
+    this->lastResponseMs = this->clock.nowMs;
+    this->loopCycle.init();
+    this->connection.init();
+    this->liveness.init();
+    this->link.init();
+    this->setupUART();
+    this->sendFirstConnectionPacket();
+}
+
+bool simulatedComponent::loop() {
+    this->timers.call();                        // App.loop(): the scheduler, then the loop() of the components
+    this->processTxQueue();
+    if (this->processInput()) {
+        return true;
+    }
+    this->checkConnectionAttempt();
+    if (this->wantedSettings.hasChanged && !this->loopCycle.isCycleRunning()) {
+        if (elapsedMs(this->clock.nowMs, this->wantedSettings.lastChange) >= this->debounceDelayMs) {
+            this->sendWantedSettings();
+        }
+    } else if (this->loopCycle.isCycleRunning()) {
+        this->loopCycle.checkTimeout(this->updateIntervalMs);
+        if (!this->loopCycle.isCycleRunning()) {
+            this->nbCycleTimeouts++;
+        }
+    } else if (this->loopCycle.hasUpdateIntervalPassed(this->updateIntervalMs) && !this->liveness.probePending) {
+        this->buildAndSendRequestsInfoPackets();
+    }
+    this->checkLiveness();
+    return false;
+}
+
+void simulatedComponent::runUntil(uint32_t untilMs) {
+    while (true) {
+        while (this->loop()) {
+        }
+        if (isTimeReached(this->clock.nowMs, untilMs)) {
+            return;
+        }
+        this->advance(this->getNextEventMs(untilMs));
+    }
+}
+
+void simulatedComponent::advance(uint32_t toMs) {
+    this->clock.set(toMs);
+    if (this->emulator != nullptr) {
+        this->emulator->tick(toMs);
+    }
+}
+
+/**
+ * the first time after now at which loop() may act, untilMs at the latest
+*/
+uint32_t simulatedComponent::getNextEventMs(uint32_t untilMs) {
+    uint32_t now = this->clock.nowMs;
+    uint32_t next = untilMs;
+    auto consider = [&](uint32_t t) {
+        if ((int32_t)(t - now) > 0 && (int32_t)(t - next) < 0) {
+            next = t;
+        }
+    };
+
+    uint32_t dueMs;
+    if (this->emulator != nullptr && this->emulator->getNextDueMs(dueMs)) {
+        consider(dueMs);
+    }
+    if (this->timers.getNextDueMs(dueMs)) {
+        consider(isTimeReached(now, dueMs) ? now + 1 : dueMs);     // added by this loop(): the next one
+    }
+    if (this->transmitQueue.size() > 0) {
+        consider(this->txCompleteMs);
+    }
+    if (this->wantedSettings.hasChanged) {
+        consider(this->txCompleteMs + 301);
+        consider(this->wantedSettings.lastChange + this->debounceDelayMs);
+    }
+    if (this->loopCycle.isCycleRunning()) {
+        consider(this->loopCycle.lastCycleStartMs + 2 * this->updateIntervalMs + 1001);
+    } else {
+        consider(this->loopCycle.lastCompleteCycleMs + this->updateIntervalMs + 1);
+    }
+    if (this->isConnected() && this->liveness.probeIntervalMs > 0) {
+        consider(this->lastResponseMs + this->liveness.probeIntervalMs);
+        if (this->liveness.probePending) {
+            consider(this->liveness.lastProbeMs + this->liveness.probeIntervalMs + this->transport.getRttMs());
+        }
+    }
+    if (this->link.is(LinkState::UART_DOWN) || this->link.is(LinkState::CONNECTING)) {
+        consider(this->connection.lastAttemptMs + this->connection.currentDelayMs);
+    }
+    return next;
+}
+
+void simulatedComponent::setWantedSettings(const heatpumpSettings& wanted, bool tempMode) {
+    this->wantedSettings = wanted;
+    this->wantedSettings.hasChanged = true;
+    this->wantedSettings.lastChange = this->clock.nowMs;
+    this->tempMode = tempMode;
+}
+
+void simulatedComponent::setRemoteTemperature(float temperature) {
+    this->remoteTemperature = temperature;
+    this->shouldSendRemoteTemperature = true;
+}
+
+bool simulatedComponent::processInput() {
+    bool processed = false;
+    while (this->transport.available()) {
+        processed = true;
+        uint8_t inputData;
+        if (this->transport.readByte(&inputData) && this->framer.push(inputData)) {
+            this->processDataPacket();
+            this->framer.init();
+        }
+    }
+    return processed;
+}
+
+void simulatedComponent::processDataPacket() {
+    if (!this->framer.isChecksumValid()) {
+        this->nbBadFrames++;
+        return;
+    }
+    this->nbFrames++;
+    this->lastResponseMs = this->clock.nowMs;
+    this->liveness.responseReceived();
+    this->onLinkEvent(LinkEvent::RESPONSE_OK);
+
+    faultyUart* uart = this->line != nullptr ? this->line->uart : nullptr;
+    if (uart != nullptr && uart->lastFaultFrame != this->recoveredFault) {
+        this->recoveredFault = uart->lastFaultFrame;
+        this->recoveryFrames = uart->nbFrames - uart->lastFaultFrame;
+        this->recoveryMs = elapsedMs(this->clock.nowMs, uart->lastFaultMs);
+    }
+    this->processCommand();
+}
+
+void simulatedComponent::processCommand() {
+    switch (this->framer.getCommand()) {
+    case 0x61:
+        this->nbAcks++;
+        this->onLinkEvent(LinkEvent::WRITE_DONE);
+        break;
+    case 0x62:
+        if (this->framer.getDataLength() >= INFO_RESPONSE_DATA_LEN) {
+            bool known;
+            uint32_t changed = applyInfoResponse(this->framer.getData(), this->options, this->state, known);
+            this->nbPublished += __builtin_popcount(changed);
+            this->scheduleNextRequest(this->framer.getData()[0]);
+        }
+        break;
+    case 0x7a: {
+        this->nbConnectAcks++;
+        this->lastConnectAckMs = this->clock.nowMs;
+        this->lastOutageMs = this->connection.getOutageDuration();
+        this->lastConnectAttempts = this->connection.getAttempt();
+        bool warmReconnect = (this->state.settings.power != nullptr) &&
+            (this->connection.getOutageDuration() < WARM_RECONNECT_MAX_OUTAGE_MS);
+        this->onLinkEvent(LinkEvent::CONNECT_ACK);
+        this->loopCycle.lastCompleteCycleMs = this->clock.nowMs;
+        if (warmReconnect) {
+            this->nbWarmReconnects++;
+            this->buildAndSendRequestsInfoPackets();
+        } else {
+            this->state.settings.resetSettings();
+            this->state.runStates.resetSettings();
+        }
+    }
+        break;
+    default:
+        break;
+    }
+}
+
+void simulatedComponent::scheduleNextRequest(uint8_t infoCode) {
+    cycleContext context{};
+    context.cycleRunning = this->loopCycle.isCycleRunning();
+
+    cycleStep step = this->scheduler.onResponse(infoCode, context);
+    if (step.request != SCHEDULER_NO_REQUEST) {
+        this->buildAndSendRequestPacket(step.request);
+    }
+    if (step.cycleEnded) {
+        this->terminateCycle();
+    }
+}
+
+void simulatedComponent::terminateCycle() {
+    if (this->shouldSendRemoteTemperature) {
+        this->sendRemoteTemperature();
+    }
+    this->loopCycle.cycleEnded();
+    this->onLinkEvent(LinkEvent::CYCLE_COMPLETE);
+    this->nbCompleteCycles++;
+}
+
+txHandle simulatedComponent::writePacket(const uint8_t* packet, int length, bool checkIsActive, TxPriority priority) {
+    uint32_t timeoutMs = TX_SET_TIMEOUT_MS;
+    if (priority == TxPriority::PRIO_LOW) {
+        timeoutMs = TX_REQUEST_TIMEOUT_MS;
+    } else if (priority == TxPriority::PRIO_HIGH) {
+        timeoutMs = TX_CONNECT_TIMEOUT_MS;
+    }
+
+    txHandle handle = this->transmitQueue.enqueue(packet, length, priority, timeoutMs, checkIsActive);
+    this->maxQueuedFrames = std::max(this->maxQueuedFrames, this->transmitQueue.size());
+    this->processTxQueue();
+    return handle;
+}
+
+void simulatedComponent::processTxQueue() {
+    txFrame* frame;
+    while ((frame = this->transmitQueue.next()) != nullptr) {
+        if (!this->isTxComplete()) {
+            return;
+        }
+        if (this->link.is(LinkState::UART_DOWN) || (frame->checkIsActive && !this->isHeatpumpConnectionActive())) {
+            this->reconnectIfConnectionLost();
+            return;
+        }
+        this->sendFrame(frame->bytes, frame->length);
+        this->transmitQueue.complete(frame, TxStatus::SENT);
+    }
+}
+
+void simulatedComponent::sendFrame(const uint8_t* packet, int length) {
+    this->nbRequests++;
+    this->transport.write(packet, length);
+    this->txCompleteMs = this->clock.nowMs + this->transport.getFrameDurationMs(length) + this->transport.getRttMs() / 2;
+    if (length > 1 && packet[1] == HEADER[1]) {
+        this->nbWritesSent++;
+        this->onLinkEvent(LinkEvent::WRITE_SENT);
+    }
+}
+
+bool simulatedComponent::isTxComplete() {
+    return isTimeReached(this->clock.nowMs, this->txCompleteMs);
+}
+
+void simulatedComponent::buildAndSendRequestPacket(int packetType) {
+    uint8_t packet[PACKET_LEN];
+    encodeInfoRequest(packet, INFOMODE[packetType]);
+    this->writePacket(packet, PACKET_LEN, true, TxPriority::PRIO_LOW);
+}
+
+void simulatedComponent::buildAndSendRequestsInfoPackets() {
+    if (!this->isConnected()) {
+        this->reconnectIfConnectionLost();
+        return;
+    }
+    uint32_t previousStartMs = this->loopCycle.lastCycleStartMs;
+    this->loopCycle.cycleStarted();
+    if (this->hasCycleStarted) {
+        this->lastCyclePeriodMs = elapsedMs(this->loopCycle.lastCycleStartMs, previousStartMs);
+        this->totalCyclePeriodMs += this->lastCyclePeriodMs;
+        this->nbCyclePeriods++;
+        this->maxCyclePeriodMs = std::max(this->maxCyclePeriodMs, this->lastCyclePeriodMs);
+    }
+    this->hasCycleStarted = true;
+    this->nbCycles++;
+    this->buildAndSendRequestPacket(RQST_PKT_SETTINGS);
+}
+
+void simulatedComponent::sendFirstConnectionPacket() {
+    this->connection.attemptStarted();
+    if (!this->link.is(LinkState::UART_DOWN)) {
+        this->connectTxHandle = this->writePacket(CONNECT, CONNECT_LEN, false, TxPriority::PRIO_HIGH);
+    } else {
+        this->setupUART();
+    }
+}
+
+void simulatedComponent::sendWantedSettings() {
+    if (!this->isHeatpumpConnectionActive() || this->link.is(LinkState::UART_DOWN)) {
+        this->reconnectIfConnectionLost();
+        return;
+    }
+    if (!isTimeReached(this->clock.nowMs, this->txCompleteMs + 301)) {
+        return;                                 // we don't want to send too many packets
+    }
+    if (this->emulatedMutex) {
+        this->emulateMutex("WRITE_SETTINGS", [this]() { this->sendWantedSettingsDelegate(); });
+    } else {
+        this->sendWantedSettingsDelegate();
+    }
+}
+
+void simulatedComponent::sendWantedSettingsDelegate() {
+    uint8_t packet[PACKET_LEN];
+    mergeWantedSettings(packet, this->wantedSettings, this->state.settings, this->tempMode, false);
+    this->writePacket(packet, PACKET_LEN);
+    consumeWantedSettings(this->wantedSettings);
+    this->loopCycle.deferCycle();
+}
+
+/**
+ * CN105Climate::emulateMutex(): the first attempt at the next loop(), 10 attempts from 100 ms
+*/
+void simulatedComponent::emulateMutex(const char* retryName, std::function<void()>&& f) {
+    this->timers.setRetry(retryName, 100, 10, [this, f](uint8_t retryCount) {
+        if (this->wantedSettingsMutex && retryCount >= 1) {
+            return RetryResult::RETRY;
+        }
+        this->wantedSettingsMutex = true;
+        f();
+        this->wantedSettingsMutex = false;
+        return RetryResult::DONE;
+        }, 1.2f);
+}
+
+void simulatedComponent::sendRemoteTemperature() {
+    this->shouldSendRemoteTemperature = false;
+    uint8_t packet[PACKET_LEN];
+    encodeRemoteTemperature(packet, this->remoteTemperature);
+    this->writePacket(packet, PACKET_LEN);
+    this->pingExternalTemperature();            // this resets the timeout
+}
+
+void simulatedComponent::pingExternalTemperature() {
+    // SHEDULER_REMOTE_TEMP_TIMEOUT
+    this->timers.setTimeout("->remote_temp_timeout", this->remoteTempTimeoutMs, [this]() {
+        this->setRemoteTemperature(0);
+        });
+}
+
+void simulatedComponent::setupUART() {
+    if (this->isConnected()) {
+        this->onLinkEvent(LinkEvent::LINK_LOST);
+    }
+    if (this->transport.open()) {
+        this->framer.init();
+        this->onLinkEvent(LinkEvent::UART_READY);
+    } else {
+        this->onLinkEvent(LinkEvent::UART_LOST);
+    }
+}
+
+void simulatedComponent::reconnectUART() {
+    if (!this->isConnected()) {
+        return;
+    }
+    this->onLinkEvent(LinkEvent::LINK_LOST);
+    this->transport.close();
+    this->setupUART();
+}
+
+void simulatedComponent::reconnectIfConnectionLost() {
+    if (this->isConnected() && !this->isHeatpumpConnectionActive()) {
+        this->reconnectUART();
+    }
+}
+
+bool simulatedComponent::isHeatpumpConnectionActive() {
+    if (this->liveness.isLinkLost()) {
+        return false;
+    }
+    return elapsedMs(this->clock.nowMs, this->lastResponseMs) < MAX_DELAY_RESPONSE_FACTOR * this->updateIntervalMs;
+}
+
+void simulatedComponent::checkConnectionAttempt() {
+    if ((this->link.is(LinkState::UART_DOWN) || this->link.is(LinkState::CONNECTING)) && this->connection.isAttemptDue()) {
+        if (this->transmitQueue.getStatus(this->connectTxHandle) == TxStatus::QUEUED) {
+            return;
+        }
+        this->sendFirstConnectionPacket();
+    }
+}
+
+void simulatedComponent::checkLiveness() {
+    if (!this->isConnected()) {
+        return;
+    }
+    LivenessAction action = this->liveness.check(this->lastResponseMs, this->transport.getRttMs());
+    if (action == LivenessAction::PROBE_MISSED || action == LivenessAction::LINK_LOST) {
+        this->onLinkEvent(LinkEvent::PROBE_MISSED);
+    }
+    if (action == LivenessAction::LINK_LOST) {
+        ESP_LOGW(SIM_TAG, "Heatpump has not replied for %u s", (unsigned int)(elapsedMs(this->clock.nowMs, this->lastResponseMs) / 1000));
+        this->nbLinkLost++;
+        this->lastLinkLostMs = this->clock.nowMs;
+        if (this->loopCycle.isCycleRunning()) {
+            this->loopCycle.cycleEnded(true);
+            this->nbCycleTimeouts++;
+        }
+        this->reconnectUART();
+        return;
+    }
+    if (action != LivenessAction::NONE && !this->loopCycle.isCycleRunning()) {
+        this->buildAndSendRequestPacket(RQST_PKT_STATUS);
+    }
+}
+
+void simulatedComponent::onLinkEvent(LinkEvent event) {
+    bool wasConnected = this->link.isHeatpumpConnected();
+    if (!this->link.handle(event)) {
+        return;
+    }
+    bool connected = this->link.isHeatpumpConnected();
+    if (connected != wasConnected) {
+        if (connected) {
+            this->connection.connectionSucceeded();
+        } else {
+            this->connection.connectionLost(this->lastResponseMs);
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include "cn105_clock.h"
+#include "cn105_decoders.h"
+#include "cn105_emulator.h"
+#include "cn105_framer.h"
+#include "cn105_scheduler.h"
+#include "cn105_state.h"
+#include "cn105_transport.h"
+#include "component_scheduler.h"
+#include "connection_management.h"
+#include "cycle_management.h"
+#include "faulty_uart.h"
+#include "link_state_machine.h"
+#include "liveness_management.h"
+#include "tx_queue.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * The serial line to the emulated unit, as a transport of the component: what the component
+ * writes is received by the emulator at once, the frames of the unit are readable from their
+ * due time, one at a time, through the faults of the faultyUart if any.
+*/
+struct emulatorTransport : cn105Transport {
+    cn105Emulator& emulator;
+    virtualClock& clock;
+    faultyUart* uart = nullptr;
+    bool isOpen = false;
+
+    emulatorTransport(cn105Emulator& emulator, virtualClock& clock) : emulator(emulator), clock(clock) {}
+
+    const char* getName() override { return "emulator"; }
+    bool open() override;
+    void close() override;
+    int available() override;
+    bool readByte(uint8_t* data) override;
+    void write(const uint8_t* data, int length) override;
+    uint32_t getFrameDurationMs(int length) override;
+
+private:
+    std::vector<uint8_t> rx;
+    size_t rxIndex = 0;
+    std::vector<uint8_t> frame;
+};
+
+/**
+ * The component side of the offline simulations (cn105_simulate, cn105_soak, cn105_faults):
+ * CN105Climate::loop() on a virtualClock, with the pieces of the component itself: the tx queue,
+ * the info cycles (cycleManagement, cn105Scheduler), the liveness probes (livenessManagement),
+ * the reconnection backoff (connectionManagement) and the link state machine. The responses go
+ * through the framer and the state model. Only ESPHome is left out: what would be published is
+ * counted (nbPublished), the settings and remote temperature are set by the tools, and
+ * set_timeout()/set_retry() go to a componentScheduler (timers).
+ *
+ * runUntil() runs loop() at each event of the component or of the emulator (a response due,
+ * the end of a frame on the line, a cycle, a probe or a connection attempt due) and sleeps
+ * in between, the thermal model of the emulator running meanwhile.
+ *
+ * On any other transport (a tty, the pty of cn105_emulator_pty) there is no emulator to wait
+ * for: the caller sets the clock to the real time and calls loop() as ESPHome would.
+*/
+struct simulatedComponent {
+    virtualClock& clock;
+    cn105Emulator* emulator = nullptr;
+    std::unique_ptr<emulatorTransport> line;    // to the emulator, through its faultyUart if any
+    cn105Transport& transport;
+    uint32_t updateIntervalMs = 2000;
+    uint32_t debounceDelayMs = 0;
+    uint32_t remoteTempTimeoutMs = UINT32_MAX;  // remote_temp_timeout, never by default
+    bool emulatedMutex = false;                 // sendWantedSettings() through emulateMutex(), as without USE_ESP32
+
+    cn105Framer framer;
+    cn105State state;
+    decodeOptions options;
+    cycleManagement loopCycle;
+    cn105Scheduler scheduler;
+    componentScheduler timers;                  // the scheduler of esphome::Component
+    txQueue transmitQueue;
+    connectionManagement connection;
+    livenessManagement liveness;
+    linkStateMachine link;
+    wantedHeatpumpSettings wantedSettings;
+    bool wantedSettingsMutex = false;
+    bool tempMode = false;
+    float remoteTemperature = 0;
+    bool shouldSendRemoteTemperature = false;
+
+    txHandle connectTxHandle = TX_INVALID_HANDLE;
+    uint32_t lastResponseMs = 0;
+    uint32_t txCompleteMs = 0;
+
+    uint32_t nbRequests = 0;            // frames written to the line
+    uint32_t nbCycles = 0;              // cycles started
+    uint32_t nbCompleteCycles = 0;
+    uint32_t nbCycleTimeouts = 0;       // cycles ended by their timeout or by a lost link
+    uint32_t nbPublished = 0;           // fields that changed, what the component would publish
+    uint32_t lastCyclePeriodMs = 0;     // between the starts of the last two cycles
+    uint64_t totalCyclePeriodMs = 0;
+    uint32_t nbCyclePeriods = 0;
+    uint32_t maxCyclePeriodMs = 0;      // high-water marks, reset by the tools at will
+    uint32_t nbFrames = 0;              // valid frames received
+    uint32_t nbBadFrames = 0;           // frames with a bad checksum
+    uint32_t nbAcks = 0;
+    uint32_t nbWritesSent = 0;          // set frames (0x41) on the wire
+    uint32_t nbConnectAcks = 0;
+    uint32_t nbWarmReconnects = 0;
+    uint32_t nbLinkLost = 0;            // reconnections decided by the liveness probes
+    uint32_t lastLinkLostMs = 0;
+    uint32_t lastConnectAckMs = 0;
+    uint32_t lastOutageMs = 0;          // at the last 0x7a: from the last frame before the outage
+    uint32_t lastConnectAttempts = 0;   // at the last 0x7a: connection packets sent for it
+    int maxQueuedFrames = 0;            // high-water mark of the tx queue
+    // first valid frame after the last fault of the uart: frames of the unit lost, time to get it
+    uint32_t recoveredFault = 0;        // uart->lastFaultFrame once recovered from it
+    uint32_t recoveryFrames = 0;
+    uint32_t recoveryMs = 0;
+
+    simulatedComponent(cn105Emulator& emulator, virtualClock& clock);
+    simulatedComponent(cn105Transport& transport, virtualClock& clock, const decodeOptions& options);
+
+    // CN105Climate::setup(): the line is opened and the connection packet sent
+    void setup();
+    // CN105Climate::loop(), true when it read frames (the next loop() follows right away)
+    bool loop();
+    // loop() at each event until untilMs, included (with the emulator only)
+    void runUntil(uint32_t untilMs);
+    void advance(uint32_t toMs);
+    bool isConnected() const { return this->link.isHeatpumpConnected(); }
+
+    // what the climate entity and the remote temperature sensor of the component receive
+    void setWantedSettings(const heatpumpSettings& wanted, bool tempMode);
+    void setRemoteTemperature(float temperature);
+
+private:
+    bool hasCycleStarted = false;
+
+    void init(const decodeOptions& options);
+    bool processInput();
+    void processDataPacket();
+    void processCommand();
+    void scheduleNextRequest(uint8_t infoCode);
+    void terminateCycle();
+    txHandle writePacket(const uint8_t* packet, int length, bool checkIsActive = true, TxPriority priority = TxPriority::PRIO_NORMAL);
+    void processTxQueue();
+    void sendFrame(const uint8_t* packet, int length);
+    bool isTxComplete();
+    void buildAndSendRequestPacket(int packetType);
+    void buildAndSendRequestsInfoPackets();
+    void sendFirstConnectionPacket();
+    void sendWantedSettings();
+    void sendWantedSettingsDelegate();
+    void emulateMutex(const char* retryName, std::function<void()>&& f);
+    void sendRemoteTemperature();
+    void pingExternalTemperature();
+    void setupUART();
+    void reconnectUART();
+    void reconnectIfConnectionLost();
+    bool isHeatpumpConnectionActive();
+    void checkConnectionAttempt();
+    void checkLiveness();
+    void onLinkEvent(LinkEvent event);
+    uint32_t getNextEventMs(uint32_t untilMs);
+};
@@ -0,0 +1,196 @@
+#include "thermal_model.h"
+#include "cn105_emulator.h"
+
+#include <math.h>
+
+static const float STANDBY_INPUT_POWER = 5;         // W, unit powered off
+static const float FAN_INPUT_POWER = 25;            // W, indoor fan
+static const float DEFAULT_OUTDOOR_C = 10;          // when the unit has no outdoor sensor
+static const float MAX_STEP_S = 1;
+
+static float clampFloat(float value, float min, float max) {
+    return value < min ? min : (value > max ? max : value);
+}
+
+void thermalModel::init() {
+    this->heatGainW = 0;
+    this->extraLossWPerK = 0;
+    this->outdoorCycle = false;
+    this->outdoorMinC = 0;
+    this->outdoorMaxC = 0;
+    this->simulatedS = 0;
+    this->frequency = 0;
+    this->integral = 0;
+    this->compressorOn = false;
+    this->offS = 0;
+    this->runSinceDefrostS = 0;
+    this->defrostS = 0;
+    this->preheatS = 0;
+    this->heating = true;
+    this->wasPowered = false;
+}
+
+void thermalModel::setOutdoorCycle(float minC, float maxC) {
+    this->outdoorCycle = true;
+    this->outdoorMinC = minC;
+    this->outdoorMaxC = maxC;
+}
+
+void thermalModel::step(float seconds, emulatedUnit& unit) {
+    if (seconds <= 0) {
+        this->stepOnce(0, unit);
+        return;
+    }
+    // 1 s steps: a day is 86400 steps, a fraction of a second of CPU
+    while (seconds > 0) {
+        float dt = seconds < MAX_STEP_S ? seconds : MAX_STEP_S;
+        this->stepOnce(dt, unit);
+        seconds -= dt;
+    }
+}
+
+/**
+ * > 0 when the control temperature needs the unit to run, in the current direction (heating)
+*/
+float thermalModel::getDemand(emulatedUnit& unit) {
+    float control = unit.getControlTemperature();
+
+    if (unit.mode == MODE[0]) {                                 // HEAT
+        this->heating = true;
+    } else if (unit.mode == MODE[1] || unit.mode == MODE[2]) {  // DRY, COOL
+        this->heating = false;
+    } else if (unit.mode == MODE[4]) {                          // AUTO: switches with a 1°C dead band
+        if (control < unit.setpoint - 1) {
+            this->heating = true;
+        } else if (control > unit.setpoint + 1) {
+            this->heating = false;
+        }
+    } else {                                                    // FAN
+        return 0;
+    }
+    return this->heating ? unit.setpoint - control : control - unit.setpoint;
+}
+
+void thermalModel::stepOnce(float dt, emulatedUnit& unit) {
+    this->simulatedS += dt;
+    if (this->outdoorCycle) {
+        float hour = fmod(this->simulatedS / 3600.0, 24.0);
+        float mean = (this->outdoorMinC + this->outdoorMaxC) / 2;
+        float amplitude = (this->outdoorMaxC - this->outdoorMinC) / 2;
+        unit.outsideAirTemperature = mean + amplitude * cosf(2 * M_PI * (hour - 15) / 24);
+    }
+    float outdoor = isnan(unit.outsideAirTemperature) ? DEFAULT_OUTDOOR_C : unit.outsideAirTemperature;
+    bool powered = unit.power == POWER[1];
+    float outputW = 0;
+    float inputW = powered ? FAN_INPUT_POWER : STANDBY_INPUT_POWER;
+
+    unit.subMode = SUB_MODE[0];
+    unit.autoSubMode = AUTO_SUB_MODE[0];
+
+    if (!powered) {
+        this->compressorOn = false;
+        this->wasPowered = false;
+        this->integral = 0;
+        this->offS += dt;
+    } else {
+        if (!this->wasPowered) {
+            this->offS = this->params.minOffS;      // a power on may start the compressor at once
+            this->wasPowered = true;
+        }
+        float demand = this->getDemand(unit);
+        bool wasHeating = this->heating;
+
+        // thermostat with hysteresis and a minimum off time
+        if (unit.mode == MODE[3]) {
+            this->compressorOn = false;
+        } else if (this->compressorOn && demand < -this->params.thermoOffK) {
+            this->compressorOn = false;
+            this->offS = 0;
+            this->integral = 0;
+        } else if (!this->compressorOn && demand > this->params.thermoOnK && this->offS >= this->params.minOffS) {
+            this->compressorOn = true;
+            this->preheatS = this->heating ? this->params.preheatDurationS : 0;
+        }
+
+        if (this->compressorOn && this->heating && this->defrostS <= 0 && outdoor < this->params.defrostBelowC &&
+            this->runSinceDefrostS >= this->params.defrostIntervalS) {
+            this->defrostS = this->params.defrostDurationS;
+            this->runSinceDefrostS = 0;
+        }
+
+        float target = 0;
+        if (this->compressorOn) {
+            this->integral = clampFloat(this->integral + demand * this->params.integralHzPerKS * dt, 0, this->params.maxFrequency);
+            target = clampFloat(this->params.proportionalHzPerK * demand + this->integral, this->params.minFrequency, this->params.maxFrequency);
+            if (unit.mode == MODE[1]) {             // DRY: low capacity
+                target = clampFloat(target, 0, this->params.minFrequency + (this->params.maxFrequency - this->params.minFrequency) * 0.3f);
+            }
+            if (this->defrostS > 0) {
+                target = this->params.maxFrequency * 0.6f;
+            }
+        } else {
+            this->offS += dt;
+        }
+        float slew = this->params.frequencySlewHzPerS * dt;
+        this->frequency = !this->compressorOn ? 0 : (dt == 0 ? this->frequency : clampFloat(target, this->frequency - slew, this->frequency + slew));
+        if (this->compressorOn && this->frequency < this->params.minFrequency) {
+            this->frequency = this->params.minFrequency;
+        }
+
+        if (this->compressorOn) {
+            // less capacity and efficiency as the outdoor temperature moves away from the room's
+            float capacityFactor = this->heating ? clampFloat(1 - 0.02f * (7 - outdoor), 0.4f, 1.1f) : clampFloat(1 - 0.015f * (outdoor - 35), 0.5f, 1.1f);
+            float output = this->params.nominalOutputW * this->frequency / this->params.maxFrequency * capacityFactor;
+            float cop = clampFloat(6.5f - 0.1f * fabsf(unit.roomTemperature - outdoor) - 0.02f * this->frequency, 1.5f, 6);
+            inputW += output / cop;
+
+            if (this->defrostS > 0) {
+                unit.subMode = SUB_MODE[1];                     // DEFROST: reversed cycle, indoor fan stopped
+                outputW = -0.2f * output;
+                this->defrostS -= dt;
+            } else if (this->preheatS > 0) {
+                unit.subMode = SUB_MODE[2];                     // PREHEAT: indoor fan waits for the coil
+                this->preheatS -= dt;
+            } else {
+                outputW = this->heating ? output : -output;
+                if (this->heating) {
+                    this->runSinceDefrostS += dt;
+                }
+            }
+        } else if (this->heating && unit.mode != MODE[3]) {
+            unit.subMode = SUB_MODE[3];                         // STANDBY: setpoint reached in heating
+        }
+        if (unit.mode == MODE[4]) {
+            unit.autoSubMode = this->heating ? AUTO_SUB_MODE[2] : AUTO_SUB_MODE[1];
+        }
+        if (wasHeating != this->heating) {
+            this->integral = 0;
+        }
+    }
+
+    float losses = (this->params.lossWPerK + this->extraLossWPerK) * (unit.roomTemperature - outdoor);
+    unit.roomTemperature += (outputW + this->heatGainW - losses) * dt / (this->params.capacityKJPerK * 1000);
+    unit.energyKwh += inputW * dt / 3600000.0f;
+    if (powered) {
+        unit.runtimeMinutes += dt / 60;
+    }
+
+    this->updateStatus(unit, outputW);
+    unit.inputPower = (uint16_t)lroundf(inputW);
+}
+
+void thermalModel::updateStatus(emulatedUnit& unit, float outputW) {
+    unit.operating = this->compressorOn;
+    unit.compressorFrequency = (uint8_t)lroundf(this->frequency);
+
+    if (unit.power != POWER[1]) {
+        unit.stage = STAGE[0];                                  // IDLE
+    } else if (unit.mode == MODE[3]) {
+        unit.stage = STAGE[6];                                  // DIFFUSE: fan only
+    } else if (outputW == 0 || unit.subMode == SUB_MODE[1]) {
+        unit.stage = STAGE[0];
+    } else {
+        float ratio = this->frequency / this->params.maxFrequency;
+        unit.stage = ratio < 0.2f ? STAGE[1] : (ratio < 0.4f ? STAGE[2] : (ratio < 0.6f ? STAGE[3] : (ratio < 0.8f ? STAGE[4] : STAGE[5])));
+    }
+}
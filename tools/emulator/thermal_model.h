@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+
+struct emulatedUnit;
+
+/**
+ * Parameters of the room and of the heatpump, the defaults are a ~35 m² room with a 2.5 kW unit
+*/
+struct thermalParameters {
+    float capacityKJPerK = 2300;            // thermal mass of the room (air, walls, furniture)
+    float lossWPerK = 80;                   // losses to the outside
+    float nominalOutputW = 2500;            // heat (or cold) output at the maximum frequency
+    float minFrequency = 15;                // Hz
+    float maxFrequency = 90;
+    float frequencySlewHzPerS = 1;          // how fast the inverter ramps
+    float proportionalHzPerK = 40;          // PI controller of the frequency on the setpoint error
+    float integralHzPerKS = 0.02f;
+    float thermoOffK = 0.5f;                // compressor stops this far past the setpoint
+    float thermoOnK = 0.3f;                 // and restarts this far before it
+    float minOffS = 180;
+    float defrostBelowC = 5;                // defrost cycles when heating below this outdoor temperature
+    float defrostIntervalS = 2700;          // compressor time between two defrosts
+    float defrostDurationS = 360;
+    float preheatDurationS = 120;           // cold coil: no heat delivered after a heating start
+};
+
+/**
+ * Room/outdoor thermal model driving the status of an emulated unit: the compressor frequency follows
+ * the error between the setpoint and the control temperature (remote or internal), the heat output
+ * changes the room temperature, heating below defrostBelowC goes through DEFROST episodes, and heating
+ * starts with a PREHEAT period. Input power, energy and runtime counters follow.
+ * The outdoor temperature is constant or a daily cycle (minimum at 3:00, maximum at 15:00).
+*/
+struct thermalModel {
+    thermalParameters params;
+
+    // inputs set by the scenarios
+    float heatGainW;                        // occupants, sun, appliances
+    float extraLossWPerK;                   // open window...
+    bool outdoorCycle;
+    float outdoorMinC;
+    float outdoorMaxC;
+
+    double simulatedS;                      // time of the model since init()
+
+    void init();
+    // advances the model by seconds (simulated time), 0 only refreshes the status from the settings
+    void step(float seconds, emulatedUnit& unit);
+    void setOutdoorCycle(float minC, float maxC);
+
+private:
+    float frequency;
+    float integral;
+    bool compressorOn;
+    float offS;                             // time since the compressor stopped
+    float runSinceDefrostS;
+    float defrostS;                         // remaining time of the current defrost
+    float preheatS;                         // remaining time of the current preheat
+    bool heating;                           // current direction, AUTO switches it
+    bool wasPowered;
+
+    void stepOnce(float seconds, emulatedUnit& unit);
+    float getDemand(emulatedUnit& unit);
+    void updateStatus(emulatedUnit& unit, float outputW);
+};
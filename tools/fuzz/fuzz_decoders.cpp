@@ -0,0 +1,40 @@
+/**
+ * Fuzz target: every decoder on an arbitrary 0x62 response.
+ * Input: options byte (bit 0: wide vane, bit 1: fahrenheit) + INFO_RESPONSE_DATA_LEN data bytes.
+*/
+#include "cn105_decoders.h"
+
+#include <stddef.h>
+
+extern int cn105_host_log_level;
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    cn105_host_log_level = 0;
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* bytes, size_t size) {
+    if (size < 1 + INFO_RESPONSE_DATA_LEN) {
+        return 0;
+    }
+    decodeOptions options{ (bytes[0] & 0x01) != 0, (bytes[0] & 0x02) != 0 };
+    // exact size copy: ASan reports any read past the data of the frame
+    uint8_t data[INFO_RESPONSE_DATA_LEN];
+    for (int i = 0; i < INFO_RESPONSE_DATA_LEN; i++) {
+        data[i] = bytes[1 + i];
+    }
+
+    settingsDecoded settings = decodeSettings(data, options);
+    (void)settings;
+
+    heatpumpStatus status{};
+    decodeRoomTemperature(data, options, status);
+    decodeStatus(data, status);
+
+    heatpumpSettings stage{};
+    decodeStage(data, stage);
+
+    heatpumpRunStates runStates{};
+    decodeHVACOptions(data, runStates);
+    return 0;
+}
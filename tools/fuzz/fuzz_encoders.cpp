@@ -0,0 +1,75 @@
+/**
+ * Fuzz target: frames built from arbitrary wanted settings, remote temperature and run states.
+ * Input bytes:
+ *   0      presence of power, mode, fan, vane, wideVane, temperature (bits 0-5), tempMode (6), wideVaneAdj (7)
+ *   1-5    power, mode, fan, vane, wideVane: index in their *_MAP, out of range gives an unknown string
+ *   6-9    wanted temperature (float)
+ *   10-13  remote temperature (float)
+ *   14     airflow control index (0xFF: not set)
+ *   15-17  air purifier, night mode, circulator (int8, -1: not set)
+ *   18     info code of a request
+*/
+#include "cn105_encoders.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern int cn105_host_log_level;
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    cn105_host_log_level = 0;
+    return 0;
+}
+
+static const int FUZZ_ENCODERS_INPUT_LEN = 19;
+
+static const char* pick(const char* valuesMap[], int len, uint8_t index) {
+    return index < len ? valuesMap[index] : "NOT_IN_MAP";
+}
+
+// every frame must carry its header and a valid checksum
+static void check(const uint8_t* packet, uint8_t type) {
+    if (packet[0] != 0xfc || packet[1] != type || packet[21] != computeChecksum(packet, 21)) {
+        abort();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* bytes, size_t size) {
+    if (size < FUZZ_ENCODERS_INPUT_LEN) {
+        return 0;
+    }
+    uint8_t packet[PACKET_LEN];
+    uint8_t flags = bytes[0];
+
+    heatpumpSettings wanted{};
+    wanted.resetSettings();
+    wanted.power = (flags & 0x01) ? pick(POWER_MAP, 2, bytes[1]) : nullptr;
+    wanted.mode = (flags & 0x02) ? pick(MODE_MAP, 5, bytes[2]) : nullptr;
+    wanted.fan = (flags & 0x04) ? pick(FAN_MAP, 6, bytes[3]) : nullptr;
+    wanted.vane = (flags & 0x08) ? pick(VANE_MAP, 7, bytes[4]) : nullptr;
+    wanted.wideVane = (flags & 0x10) ? pick(WIDEVANE_MAP, 8, bytes[5]) : nullptr;
+    if (flags & 0x20) {
+        memcpy(&wanted.temperature, &bytes[6], sizeof(float));
+    }
+    encodeSettings(packet, wanted, (flags & 0x40) != 0, (flags & 0x80) != 0);
+    check(packet, 0x41);
+
+    float remoteTemperature;
+    memcpy(&remoteTemperature, &bytes[10], sizeof(float));
+    encodeRemoteTemperature(packet, remoteTemperature);
+    check(packet, 0x41);
+
+    heatpumpRunStates runStates{};
+    runStates.resetSettings();
+    runStates.airflow_control = (bytes[14] != 0xFF) ? pick(AIRFLOW_CONTROL_MAP, 3, bytes[14]) : nullptr;
+    runStates.air_purifier = (int8_t)bytes[15];
+    runStates.night_mode = (int8_t)bytes[16];
+    runStates.circulator = (int8_t)bytes[17];
+    encodeRunStates(packet, runStates);
+    check(packet, 0x41);
+
+    encodeInfoRequest(packet, bytes[18]);
+    check(packet, 0x42);
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * Fuzz target: arbitrary byte stream through the framer, the checksum and the decoders,
+ * as the component does with the bytes read from the UART.
+*/
+#include "cn105_framer.h"
+#include "cn105_decoders.h"
+#include "cn105_state.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+extern int cn105_host_log_level;
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    cn105_host_log_level = 0;
+    return 0;
+}
+
+static void decode(const uint8_t* data, const decodeOptions& options, cn105State& state) {
+    switch (data[0]) {
+    case 0x02:
+        state.applySettings(decodeSettings(data, options).settings);
+        break;
+    case 0x03:
+        decodeRoomTemperature(data, options, state.status);
+        break;
+    case 0x06:
+        decodeStatus(data, state.status);
+        break;
+    case 0x09: {
+        heatpumpSettings received{};
+        decodeStage(data, received);
+        state.applyStage(received);
+    }
+        break;
+    case 0x42: {
+        heatpumpRunStates received{};
+        decodeHVACOptions(data, received);
+        state.applyRunStates(received, FIELD_AIR_PURIFIER | FIELD_NIGHT_MODE | FIELD_CIRCULATOR);
+    }
+        break;
+    default:
+        break;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* bytes, size_t size) {
+    cn105Framer framer;
+    framer.init();
+    cn105State state;
+    state.init();
+    decodeOptions options{ true, (size & 1) != 0 };
+
+    for (size_t i = 0; i < size; i++) {
+        if (!framer.push(bytes[i])) {
+            continue;
+        }
+        if (framer.getFrameLength() > MAX_DATA_BYTES) {
+            abort();        // the framer wrote past its buffer
+        }
+        if (framer.isChecksumValid() && framer.getCommand() == 0x62 &&
+            framer.getDataLength() >= INFO_RESPONSE_DATA_LEN) {
+            decode(framer.getData(), options, state);
+        }
+        framer.init();
+    }
+    return 0;
+}
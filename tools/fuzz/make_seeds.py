@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""Writes the seed corpus of the fuzz targets from the frames documented in the sources.
+
+    python3 tools/fuzz/make_seeds.py        # rewrites tools/fuzz/corpus/
+"""
+import os
+import struct
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def frame(hex_bytes):
+    return bytes.fromhex(hex_bytes)
+
+
+def build(packet_type, data):
+    body = bytes([0xFC, packet_type, 0x01, 0x30, len(data)]) + bytes(data)
+    return body + bytes([(0xFC - sum(body)) & 0xFF])
+
+
+def pad(data):
+    return list(data) + [0] * (16 - len(data))
+
+
+# responses documented in hp_readings.cpp (and the settings/stage ones of the replay sample)
+RESPONSES = {
+    "connect_ack": frame("FC 7A 01 30 01 00 54"),
+    "settings": build(0x62, pad([0x02, 0, 0, 1, 3, 0x0B, 0, 0, 0, 0, 0x03, 0xAA])),
+    "settings_isee": build(0x62, pad([0x02, 0, 0, 1, 0x09, 0x0B, 3, 7, 0, 0, 0x80, 0xAC, 0, 0, 1])),
+    "room_temperature": frame("FC 62 01 30 10 03 00 00 0E 00 94 B0 B0 FE 42 00 01 0A 64 00 00 A9"),
+    "status": frame("FC 62 01 30 10 06 00 00 1A 01 00 00 00 00 00 00 00 00 00 00 00 3C"),
+    "status_energy": frame("FC 62 01 30 10 06 00 00 00 01 00 08 05 50 00 00 42 00 00 00 00 B7"),
+    "stage": frame("FC 62 01 30 10 09 00 00 00 02 02 00 00 00 00 00 00 00 00 00 00 50"),
+    "hvac_options": frame("FC 62 01 30 10 42 01 01 01 00 00 00 00 00 00 00 00 00 00 00 00 18"),
+    "set_ack": build(0x61, pad([])),
+}
+
+
+def write(target, name, data):
+    directory = os.path.join(HERE, "corpus", target)
+    os.makedirs(directory, exist_ok=True)
+    with open(os.path.join(directory, name), "wb") as output:
+        output.write(data)
+
+
+def main():
+    for name, data in RESPONSES.items():
+        write("framer", name, data)
+    # a complete cycle in one stream, with noise before the first frame
+    write("framer", "cycle", b"\x00\x55" + b"".join(RESPONSES.values()))
+
+    for name, data in RESPONSES.items():
+        if data[1] == 0x62:
+            for options in (0, 3):
+                write("decoders", "%s_%d" % (name, options), bytes([options]) + data[5:21])
+
+    # flags, power, mode, fan, vane, wideVane, temperature, remote temperature, airflow, switches, info code
+    write("encoders", "all_fields", bytes([0x3F, 1, 3, 2, 6, 2]) + struct.pack("<ff", 21.0, 20.5) + bytes([1, 1, 0, 1, 0x02]))
+    write("encoders", "tempmode", bytes([0xFF, 0, 1, 5, 0, 7]) + struct.pack("<ff", 22.5, 0.0) + bytes([0xFF, 0xFF, 0xFF, 0xFF, 0x06]))
+    write("encoders", "unknown_values", bytes([0x3F, 9, 9, 9, 9, 9]) + struct.pack("<ff", float("nan"), 1e30) + bytes([7, 0, 1, 0, 0x42]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,199 @@
+/**
+ * Driver of the fuzz targets for compilers without libFuzzer (GCC).
+ *
+ * It runs the seed corpus, then random mutations of it (bit flips, byte changes, insertions,
+ * deletions, splices) until -runs or -max_total_time is reached, and reports the execs/s.
+ * Unlike libFuzzer it has no coverage feedback: new inputs are not added to the corpus.
+ * When a sanitizer aborts, the input is written to crash-<target>-<time> to reproduce it.
+ *
+ * usage: fuzz_<target> [-runs=N] [-max_total_time=S] [-seed=N] corpus_dir_or_file...
+*/
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<sanitizer/common_interface_defs.h>)
+#include <sanitizer/common_interface_defs.h>
+#define CN105_HAS_DEATH_CALLBACK 1
+#endif
+#endif
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+
+static const size_t MAX_INPUT_LEN = 256;
+
+static const char* targetName = "target";
+static std::vector<uint8_t> currentInput;
+
+static void writeCurrentInput() {
+    char path[128];
+    snprintf(path, sizeof(path), "crash-%s-%ld", targetName, (long)time(nullptr));
+    FILE* file = fopen(path, "wb");
+    if (file != nullptr) {
+        fwrite(currentInput.data(), 1, currentInput.size(), file);
+        fclose(file);
+        fprintf(stderr, "input written to %s\n", path);
+    }
+}
+
+static void loadInput(const std::string& path, std::vector<std::vector<uint8_t>>& corpus) {
+    std::ifstream input(path, std::ios::binary);
+    if (input) {
+        corpus.emplace_back((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    }
+}
+
+static void loadCorpus(const char* path, std::vector<std::vector<uint8_t>>& corpus) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        loadInput(path, corpus);
+        return;
+    }
+    DIR* dir = opendir(path);
+    if (dir == nullptr) {
+        return;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            loadInput(std::string(path) + "/" + entry->d_name, corpus);
+        }
+    }
+    closedir(dir);
+}
+
+// xorshift: reproducible with -seed
+static uint32_t rngState = 2463534242u;
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static void mutate(std::vector<uint8_t>& input, const std::vector<std::vector<uint8_t>>& corpus) {
+    int nbMutations = 1 + nextRandom() % 4;
+    for (int i = 0; i < nbMutations; i++) {
+        size_t position = input.empty() ? 0 : nextRandom() % input.size();
+        switch (nextRandom() % 6) {
+        case 0:         // flip a bit
+            if (!input.empty()) input[position] ^= 1 << (nextRandom() % 8);
+            break;
+        case 1:         // random byte
+            if (!input.empty()) input[position] = nextRandom();
+            break;
+        case 2:         // interesting byte: header, length, boundaries
+        {
+            static const uint8_t INTERESTING[] = { 0x00, 0x01, 0x10, 0x30, 0x3a, 0x3b, 0x62, 0x7f, 0x80, 0xfc, 0xff };
+            if (!input.empty()) input[position] = INTERESTING[nextRandom() % sizeof(INTERESTING)];
+        }
+            break;
+        case 3:         // insert a byte
+            if (input.size() < MAX_INPUT_LEN) input.insert(input.begin() + position, (uint8_t)nextRandom());
+            break;
+        case 4:         // erase a byte
+            if (!input.empty()) input.erase(input.begin() + position);
+            break;
+        case 5:         // splice with another input of the corpus
+        {
+            const std::vector<uint8_t>& other = corpus[nextRandom() % corpus.size()];
+            if (!other.empty()) {
+                size_t from = nextRandom() % other.size();
+                size_t length = 1 + nextRandom() % (other.size() - from);
+                input.insert(input.begin() + position, other.begin() + from, other.begin() + from + length);
+                if (input.size() > MAX_INPUT_LEN) input.resize(MAX_INPUT_LEN);
+            }
+        }
+            break;
+        }
+    }
+}
+
+static void run(const std::vector<uint8_t>& input) {
+    currentInput = input;
+    LLVMFuzzerTestOneInput(currentInput.data(), currentInput.size());
+}
+
+int main(int argc, char** argv) {
+    long maxRuns = -1;
+    double maxTotalTime = 10;
+    std::vector<std::vector<uint8_t>> corpus;
+
+    const char* name = strrchr(argv[0], '/');
+    targetName = name != nullptr ? name + 1 : argv[0];
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) {
+            maxRuns = atol(argv[i] + 6);
+            maxTotalTime = 0;
+        } else if (strncmp(argv[i], "-max_total_time=", 16) == 0) {
+            maxTotalTime = atof(argv[i] + 16);
+        } else if (strncmp(argv[i], "-seed=", 6) == 0) {
+            rngState = (uint32_t)atol(argv[i] + 6) | 1;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "ignored option %s\n", argv[i]);
+        } else {
+            loadCorpus(argv[i], corpus);
+        }
+    }
+    if (corpus.empty()) {
+        corpus.emplace_back();      // start from an empty input
+    }
+
+#ifdef CN105_HAS_DEATH_CALLBACK
+    __sanitizer_set_death_callback(writeCurrentInput);
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    long nbExecs = 0;
+
+    for (const std::vector<uint8_t>& input : corpus) {
+        run(input);
+        nbExecs++;
+    }
+    fprintf(stderr, "#%ld INITED corpus: %zu inputs\n", nbExecs, corpus.size());
+
+    std::vector<uint8_t> input;
+    while (true) {
+        if (maxRuns >= 0 && nbExecs >= maxRuns) {
+            break;
+        }
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (maxTotalTime > 0 && elapsed >= maxTotalTime) {
+            break;
+        }
+        if (std::chrono::duration<double>(now - lastReport).count() >= 2) {
+            fprintf(stderr, "#%ld exec/s: %.0f\n", nbExecs, nbExecs / elapsed);
+            lastReport = now;
+        }
+        // the clock is read once per batch, it would cost more than the decoders
+        for (int batch = 0; batch < 256 && (maxRuns < 0 || nbExecs < maxRuns); batch++) {
+            input = corpus[nextRandom() % corpus.size()];
+            mutate(input, corpus);
+            run(input);
+            nbExecs++;
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "#%ld DONE in %.1f s, exec/s: %.0f\n", nbExecs, elapsed, elapsed > 0 ? nbExecs / elapsed : 0.0);
+    return 0;
+}
@@ -0,0 +1,21 @@
+/**
+ * Logger of the core files (components/cn105/cn105_core_log.h) for the host builds.
+ * Messages go to stderr so that the tool output on stdout stays parseable.
+*/
+#include <stdarg.h>
+#include <stdio.h>
+
+int cn105_host_log_level = 2;
+
+void cn105_host_log(int level, const char* tag, const char* format, ...) {
+    if (level > cn105_host_log_level) {
+        return;
+    }
+    static const char LEVELS[] = "?EWICDV";
+    fprintf(stderr, "[%c][%s]: ", LEVELS[level < 7 ? level : 0], tag);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
@@ -0,0 +1,54 @@
+#include "info_response.h"
+
+#include <stdio.h>
+
+uint32_t applyInfoResponse(const uint8_t* data, const decodeOptions& options, cn105State& state, bool& known) {
+    infoResponse response = state.decodeInfoResponse(data, options);
+    known = response.known;
+    uint32_t changed = state.applyInfoResponse(response);
+    if (response.code == 0x02) {
+        // the component publishes them through heatpumpUpdate(), which holds back the ones the user is changing
+        changed |= state.applySettings(response.settings.settings);
+    }
+    return changed;
+}
+
+static const char* onOff(int value) {
+    return value ? "ON" : "OFF";
+}
+
+// fields the unit does not have (no wide vane, no stage...) stay nullptr
+static const char* orDash(const char* value) {
+    return value != nullptr ? value : "-";
+}
+
+void formatStateField(const cn105State& state, StateField field, char* out, size_t size) {
+    const heatpumpSettings& settings = state.settings;
+    const heatpumpStatus& status = state.status;
+    const heatpumpRunStates& runStates = state.runStates;
+
+    switch (field) {
+    case FIELD_POWER: snprintf(out, size, "%s", orDash(settings.power)); break;
+    case FIELD_MODE: snprintf(out, size, "%s", orDash(settings.mode)); break;
+    case FIELD_TEMPERATURE: snprintf(out, size, "%g", settings.temperature); break;
+    case FIELD_FAN: snprintf(out, size, "%s", orDash(settings.fan)); break;
+    case FIELD_VANE: snprintf(out, size, "%s", orDash(settings.vane)); break;
+    case FIELD_WIDE_VANE: snprintf(out, size, "%s", orDash(settings.wideVane)); break;
+    case FIELD_ISEE: snprintf(out, size, "%s", onOff(settings.iSee)); break;
+    case FIELD_STAGE: snprintf(out, size, "%s", orDash(settings.stage)); break;
+    case FIELD_SUB_MODE: snprintf(out, size, "%s", orDash(settings.sub_mode)); break;
+    case FIELD_AUTO_SUB_MODE: snprintf(out, size, "%s", orDash(settings.auto_sub_mode)); break;
+    case FIELD_ROOM_TEMPERATURE: snprintf(out, size, "%g", status.roomTemperature); break;
+    case FIELD_OUTSIDE_AIR_TEMPERATURE: snprintf(out, size, "%g", status.outsideAirTemperature); break;
+    case FIELD_OPERATING: snprintf(out, size, "%s", onOff(status.operating)); break;
+    case FIELD_COMPRESSOR_FREQUENCY: snprintf(out, size, "%g", status.compressorFrequency); break;
+    case FIELD_INPUT_POWER: snprintf(out, size, "%g", status.inputPower); break;
+    case FIELD_KWH: snprintf(out, size, "%g", status.kWh); break;
+    case FIELD_RUNTIME_HOURS: snprintf(out, size, "%g", status.runtimeHours); break;
+    case FIELD_AIR_PURIFIER: snprintf(out, size, "%s", onOff(runStates.air_purifier)); break;
+    case FIELD_NIGHT_MODE: snprintf(out, size, "%s", onOff(runStates.night_mode)); break;
+    case FIELD_CIRCULATOR: snprintf(out, size, "%s", onOff(runStates.circulator)); break;
+    case FIELD_AIRFLOW_CONTROL: snprintf(out, size, "%s", orDash(runStates.airflow_control)); break;
+    default: snprintf(out, size, "?"); break;
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "cn105_state.h"
+
+#include <stddef.h>
+
+/**
+ * A 0x62 info response through cn105State::decodeInfoResponse() and applyInfoResponse(), as
+ * CN105Climate::getDataFromResponsePacket() does, the settings of 0x02 applied straight to the state model:
+ * returns the mask of the fields that changed (what would be published).
+ * known is false for the info codes that the component does not decode.
+*/
+uint32_t applyInfoResponse(const uint8_t* data, const decodeOptions& options, cn105State& state, bool& known);
+
+// value of a field of the state model as the tools print it ("ON", "21.5", "HEAT"...)
+void formatStateField(const cn105State& state, StateField field, char* out, size_t size);
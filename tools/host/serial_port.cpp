@@ -0,0 +1,85 @@
+#include "serial_port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+
+bool configureSerialLine(int fd) {
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag &= ~(CSIZE | PARODD | CSTOPB);
+    tio.c_cflag |= CS8 | PARENB | CLOCAL | CREAD;
+    cfsetispeed(&tio, B2400);
+    cfsetospeed(&tio, B2400);
+    if (tcsetattr(fd, TCSANOW, &tio) == 0) {
+        return true;
+    }
+    // some kernels refuse the parity on a pty, which transmits no bits anyway
+    tio.c_cflag &= ~PARENB;
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+int openSerialPort(const char* path) {
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return -1;
+    }
+    if (!configureSerialLine(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+uint32_t getSerialFrameDurationMs(int length) {
+    return (length * SERIAL_BITS_PER_BYTE * 1000 + SERIAL_BAUD_RATE - 1) / SERIAL_BAUD_RATE;
+}
+
+bool serialTransport::open() {
+    if (this->fd < 0) {
+        this->fd = openSerialPort(this->path.c_str());
+    }
+    return this->fd >= 0;
+}
+
+void serialTransport::close() {
+    if (this->fd >= 0) {
+        ::close(this->fd);
+        this->fd = -1;
+    }
+    this->rxLength = 0;
+    this->rxIndex = 0;
+}
+
+int serialTransport::available() {
+    if (this->rxIndex >= this->rxLength) {
+        ssize_t length = this->fd >= 0 ? read(this->fd, this->rxBuffer, sizeof(this->rxBuffer)) : -1;
+        this->rxIndex = 0;
+        this->rxLength = length > 0 ? length : 0;
+    }
+    return this->rxLength - this->rxIndex;
+}
+
+bool serialTransport::readByte(uint8_t* data) {
+    if (this->available() == 0) {
+        return false;
+    }
+    *data = this->rxBuffer[this->rxIndex++];
+    return true;
+}
+
+// a frame is far shorter than the tty buffer, which the peer drains
+void serialTransport::write(const uint8_t* data, int length) {
+    if (this->fd >= 0 && ::write(this->fd, data, length) < 0 && errno != EAGAIN) {
+        perror(this->path.c_str());
+    }
+}
+
+uint32_t serialTransport::getFrameDurationMs(int length) {
+    return getSerialFrameDurationMs(length);
+}
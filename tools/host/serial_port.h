@@ -0,0 +1,43 @@
+#pragma once
+#include "cn105_transport.h"
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Serial line of the host tools: the CN105 settings (2400 bauds, 8E1, raw), on a tty or on the
+ * slave side of the pseudo-terminal of cn105_emulator_pty.
+*/
+static const int SERIAL_BAUD_RATE = 2400;
+static const int SERIAL_BITS_PER_BYTE = 11;        // start, 8 data, parity, stop
+
+// raw 8E1 at 2400 bauds; a pty does not enforce the rate but it is set for the programs that check it
+bool configureSerialLine(int fd);
+// opened non blocking and configured, -1 on error (errno set)
+int openSerialPort(const char* path);
+// time on the wire of length bytes, rounded up
+uint32_t getSerialFrameDurationMs(int length);
+
+/**
+ * The serial line as a transport of the component, for the tools that run its loop on a tty or on
+ * the pty of cn105_emulator_pty (simulatedComponent)
+*/
+struct serialTransport : cn105Transport {
+    std::string path;
+    int fd = -1;
+
+    explicit serialTransport(const char* path) : path(path) {}
+
+    const char* getName() override { return "serial"; }
+    bool open() override;
+    void close() override;
+    int available() override;
+    bool readByte(uint8_t* data) override;
+    void write(const uint8_t* data, int length) override;
+    uint32_t getFrameDurationMs(int length) override;
+
+private:
+    uint8_t rxBuffer[64];
+    int rxLength = 0;
+    int rxIndex = 0;
+};
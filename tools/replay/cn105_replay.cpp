@@ -0,0 +1,407 @@
+/**
+ * Replays captured CN105 traffic through the framer and the decoders of the component.
+ *
+ * Input: pcapng captures written by tools/cn105_trace2pcapng.py, or ESPHome logs holding
+ * packet trace dumps (TRACE lines) and live READ/WRITE lines.
+ * Output: a timeline of the frames and of the state publications, then replay statistics.
+ *
+ * Built by the CMakeLists.txt at the root of the repository (target cn105_replay).
+*/
+#include "cn105_framer.h"
+#include "cn105_decoders.h"
+#include "cn105_state.h"
+#include "info_response.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+extern int cn105_host_log_level;
+
+struct capturedFrame {
+    uint32_t timestampMs;
+    bool outbound;              // sent by the ESP
+    std::vector<uint8_t> bytes;
+};
+
+//#region input
+
+static const uint32_t PCAPNG_SHB = 0x0A0D0D0A;
+static const uint32_t PCAPNG_EPB = 0x00000006;
+static const uint16_t PCAPNG_OPT_EPB_FLAGS = 2;
+
+static uint32_t readLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t readLe16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+/**
+ * Little endian pcapng with one millisecond resolution interface, as written by cn105_trace2pcapng.py
+ */
+static bool readPcapng(const std::vector<uint8_t>& file, std::vector<capturedFrame>& frames) {
+    size_t offset = 0;
+    while (offset + 12 <= file.size()) {
+        uint32_t type = readLe32(&file[offset]);
+        uint32_t length = readLe32(&file[offset + 4]);
+        if ((length < 12) || (length % 4 != 0) || (offset + length > file.size())) {
+            fprintf(stderr, "pcapng: truncated block at offset %zu\n", offset);
+            return false;
+        }
+        if (type == PCAPNG_SHB && readLe32(&file[offset + 8]) != 0x1A2B3C4D) {
+            fprintf(stderr, "pcapng: only little endian sections are supported\n");
+            return false;
+        }
+        if (type == PCAPNG_EPB && length >= 32) {
+            const uint8_t* body = &file[offset + 8];
+            uint64_t timestamp = ((uint64_t)readLe32(body + 4) << 32) | readLe32(body + 8);
+            uint32_t captured = readLe32(body + 12);
+            size_t bodyLength = length - 12;
+            if (20 + captured > bodyLength) {
+                fprintf(stderr, "pcapng: bad packet length at offset %zu\n", offset);
+                return false;
+            }
+            capturedFrame frame{ (uint32_t)timestamp, false, std::vector<uint8_t>(body + 20, body + 20 + captured) };
+            // options follow the padded packet data
+            size_t opt = 20 + ((captured + 3) & ~3u);
+            while (opt + 4 <= bodyLength) {
+                uint16_t code = readLe16(body + opt);
+                uint16_t optLength = readLe16(body + opt + 2);
+                if (code == 0) {
+                    break;
+                }
+                if (code == PCAPNG_OPT_EPB_FLAGS && optLength == 4 && opt + 8 <= bodyLength) {
+                    frame.outbound = (readLe32(body + opt + 4) & 0x3) == 0x2;
+                }
+                opt += 4 + ((optLength + 3) & ~3u);
+            }
+            frames.push_back(std::move(frame));
+        }
+        offset += length;
+    }
+    return true;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static void parseHexBytes(const char* p, std::vector<uint8_t>& bytes) {
+    while (*p) {
+        int high = hexDigit(p[0]);
+        int low = (high < 0) ? -1 : hexDigit(p[1]);
+        if (low < 0) {
+            break;          // end of the frame (ANSI color reset, line end...)
+        }
+        bytes.push_back((high << 4) | low);
+        p += 2;
+        while (*p == ' ') p++;
+    }
+}
+
+// [HH:MM:SS] or [HH:MM:SS.mmm] printed by the logger, in ms
+static bool parseLogTime(const char* line, uint32_t& ms) {
+    int h, m, s;
+    int consumed = 0;
+    const char* bracket = strchr(line, '[');
+    if (bracket == nullptr || sscanf(bracket, "[%2d:%2d:%2d%n", &h, &m, &s, &consumed) != 3) {
+        return false;
+    }
+    int millis = 0;
+    const char* p = bracket + consumed;
+    if (*p == '.') {
+        int digits = 0;
+        for (p++; *p >= '0' && *p <= '9' && digits < 3; p++, digits++) {
+            millis = millis * 10 + (*p - '0');
+        }
+        for (; digits < 3; digits++) millis *= 10;
+    }
+    ms = ((h * 60 + m) * 60 + s) * 1000 + millis;
+    return true;
+}
+
+// start of the message of an ESPHome log line with the given tag: "[D][READ:123]: <message>"
+static const char* findTagMessage(const char* line, const char* tag) {
+    const char* p = strstr(line, tag);
+    if (p == nullptr || p == line || p[-1] != '[') {
+        return nullptr;
+    }
+    p = strstr(p, "]:");
+    if (p == nullptr) {
+        return nullptr;
+    }
+    p += 2;
+    while (*p == ' ') p++;
+    return p;
+}
+
+static void readLog(std::istream& input, std::vector<capturedFrame>& frames) {
+    std::set<unsigned long> seenTrace;      // consecutive dumps overlap
+    uint32_t lastMs = 0;
+    std::string line;
+    while (std::getline(input, line)) {
+        const char* message = findTagMessage(line.c_str(), "TRACE");
+        if (message != nullptr) {
+            unsigned long seq, ms;
+            char direction[3];
+            int consumed = 0;
+            if (sscanf(message, "%lu %lu %2s %n", &seq, &ms, direction, &consumed) != 3 || consumed == 0) {
+                continue;   // dump header line
+            }
+            if (!seenTrace.insert(seq).second) {
+                continue;
+            }
+            lastMs = ms;
+            capturedFrame frame{ lastMs, strcmp(direction, "TX") == 0, {} };
+            parseHexBytes(message + consumed, frame.bytes);
+            frames.push_back(std::move(frame));
+            continue;
+        }
+        bool outbound = true;
+        message = findTagMessage(line.c_str(), "WRITE");
+        if (message == nullptr) {
+            outbound = false;
+            message = findTagMessage(line.c_str(), "READ");
+        }
+        if (message != nullptr) {
+            uint32_t ms;
+            lastMs = parseLogTime(line.c_str(), ms) ? ms : lastMs + 1;
+            capturedFrame frame{ lastMs, outbound, {} };
+            parseHexBytes(message, frame.bytes);
+            if (!frame.bytes.empty()) {
+                frames.push_back(std::move(frame));
+            }
+        }
+    }
+}
+
+static bool readCapture(const char* path, std::vector<capturedFrame>& frames) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    uint8_t magic[4] = {};
+    input.read(reinterpret_cast<char*>(magic), 4);
+    input.clear();
+    input.seekg(0);
+    if (readLe32(magic) == PCAPNG_SHB) {
+        std::vector<uint8_t> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        return readPcapng(file, frames);
+    }
+    readLog(input, frames);
+    return true;
+}
+
+//#endregion input
+
+//#region replay
+
+struct replayStats {
+    unsigned long nbFrames = 0;
+    unsigned long nbRxFrames = 0;
+    unsigned long nbTxFrames = 0;
+    unsigned long nbBadChecksums = 0;
+    unsigned long nbUnknown = 0;
+    unsigned long nbPublications = 0;
+};
+
+/**
+ * Feeds the received bytes to the framer, decodes the responses into the state model
+ * and reports the fields that changed, i.e. what the component would publish.
+ */
+class cn105Replay {
+public:
+    cn105Replay(bool timeline, decodeOptions options) : timeline(timeline), options(options) {
+        this->framer.init();
+        this->state.init();
+    }
+
+    void replay(const capturedFrame& frame) {
+        this->clockMs = frame.timestampMs;
+        this->stats.nbFrames++;
+        if (frame.outbound) {
+            this->stats.nbTxFrames++;
+            this->describeRequest(frame.bytes);
+            return;
+        }
+        for (uint8_t byte : frame.bytes) {
+            if (this->framer.push(byte)) {
+                this->processDataPacket();
+                this->framer.init();
+            }
+        }
+    }
+
+    const replayStats& getStats() const { return this->stats; }
+
+private:
+    void event(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        if (!this->timeline) {
+            return;
+        }
+        printf("%10lu ms  ", (unsigned long)this->clockMs);
+        va_list args;
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+        putchar('\n');
+    }
+
+    void publish(StateField field) {
+        char value[32];
+        formatStateField(this->state, field, value, sizeof(value));
+        this->stats.nbPublications++;
+        this->event("  publish %s = %s", cn105State::getFieldName(field), value);
+    }
+
+    void publishChanges(uint32_t changed) {
+        for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+            if (changed & (1UL << i)) {
+                this->publish(static_cast<StateField>(1UL << i));
+            }
+        }
+    }
+
+    void describeRequest(const std::vector<uint8_t>& bytes) {
+        if (bytes.size() < 6) {
+            this->event("TX (%zu bytes)", bytes.size());
+        } else if (bytes[1] == 0x5a) {
+            this->event("TX connect");
+        } else if (bytes[1] == 0x42) {
+            this->event("TX request 0x%02X", bytes[5]);
+        } else if (bytes[1] == 0x41) {
+            this->event("TX set 0x%02X", bytes[5]);
+        } else {
+            this->event("TX command 0x%02X", bytes[1]);
+        }
+    }
+
+    void processDataPacket() {
+        this->stats.nbRxFrames++;
+        if (!this->framer.isChecksumValid()) {
+            this->stats.nbBadChecksums++;
+            this->event("RX bad checksum");
+            return;
+        }
+        const uint8_t* data = this->framer.getData();
+        switch (this->framer.getCommand()) {
+        case 0x61:
+            this->event("RX set ACK");
+            break;
+        case 0x62:
+            if (this->framer.getDataLength() < INFO_RESPONSE_DATA_LEN) {
+                this->stats.nbUnknown++;
+                this->event("RX short response (%d bytes)", this->framer.getDataLength());
+                break;
+            }
+            this->event("RX response 0x%02X", data[0]);
+            this->processResponse(data);
+            break;
+        case 0x7a:
+            this->event("RX connect ACK");
+            this->state.init();         // as a cold reconnect of the component does
+            break;
+        default:
+            this->stats.nbUnknown++;
+            this->event("RX command 0x%02X", this->framer.getCommand());
+            break;
+        }
+    }
+
+    void processResponse(const uint8_t* data) {
+        bool known;
+        uint32_t changed = applyInfoResponse(data, this->options, this->state, known);
+        if (!known) {
+            this->stats.nbUnknown++;
+        }
+        this->publishChanges(changed);
+    }
+
+    bool timeline;
+    decodeOptions options;
+    cn105Framer framer;
+    cn105State state;
+    replayStats stats;
+    uint32_t clockMs = 0;           // virtual clock: timestamp of the frame being replayed
+};
+
+//#endregion replay
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [-q] [-v] [-f] [-w] [-n repeat] capture...\n"
+        "  capture    pcapng file or ESPHome log (TRACE, READ and WRITE lines)\n"
+        "  -q         statistics only, no timeline\n"
+        "  -v         print the decoder logs (stderr), repeat for more\n"
+        "  -f         fahrenheit support mode\n"
+        "  -w         the unit supports the wide vane\n"
+        "  -n repeat  replay the captures several times (throughput measurement)\n", name);
+}
+
+int main(int argc, char** argv) {
+    bool timeline = true;
+    decodeOptions options{ false, false };
+    long repeat = 1;
+    std::vector<const char*> paths;
+    cn105_host_log_level = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            timeline = false;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            cn105_host_log_level = (cn105_host_log_level < 3) ? 3 : cn105_host_log_level + 2;
+        } else if (strcmp(argv[i], "-f") == 0) {
+            options.fahrenheitSupport = true;
+        } else if (strcmp(argv[i], "-w") == 0) {
+            options.wideVaneSupported = true;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repeat = strtol(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty() || repeat < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<capturedFrame> frames;
+    for (const char* path : paths) {
+        if (!readCapture(path, frames)) {
+            return 1;
+        }
+    }
+
+    cn105Replay replay(timeline, options);
+    auto start = std::chrono::steady_clock::now();
+    for (long pass = 0; pass < repeat; pass++) {
+        for (const capturedFrame& frame : frames) {
+            replay.replay(frame);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const replayStats& stats = replay.getStats();
+    printf("frames: %lu (rx %lu, tx %lu), bad checksums: %lu, unknown: %lu, publications: %lu\n",
+        stats.nbFrames, stats.nbRxFrames, stats.nbTxFrames, stats.nbBadChecksums, stats.nbUnknown, stats.nbPublications);
+    printf("replayed in %.3f ms (%.0f frames/s)\n", elapsed * 1000, elapsed > 0 ? stats.nbFrames / elapsed : 0.0);
+
+    return stats.nbBadChecksums > 0 ? 1 : 0;
+}
@@ -0,0 +1,361 @@
+/**
+ * Accelerated soak test: the core of the component against the emulated unit for simulated weeks,
+ * on a virtual clock started shortly before the wraparound of the ms counter.
+ *
+ * The loop of the component (simulated_component.h) runs with its own tx queue, info cycles,
+ * liveness probes and reconnections; the setpoint follows a daily routine plus random commands,
+ * the remote temperature is given every minute with a remote_temp_timeout of 5 minutes, the
+ * settings are sent through emulateMutex() as without USE_ESP32, the decoders run with the
+ * Fahrenheit mapping.
+ * The run is cut in windows (a simulated day by default) and for each of them the harness records:
+ *   - heap: live bytes and high-water mark (global operator new/delete of this program)
+ *   - pending work: the high-water mark of the tx queue of the component, and the frames it
+ *     dropped (expired or evicted), the high-water mark of the entries of the component in the
+ *     scheduler of ESPHome (set_timeout, set_retry, counted by componentScheduler)
+ *   - publications: fields that changed in the decoded state, what the component would publish
+ *   - cycles: number, mean and max period between two starts, cycles timed out, reconnections
+ *
+ * It fails (exit 1) when one of them grows without bound: the live heap or its high-water mark
+ * above the one of the first window after the warm-up, or a live heap that grows in every window
+ * (a slow leak), a deeper tx queue or more dropped frames, more scheduler entries, more
+ * publications, cycle periods
+ * drifting from the first window, or a window without any cycle (the polling stalled).
+ *
+ * usage: cn105_soak [-d days] [-i interval_ms] [-c command_period_min] [-W window_h] [-s seed] [-o out.csv] [-v]
+ *
+ * Built by the CMakeLists.txt at the root of the repository (target cn105_soak).
+*/
+#include "simulated_component.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <string>
+#include <vector>
+
+extern int cn105_host_log_level;
+
+static const uint32_t DAY_MS = 86400000;
+static const uint32_t REMOTE_PERIOD_MS = 60000;
+static const uint32_t REMOTE_TEMP_TIMEOUT_MS = 300000;
+static const uint32_t START_BEFORE_WRAP_MS = DAY_MS;    // the wraparound happens in the second window
+
+// thresholds of the growth checks, against the reference window
+static const size_t HEAP_SLACK_BYTES = 4096;
+static const double PUBLISH_GROWTH_FACTOR = 1.5;
+static const uint32_t PUBLISH_SLACK = 50;
+static const double CYCLE_DRIFT_PERCENT = 5;
+static const uint32_t TX_DROPPED_SLACK = 5;
+
+/**
+ * Heap accounting of the C++ allocations (the component allocates with new, std containers...)
+*/
+static std::atomic<size_t> liveBytes{ 0 };
+static std::atomic<size_t> peakBytes{ 0 };
+static std::atomic<size_t> liveAllocations{ 0 };
+
+static void* trackedAlloc(size_t size) {
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    size_t live = liveBytes += malloc_usable_size(p);
+    liveAllocations++;
+    size_t peak = peakBytes.load();
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live)) {
+    }
+    return p;
+}
+
+static void trackedFree(void* p) {
+    if (p != nullptr) {
+        liveBytes -= malloc_usable_size(p);
+        liveAllocations--;
+        free(p);
+    }
+}
+
+void* operator new(size_t size) { return trackedAlloc(size); }
+void* operator new[](size_t size) { return trackedAlloc(size); }
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { trackedFree(p); }
+
+struct soakWindow {
+    uint32_t index;
+    size_t liveBytes;               // at the end of the window
+    size_t peakBytes;               // high-water mark during the window
+    size_t liveAllocations;
+    int maxQueuedFrames;            // tx queue of the component
+    uint32_t nbTxDropped;
+    size_t maxTimers;               // entries in the scheduler of ESPHome
+    uint32_t nbPublished;
+    uint32_t nbCycles;
+    uint32_t nbCycleTimeouts;
+    uint32_t nbReconnections;
+    uint32_t nbCommands;
+    double meanCycleMs;
+    uint32_t maxCycleMs;
+};
+
+/**
+ * counters of the component at the start of a window
+*/
+struct soakCounters {
+    uint32_t nbPublished = 0;
+    uint32_t nbCycles = 0;
+    uint32_t nbCycleTimeouts = 0;
+    uint32_t nbReconnections = 0;
+    uint32_t nbTxDropped = 0;
+    uint32_t nbCommands = 0;
+    uint64_t totalCyclePeriodMs = 0;
+    uint32_t nbCyclePeriods = 0;
+
+    void take(const simulatedComponent& component, uint32_t nbCommands) {
+        this->nbPublished = component.nbPublished;
+        this->nbCycles = component.nbCycles;
+        this->nbCycleTimeouts = component.nbCycleTimeouts;
+        this->nbReconnections = component.nbLinkLost;
+        this->nbTxDropped = component.transmitQueue.nbExpired + component.transmitQueue.nbEvicted;
+        this->nbCommands = nbCommands;
+        this->totalCyclePeriodMs = component.totalCyclePeriodMs;
+        this->nbCyclePeriods = component.nbCyclePeriods;
+    }
+};
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [-d days] [-i interval_ms] [-c command_period_min] [-W window_h] [-s seed] [-o out.csv] [-v]\n"
+        "  -d  simulated days, default 14\n"
+        "  -i  update interval, default 2000 ms\n"
+        "  -c  mean period of the random commands, default 30 min (0: daily routine only)\n"
+        "  -W  window of the measures, default 24 h\n"
+        "  -s  seed of the random commands, default 1\n"
+        "  -o  CSV of the windows, default stdout\n"
+        "  -v  logs of the emulator and of the core on stderr\n", name);
+}
+
+static void writeWindow(FILE* out, const soakWindow& w) {
+    fprintf(out, "%u,%zu,%zu,%zu,%d,%u,%zu,%u,%u,%u,%u,%u,%.1f,%u\n", w.index, w.liveBytes, w.peakBytes, w.liveAllocations,
+        w.maxQueuedFrames, w.nbTxDropped, w.maxTimers, w.nbPublished, w.nbCommands, w.nbCycles, w.nbCycleTimeouts, w.nbReconnections,
+        w.meanCycleMs, w.maxCycleMs);
+}
+
+/**
+ * checks the last window against the reference one, returns the nb of failures
+*/
+static int checkGrowth(const std::vector<soakWindow>& windows, uint32_t intervalMs) {
+    // a cycle that times out (cycleManagement::doesCycleTimeOut) and the deferral of a command
+    uint32_t maxCycleMs = intervalMs + (2 * intervalMs + 1000) + 2 * DEFER_SCHEDULE_UPDATE_LOOP_DELAY;
+    int failures = 0;
+    if (windows.size() < 3) {
+        fprintf(stderr, "too short to check the growth: at least 3 windows are needed\n");
+        return 1;
+    }
+    const soakWindow& reference = windows[1];           // windows[0] is the warm-up
+    const soakWindow& last = windows.back();
+
+    for (const soakWindow& w : windows) {
+        if (w.nbCycles == 0) {
+            fprintf(stderr, "FAIL: no cycle in window %u, the polling stalled\n", w.index);
+            failures++;
+        }
+    }
+    // a slow leak stays under the slack for a while, but grows in every window
+    bool alwaysGrowing = windows.size() >= 5;
+    for (size_t i = 2; i < windows.size(); i++) {
+        alwaysGrowing = alwaysGrowing && windows[i].liveBytes > windows[i - 1].liveBytes;
+    }
+    if (last.liveBytes > reference.liveBytes + HEAP_SLACK_BYTES || alwaysGrowing) {
+        fprintf(stderr, "FAIL: live heap grew from %zu to %zu bytes\n", reference.liveBytes, last.liveBytes);
+        failures++;
+    }
+    if (last.peakBytes > reference.peakBytes + HEAP_SLACK_BYTES) {
+        fprintf(stderr, "FAIL: heap high-water mark grew from %zu to %zu bytes\n", reference.peakBytes, last.peakBytes);
+        failures++;
+    }
+    if (last.maxQueuedFrames > reference.maxQueuedFrames || last.maxQueuedFrames >= TX_QUEUE_SLOTS) {
+        fprintf(stderr, "FAIL: tx queue high-water mark grew from %d to %d frames\n", reference.maxQueuedFrames, last.maxQueuedFrames);
+        failures++;
+    }
+    if (last.nbTxDropped > reference.nbTxDropped + TX_DROPPED_SLACK) {
+        fprintf(stderr, "FAIL: frames dropped by the tx queue grew from %u to %u per window\n", reference.nbTxDropped, last.nbTxDropped);
+        failures++;
+    }
+    if (last.maxTimers > reference.maxTimers) {
+        fprintf(stderr, "FAIL: scheduler entries high-water mark grew from %zu to %zu\n", reference.maxTimers, last.maxTimers);
+        failures++;
+    }
+    if (last.nbPublished > reference.nbPublished * PUBLISH_GROWTH_FACTOR + PUBLISH_SLACK) {
+        fprintf(stderr, "FAIL: publications grew from %u to %u per window\n", reference.nbPublished, last.nbPublished);
+        failures++;
+    }
+    if (fabs(last.meanCycleMs - reference.meanCycleMs) > reference.meanCycleMs * CYCLE_DRIFT_PERCENT / 100) {
+        fprintf(stderr, "FAIL: mean cycle period drifted from %.1f to %.1f ms\n", reference.meanCycleMs, last.meanCycleMs);
+        failures++;
+    }
+    for (const soakWindow& w : windows) {
+        if (w.maxCycleMs > maxCycleMs) {
+            fprintf(stderr, "FAIL: a cycle period of %u ms in window %u\n", w.maxCycleMs, w.index);
+            failures++;
+            break;
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    uint32_t days = 14;
+    uint32_t intervalMs = 2000;
+    uint32_t commandPeriodMin = 30;
+    uint32_t windowH = 24;
+    unsigned int seed = 1;
+    const char* outputPath = nullptr;
+    int opt;
+
+    cn105_host_log_level = 1;
+    while ((opt = getopt(argc, argv, "d:i:c:W:s:o:vh")) != -1) {
+        switch (opt) {
+        case 'd': days = atol(optarg); break;
+        case 'i': intervalMs = atol(optarg); break;
+        case 'c': commandPeriodMin = atol(optarg); break;
+        case 'W': windowH = atol(optarg); break;
+        case 's': seed = atol(optarg); break;
+        case 'o': outputPath = optarg; break;
+        case 'v': cn105_host_log_level = 5; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc || days == 0 || intervalMs == 0 || windowH == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    FILE* output = outputPath != nullptr ? fopen(outputPath, "w") : stdout;
+    if (output == nullptr) {
+        perror(outputPath);
+        return 1;
+    }
+    srand(seed);
+
+    virtualClock clock;
+    uint32_t startMs = 0 - START_BEFORE_WRAP_MS;
+    clock.set(startMs);
+    cn105InstallClock(&clock);
+
+    cn105Emulator emulator;
+    emulator.init(*findEmulatedModel("generic"), startMs);
+    emulator.unit.roomTemperature = 18;
+    emulator.unit.power = POWER[1];
+    emulator.unit.mode = MODE[0];
+    emulator.unit.setpoint = 20;
+    emulator.plant.setOutdoorCycle(-2, 8);
+    emulator.plant.step(0, emulator.unit);
+
+    simulatedComponent component(emulator, clock);
+    component.updateIntervalMs = intervalMs;
+    component.options.fahrenheitSupport = true;
+    component.remoteTempTimeoutMs = REMOTE_TEMP_TIMEOUT_MS;
+    component.emulatedMutex = true;
+    component.setup();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    uint64_t endMs = (uint64_t)days * DAY_MS;
+    uint64_t windowMs = (uint64_t)windowH * 3600000;
+    uint64_t simulatedMs = 0;
+    uint64_t nextWindowMs = windowMs;
+    uint64_t nextCommandMs = commandPeriodMin > 0 ? (uint64_t)(rand() % (2 * commandPeriodMin) + 1) * 60000 : UINT64_MAX;
+    uint32_t lastRemoteMs = startMs - REMOTE_PERIOD_MS;
+    uint32_t lastRoutineDay = UINT32_MAX;
+    uint32_t lastRoutineStep = 0;
+    uint32_t nbCommands = 0;
+    soakCounters counters;
+    std::vector<soakWindow> windows;
+    windows.reserve(endMs / windowMs + 1);          // no allocation of the harness while measuring
+
+    fprintf(output, "window,live_bytes,peak_bytes,live_allocations,max_tx_queue,tx_dropped,max_scheduler,published,commands,cycles,"
+        "cycles_timed_out,reconnections,mean_cycle_ms,max_cycle_ms\n");
+    peakBytes = liveBytes.load();
+    while (simulatedMs < endMs) {
+        uint32_t previousMs = clock.nowMs;
+
+        if (elapsedMs(clock.nowMs, lastRemoteMs) >= REMOTE_PERIOD_MS) {
+            lastRemoteMs = clock.nowMs;
+            component.setRemoteTemperature(roundf(emulator.unit.roomTemperature * 2) / 2);
+        }
+
+        // daily routine: 21°C from 6:30, 19°C from 22:30, as a user or an automation would set them
+        uint32_t day = simulatedMs / DAY_MS;
+        uint32_t timeOfDayMs = simulatedMs % DAY_MS;
+        uint32_t routineStep = timeOfDayMs >= 81000000 ? 2 : (timeOfDayMs >= 23400000 ? 1 : 0);
+        bool routineDue = day != lastRoutineDay ? routineStep > 0 : routineStep != lastRoutineStep;
+        if (routineDue || simulatedMs >= nextCommandMs) {
+            heatpumpSettings wanted{};
+            wanted.resetSettings();
+            if (routineDue) {
+                wanted.temperature = routineStep == 1 ? 21 : 19;
+            } else {
+                wanted.temperature = 18 + (rand() % 11) * 0.5f;
+                if (rand() % 4 == 0) {
+                    wanted.fan = FAN_MAP[rand() % 6];
+                }
+                nextCommandMs = simulatedMs + (uint64_t)(rand() % (2 * commandPeriodMin) + 1) * 60000;
+            }
+            component.setWantedSettings(wanted, true);
+            nbCommands++;
+        }
+        lastRoutineDay = day;
+        lastRoutineStep = routineStep;
+
+        // the component runs until the next remote temperature, the commands follow at the minute
+        component.runUntil(lastRemoteMs + REMOTE_PERIOD_MS);
+        simulatedMs += elapsedMs(clock.nowMs, previousMs);
+
+        if (simulatedMs >= nextWindowMs) {
+            soakWindow w{};
+            w.index = windows.size();
+            w.liveBytes = liveBytes;
+            w.peakBytes = peakBytes;
+            w.liveAllocations = liveAllocations;
+            w.maxQueuedFrames = component.maxQueuedFrames;
+            w.nbTxDropped = component.transmitQueue.nbExpired + component.transmitQueue.nbEvicted - counters.nbTxDropped;
+            w.maxTimers = component.timers.maxSize;
+            w.nbPublished = component.nbPublished - counters.nbPublished;
+            w.nbCycles = component.nbCycles - counters.nbCycles;
+            w.nbCycleTimeouts = component.nbCycleTimeouts - counters.nbCycleTimeouts;
+            w.nbReconnections = component.nbLinkLost - counters.nbReconnections;
+            w.nbCommands = nbCommands - counters.nbCommands;
+            uint32_t nbCyclePeriods = component.nbCyclePeriods - counters.nbCyclePeriods;
+            w.meanCycleMs = nbCyclePeriods > 0 ? (double)(component.totalCyclePeriodMs - counters.totalCyclePeriodMs) / nbCyclePeriods : 0;
+            w.maxCycleMs = component.maxCyclePeriodMs;
+            windows.push_back(w);
+            writeWindow(output, w);
+            counters.take(component, nbCommands);
+            component.maxQueuedFrames = 0;              // high-water marks of each window
+            component.maxCyclePeriodMs = 0;
+            component.timers.maxSize = component.timers.size();
+            peakBytes = liveBytes.load();
+            nextWindowMs += windowMs;
+        }
+    }
+    if (output != stdout) {
+        fclose(output);
+    }
+
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    fprintf(stderr, "soaked %u days in %.1f s, %u cycles, %u frames sent, clock from %u to %u ms\n", days, wallS,
+        component.nbCycles, component.nbRequests, (unsigned int)startMs, (unsigned int)clock.nowMs);
+    int failures = checkGrowth(windows, intervalMs);
+    if (failures == 0) {
+        fprintf(stderr, "PASS: heap, tx queue, scheduler, publications and cycle periods stable over %zu windows\n", windows.size());
+    }
+    cn105InstallClock(nullptr);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,618 @@
+/**
+ * Concurrency stress of the wanted settings: control() and the select and switch callbacks called
+ * from several threads while the loop sends to the emulated unit, to be built with ThreadSanitizer
+ * (CN105_TSAN, see tools/README.md).
+ *
+ * On an ESP32 the API and web server tasks may run control() and the callbacks while loop() sends.
+ * CN105Climate itself needs ESPHome, so its paths are reproduced here on the same structures
+ * (wantedHeatpumpSettings, wantedHeatpumpRunStates); the frames are merged and the wanted values
+ * consumed by the unit of the component (wanted_settings.h):
+ *   control   controlDelegate(): setpoint, mode and fan, under the settings lock
+ *   select    the vane and wide vane selects (extraComponents.cpp), without the lock
+ *   switch    the air purifier, night mode and circulator switches, without the lock
+ *   loop      the debounce of checkPendingWantedSettings(), sendWantedSettingsDelegate() under
+ *             the lock, sendWantedRunStates() without it, and the info requests of the cycles,
+ *             whose responses update the settings the wanted ones are merged with
+ * Each thread owns its fields, so that the last value it wrote is the one the unit must end with.
+ *
+ * The lock is the one of the component, on either path:
+ *   mutex     std::mutex (USE_ESP32)
+ *   emulated  emulateMutex(): a volatile bool, retried 10 times with a 1.2 backoff, then forced
+ *             (the retry delays are scaled down from 100 ms to -r µs)
+ *
+ * A run is made of rounds: the writers hammer their fields for -d ms, stop, the loop drains, then
+ * the state of the unit is compared with the last values written. A field that differs is a lost
+ * update. It reports per path and thread the lock acquisitions, the contention (and the wait), the
+ * hold time, and the lost updates. -L takes the lock in the callbacks and around every access of
+ * the loop too, which is the fix the component needs: with it no update may be lost, and TSan
+ * reports no race on the mutex path.
+ *
+ * usage: cn105_stress [-n rounds] [-d round_ms] [-b debounce_ms] [-m mutex|emulated|both] [-r retry_us] [-L] [-s seed] [-v]
+ *
+ * Exit 1 when an update is lost or the assertion of logCheckWantedSettingsMutex() fails.
+ * Built by the CMakeLists.txt at the root of the repository when CN105_TSAN is on (target cn105_stress).
+*/
+#include "cn105_clock.h"
+#include "cn105_encoders.h"
+#include "cn105_emulator.h"
+#include "cn105_framer.h"
+#include "info_response.h"
+#include "wanted_settings.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern int cn105_host_log_level;
+
+static const int EMULATED_MUTEX_ATTEMPTS = 10;          // emulateMutex(): set_retry(name, 100, 10, ..., 1.2f)
+static const float EMULATED_MUTEX_BACKOFF = 1.2f;
+static const uint32_t LOOP_PERIOD_US = 1000;
+static const uint32_t CYCLE_PERIOD_MS = 20;             // info requests of the loop, to keep the line busy
+static const uint32_t DRAIN_TIMEOUT_MS = 5000;
+
+enum LockPath { PATH_MUTEX, PATH_EMULATED };
+enum Actor { ACTOR_CONTROL, ACTOR_SELECT, ACTOR_SWITCH, ACTOR_LOOP, ACTOR_COUNT };
+enum WrittenField { WRITTEN_SETPOINT, WRITTEN_MODE, WRITTEN_FAN, WRITTEN_VANE, WRITTEN_WIDE_VANE, WRITTEN_AIR_PURIFIER, WRITTEN_NIGHT_MODE, WRITTEN_CIRCULATOR, WRITTEN_COUNT };
+
+static const char* ACTOR_NAMES[ACTOR_COUNT] = { "control", "select", "switch", "loop" };
+static const char* WRITTEN_NAMES[WRITTEN_COUNT] = { "setpoint", "mode", "fan", "vane", "wide vane", "air purifier", "night mode", "circulator" };
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/**
+ * lock statistics of one thread, merged when the threads are joined
+*/
+struct lockStats {
+    std::vector<uint32_t> holdNs;
+    std::vector<uint32_t> waitNs;                       // contended acquisitions only
+    uint32_t nbAcquisitions = 0;
+    uint32_t nbForced = 0;                              // emulated path: taken although still locked
+
+    void merge(const lockStats& other) {
+        this->holdNs.insert(this->holdNs.end(), other.holdNs.begin(), other.holdNs.end());
+        this->waitNs.insert(this->waitNs.end(), other.waitNs.begin(), other.waitNs.end());
+        this->nbAcquisitions += other.nbAcquisitions;
+        this->nbForced += other.nbForced;
+    }
+
+    static double percentileUs(std::vector<uint32_t> values, double p) {
+        if (values.empty()) {
+            return 0;
+        }
+        std::sort(values.begin(), values.end());
+        size_t rank = (size_t)(p / 100 * values.size() + 0.999999);
+        return values[rank > 0 ? rank - 1 : 0] / 1000.0;
+    }
+};
+
+/**
+ * wantedSettingsMutex, on the path of USE_ESP32 or on the one of emulateMutex()
+*/
+struct settingsLock {
+    LockPath path = PATH_MUTEX;
+    uint32_t retryUs = 100;
+    std::mutex mutex;
+    volatile bool emulated = false;
+
+    template <typename F>
+    void run(lockStats& stats, F&& f) {
+        uint64_t startNs = nowNs();
+        bool contended = false;
+        if (this->path == PATH_MUTEX) {
+            if (!this->mutex.try_lock()) {
+                contended = true;
+                this->mutex.lock();
+            }
+        } else {
+            float delayUs = this->retryUs;
+            for (int attempt = 1; this->emulated; attempt++) {
+                contended = true;
+                if (attempt >= EMULATED_MUTEX_ATTEMPTS) {
+                    stats.nbForced++;           // "10 retry calls failed because mutex was locked, forcing unlock..."
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds((uint32_t)delayUs));
+                delayUs *= EMULATED_MUTEX_BACKOFF;
+            }
+            this->emulated = true;
+        }
+        uint64_t lockedNs = nowNs();
+        f();
+        uint64_t releasedNs = nowNs();
+        if (this->path == PATH_MUTEX) {
+            this->mutex.unlock();
+        } else {
+            this->emulated = false;
+        }
+
+        stats.nbAcquisitions++;
+        stats.holdNs.push_back((uint32_t)std::min<uint64_t>(releasedNs - lockedNs, UINT32_MAX));
+        if (contended) {
+            stats.waitNs.push_back((uint32_t)std::min<uint64_t>(lockedNs - startNs, UINT32_MAX));
+        }
+    }
+};
+
+/**
+ * the state shared by the threads, as in CN105Climate
+*/
+struct stressedComponent {
+    wantedHeatpumpSettings wantedSettings;
+    wantedHeatpumpRunStates wantedRunStates;
+    cn105State hpState;                                 // written by the loop only
+    settingsLock lock;
+    bool lockEverything = false;                        // -L
+    uint32_t debounceMs = 0;
+    std::atomic<uint32_t> nbAssertionFailures{ 0 };
+
+    stressedComponent() {
+        this->wantedSettings.resetSettings();
+        this->wantedSettings.lastChange = 0;
+        this->wantedRunStates.resetSettings();
+        this->wantedRunStates.lastChange = 0;
+        this->hpState.init();
+    }
+
+    // the select and switch callbacks take no lock in the component
+    template <typename F>
+    void runCallback(lockStats& stats, F&& f) {
+        if (this->lockEverything) {
+            this->lock.run(stats, f);
+        } else {
+            f();
+        }
+    }
+};
+
+/**
+ * last values written by the threads, published to the loop by the end of the round
+*/
+struct writtenValues {
+    float setpoint = -1;
+    const char* mode = nullptr;
+    const char* fan = nullptr;
+    const char* vane = nullptr;
+    const char* wideVane = nullptr;
+    int8_t airPurifier = -1;
+    int8_t nightMode = -1;
+    int8_t circulator = -1;
+};
+
+struct roundControl {
+    std::atomic<bool> writing{ false };
+    std::atomic<int> number{ 0 };                       // rounds whose writes are over
+    std::atomic<int> nbIdle{ 0 };                       // writers that saw the end of a round
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> checkRequested{ false };
+    std::atomic<bool> checkDone{ false };
+    writtenValues written;
+    uint32_t lostUpdates[WRITTEN_COUNT] = { 0 };
+    uint32_t nbUndrained = 0;
+};
+
+// false once the round is over, after telling it once per round (the written values are then published)
+static bool isWriting(roundControl& round, int& idleRound) {
+    if (round.writing) {
+        return true;
+    }
+    int number = round.number;
+    if (number != idleRound) {
+        idleRound = number;
+        round.nbIdle++;
+    }
+    std::this_thread::yield();
+    return false;
+}
+
+static void pauseWriter(uint32_t& seed, uint32_t debounceMs) {
+    // mostly closer than the debounce (coalesced), sometimes longer so that the loop sends meanwhile
+    uint32_t maxUs = std::max<uint32_t>(debounceMs * 2000, 200);
+    std::this_thread::sleep_for(std::chrono::microseconds(nextRandom(seed) % maxUs));
+}
+
+// CN105Climate::controlDelegate(): the call sets the setpoint, the mode (and the power) and the fan
+static void controlThread(stressedComponent& component, roundControl& round, lockStats& stats, uint32_t seed) {
+    writtenValues& written = round.written;
+    int idleRound = 0;
+    while (!round.stopping) {
+        if (!isWriting(round, idleRound)) {
+            continue;
+        }
+        float setpoint = 16.0f + (nextRandom(seed) % 29) * 0.5f;
+        const char* mode = MODE_MAP[nextRandom(seed) % 5];
+        const char* fan = FAN_MAP[nextRandom(seed) % 6];
+        component.lock.run(stats, [&]() {
+            if (component.wantedSettings.hasBeenSent) {
+                component.nbAssertionFailures++;        // logCheckWantedSettingsMutex()
+            }
+            component.wantedSettings.temperature = setpoint;
+            component.wantedSettings.mode = mode;
+            component.wantedSettings.power = POWER_MAP[1];
+            component.wantedSettings.fan = fan;
+            component.wantedSettings.hasChanged = true;
+            component.wantedSettings.hasBeenSent = false;
+            component.wantedSettings.lastChange = cn105Millis();
+            });
+        written.setpoint = setpoint;
+        written.mode = mode;
+        written.fan = fan;
+        pauseWriter(seed, component.debounceMs);
+    }
+}
+
+// vertical_vane_select_ and horizontal_vane_select_ callbacks
+static void selectThread(stressedComponent& component, roundControl& round, lockStats& stats, uint32_t seed) {
+    writtenValues& written = round.written;
+    int idleRound = 0;
+    while (!round.stopping) {
+        if (!isWriting(round, idleRound)) {
+            continue;
+        }
+        bool wide = nextRandom(seed) % 2 == 0;
+        const char* setting = wide ? WIDEVANE_MAP[nextRandom(seed) % 7] : VANE_MAP[nextRandom(seed) % 7];
+        component.runCallback(stats, [&]() {
+            if (wide) {
+                component.wantedSettings.wideVane = setting;
+            } else {
+                component.wantedSettings.vane = setting;
+            }
+            component.wantedSettings.hasChanged = true;
+            component.wantedSettings.hasBeenSent = false;
+            component.wantedSettings.lastChange = cn105Millis();
+            });
+        (wide ? written.wideVane : written.vane) = setting;
+        pauseWriter(seed, component.debounceMs);
+    }
+}
+
+// air_purifier_switch_, night_mode_switch_ and circulator_switch_ callbacks
+static void switchThread(stressedComponent& component, roundControl& round, lockStats& stats, uint32_t seed) {
+    writtenValues& written = round.written;
+    int idleRound = 0;
+    while (!round.stopping) {
+        if (!isWriting(round, idleRound)) {
+            continue;
+        }
+        int which = nextRandom(seed) % 3;
+        int8_t state = nextRandom(seed) % 2;
+        component.runCallback(stats, [&]() {
+            int8_t& target = which == 0 ? component.wantedRunStates.air_purifier
+                : which == 1 ? component.wantedRunStates.night_mode : component.wantedRunStates.circulator;
+            target = state;
+            component.wantedRunStates.hasChanged = true;
+            component.wantedRunStates.hasBeenSent = false;
+            component.wantedRunStates.lastChange = cn105Millis();
+            });
+        (which == 0 ? written.airPurifier : which == 1 ? written.nightMode : written.circulator) = state;
+        pauseWriter(seed, component.debounceMs);
+    }
+}
+
+// a value written but not the one of the unit; the written ones are entries of the *_MAP
+static bool isLost(const char* written, const char* valuesMap[], const uint8_t byteMap[], int len, uint8_t unitValue) {
+    return written != nullptr && strcmp(written, lookupByteMapValue(valuesMap, byteMap, len, unitValue, "", "")) != 0;
+}
+
+/**
+ * the loop of the component against the emulated unit, on the clock of the platform
+*/
+struct stressLoop {
+    stressedComponent& component;
+    roundControl& round;
+    lockStats& stats;
+    cn105Emulator emulator;
+    std::vector<uint8_t> output;
+    cn105Framer framer;
+    decodeOptions options;
+    uint32_t lastCycleMs = 0;
+    uint32_t nbSettingsSent = 0;
+    uint32_t nbRunStatesSent = 0;
+    bool draining = false;
+    uint32_t drainStartMs = 0;
+
+    stressLoop(stressedComponent& component, roundControl& round, lockStats& stats, const emulatedModel& model) :
+        component(component), round(round), stats(stats) {
+        this->framer.init();
+        this->emulator.init(model, cn105Millis());
+        this->emulator.receive(cn105Millis(), CONNECT, CONNECT_LEN);
+    }
+
+    // sendWantedSettingsDelegate()
+    void sendSettings() {
+        uint8_t packet[PACKET_LEN];
+        mergeWantedSettings(packet, this->component.wantedSettings, this->component.hpState.settings, true, false);
+        this->emulator.receive(cn105Millis(), packet, PACKET_LEN);
+        consumeWantedSettings(this->component.wantedSettings);
+        this->nbSettingsSent++;
+    }
+
+    // sendWantedRunStates()
+    void sendRunStates() {
+        uint8_t packet[PACKET_LEN];
+        mergeWantedRunStates(packet, this->component.wantedRunStates);
+        this->emulator.receive(cn105Millis(), packet, PACKET_LEN);
+        consumeWantedRunStates(this->component.wantedRunStates);
+        this->nbRunStatesSent++;
+    }
+
+    // the info responses of the unit, into the state model of the component
+    void processOutput() {
+        for (uint8_t data : this->output) {
+            if (!this->framer.push(data)) {
+                continue;
+            }
+            if (this->framer.isChecksumValid() && this->framer.getCommand() == 0x62
+                && this->framer.getDataLength() >= INFO_RESPONSE_DATA_LEN) {
+                bool known;
+                applyInfoResponse(this->framer.getData(), this->options, this->component.hpState, known);
+            }
+            this->framer.init();
+        }
+    }
+
+    template <typename F>
+    void withLock(bool locked, F&& f) {
+        if (locked || this->component.lockEverything) {
+            this->component.lock.run(this->stats, f);
+        } else {
+            f();
+        }
+    }
+
+    void step() {
+        uint32_t now = cn105Millis();
+        this->output.clear();
+        this->emulator.takeOutput(now, this->output);
+        this->processOutput();
+
+        // checkPendingWantedSettings(): hasChanged and the debounce are read without the lock
+        bool settingsDue = false;
+        this->withLock(false, [&]() {
+            settingsDue = this->component.wantedSettings.hasChanged
+                && elapsedMs(now, this->component.wantedSettings.lastChange) >= this->component.debounceMs;
+            });
+        if (settingsDue) {
+            this->withLock(true, [this]() { this->sendSettings(); });
+        }
+        this->withLock(false, [&]() {
+            if (this->component.wantedRunStates.hasChanged
+                && elapsedMs(now, this->component.wantedRunStates.lastChange) >= this->component.debounceMs) {
+                this->sendRunStates();
+            }
+            });
+
+        if (elapsedMs(now, this->lastCycleMs) >= CYCLE_PERIOD_MS) {
+            uint8_t packet[PACKET_LEN];
+            encodeInfoRequest(packet, INFOMODE[RQST_PKT_SETTINGS]);
+            this->emulator.receive(now, packet, PACKET_LEN);
+            this->lastCycleMs = now;
+        }
+
+        if (this->round.checkRequested && !this->round.checkDone) {
+            this->checkRound(now);
+        }
+    }
+
+    // the writers are stopped: once nothing is pending, the unit must hold their last values
+    void checkRound(uint32_t now) {
+        if (!this->draining) {
+            this->draining = true;
+            this->drainStartMs = now;
+        }
+        bool pending = false;
+        this->withLock(false, [&]() {
+            pending = this->component.wantedSettings.hasChanged || this->component.wantedRunStates.hasChanged;
+            });
+        if (pending && elapsedMs(now, this->drainStartMs) < DRAIN_TIMEOUT_MS) {
+            return;
+        }
+        if (pending) {
+            this->round.nbUndrained++;
+        }
+
+        const writtenValues& written = this->round.written;
+        const emulatedUnit& unit = this->emulator.unit;
+        uint32_t* lost = this->round.lostUpdates;
+        lost[WRITTEN_SETPOINT] += written.setpoint >= 0 && std::fabs(unit.setpoint - written.setpoint) > 0.01f;
+        lost[WRITTEN_MODE] += isLost(written.mode, MODE_MAP, MODE, 5, unit.mode);
+        lost[WRITTEN_FAN] += isLost(written.fan, FAN_MAP, FAN, 6, unit.fan);
+        lost[WRITTEN_VANE] += isLost(written.vane, VANE_MAP, VANE, 7, unit.vane);
+        lost[WRITTEN_WIDE_VANE] += isLost(written.wideVane, WIDEVANE_MAP, WIDEVANE, 8, unit.wideVane);
+        lost[WRITTEN_AIR_PURIFIER] += written.airPurifier >= 0 && unit.airPurifier != (written.airPurifier != 0);
+        lost[WRITTEN_NIGHT_MODE] += written.nightMode >= 0 && unit.nightMode != (written.nightMode != 0);
+        lost[WRITTEN_CIRCULATOR] += written.circulator >= 0 && unit.circulator != (written.circulator != 0);
+
+        this->draining = false;
+        this->round.checkDone = true;
+    }
+};
+
+struct pathResult {
+    lockStats stats[ACTOR_COUNT];
+    uint32_t lostUpdates[WRITTEN_COUNT] = { 0 };
+    uint32_t nbLost = 0;
+    uint32_t nbUndrained = 0;
+    uint32_t nbAssertionFailures = 0;
+    uint32_t nbSettingsSent = 0;
+    uint32_t nbRunStatesSent = 0;
+};
+
+static pathResult runPath(LockPath path, const emulatedModel& model, int nbRounds, uint32_t roundMs, uint32_t debounceMs,
+    uint32_t retryUs, bool lockEverything, uint32_t seed) {
+    stressedComponent component;
+    component.lock.path = path;
+    component.lock.retryUs = retryUs;
+    component.lockEverything = lockEverything;
+    component.debounceMs = debounceMs;
+    roundControl round;
+    lockStats stats[ACTOR_COUNT];
+    stressLoop loop(component, round, stats[ACTOR_LOOP], model);
+    std::atomic<bool> loopStopping{ false };
+
+    std::thread loopThread([&]() {
+        while (!loopStopping) {
+            loop.step();
+            std::this_thread::sleep_for(std::chrono::microseconds(LOOP_PERIOD_US));
+        }
+        });
+    std::vector<std::thread> writers;
+    writers.emplace_back(controlThread, std::ref(component), std::ref(round), std::ref(stats[ACTOR_CONTROL]), seed * 3 + 1);
+    writers.emplace_back(selectThread, std::ref(component), std::ref(round), std::ref(stats[ACTOR_SELECT]), seed * 5 + 2);
+    writers.emplace_back(switchThread, std::ref(component), std::ref(round), std::ref(stats[ACTOR_SWITCH]), seed * 7 + 3);
+
+    for (int i = 0; i < nbRounds; i++) {
+        round.checkDone = false;
+        round.writing = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(roundMs));
+        round.number = i + 1;
+        round.writing = false;
+        while (round.nbIdle < (i + 1) * (int)writers.size()) {
+            std::this_thread::yield();
+        }
+        round.checkRequested = true;
+        while (!round.checkDone) {
+            std::this_thread::sleep_for(std::chrono::microseconds(LOOP_PERIOD_US));
+        }
+        round.checkRequested = false;
+    }
+    round.stopping = true;
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    loopStopping = true;
+    loopThread.join();
+
+    pathResult result;
+    for (int actor = 0; actor < ACTOR_COUNT; actor++) {
+        result.stats[actor].merge(stats[actor]);
+    }
+    for (int field = 0; field < WRITTEN_COUNT; field++) {
+        result.lostUpdates[field] = round.lostUpdates[field];
+        result.nbLost += round.lostUpdates[field];
+    }
+    result.nbUndrained = round.nbUndrained;
+    result.nbAssertionFailures = component.nbAssertionFailures;
+    result.nbSettingsSent = loop.nbSettingsSent;
+    result.nbRunStatesSent = loop.nbRunStatesSent;
+    return result;
+}
+
+static const char* getPathName(LockPath path) {
+    return path == PATH_MUTEX ? "mutex" : "emulated";
+}
+
+static void printPath(LockPath path, const pathResult& result) {
+    for (int actor = 0; actor < ACTOR_COUNT; actor++) {
+        const lockStats& stats = result.stats[actor];
+        if (stats.nbAcquisitions == 0) {
+            continue;
+        }
+        printf("%-9s %-8s %8u %7.2f%% %9.1f   %7.2f %7.2f %8.1f   %6u\n", getPathName(path), ACTOR_NAMES[actor],
+            (unsigned int)stats.nbAcquisitions, 100.0 * stats.waitNs.size() / stats.nbAcquisitions,
+            lockStats::percentileUs(stats.waitNs, 99), lockStats::percentileUs(stats.holdNs, 50),
+            lockStats::percentileUs(stats.holdNs, 99), lockStats::percentileUs(stats.holdNs, 100), (unsigned int)stats.nbForced);
+    }
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [-n rounds] [-d round_ms] [-b debounce_ms] [-m mutex|emulated|both] [-r retry_us] [-L] [-s seed] [-v]\n"
+        "  -n  rounds, default 50\n"
+        "  -d  duration of the writes of a round, default 100 ms\n"
+        "  -b  debounce of the loop, default 2 ms (the component has 100 ms)\n"
+        "  -m  path of wantedSettingsMutex, default both\n"
+        "  -r  first retry delay of the emulated path, default 100 us (100 ms on the device)\n"
+        "  -L  the callbacks and the loop take the lock too\n"
+        "  -s  seed of the writers, default 1\n"
+        "  -v  logs of the emulator on stderr\n", name);
+}
+
+int main(int argc, char** argv) {
+    int nbRounds = 50;
+    uint32_t roundMs = 100;
+    uint32_t debounceMs = 2;
+    uint32_t retryUs = 100;
+    bool lockEverything = false;
+    uint32_t seed = 1;
+    std::vector<LockPath> paths = { PATH_MUTEX, PATH_EMULATED };
+    int opt;
+
+    cn105_host_log_level = 1;
+    while ((opt = getopt(argc, argv, "n:d:b:m:r:Ls:vh")) != -1) {
+        switch (opt) {
+        case 'n': nbRounds = atoi(optarg); break;
+        case 'd': roundMs = atol(optarg); break;
+        case 'b': debounceMs = atol(optarg); break;
+        case 'm':
+            if (strcmp(optarg, "mutex") == 0) {
+                paths = { PATH_MUTEX };
+            } else if (strcmp(optarg, "emulated") == 0) {
+                paths = { PATH_EMULATED };
+            } else if (strcmp(optarg, "both") != 0) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'r': retryUs = atol(optarg); break;
+        case 'L': lockEverything = true; break;
+        case 's': seed = atol(optarg); break;
+        case 'v': cn105_host_log_level = 5; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc || nbRounds <= 0 || roundMs == 0 || seed == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    const emulatedModel* model = findEmulatedModel("msz-ln");     // wide vane and HVAC options
+
+    int failures = 0;
+    printf("%-9s %-8s %8s %8s %9s   %-24s %6s\n", "path", "thread", "locks", "contend", "wait p99", "hold us p50/p99/max", "forced");
+    for (LockPath path : paths) {
+        pathResult result = runPath(path, *model, nbRounds, roundMs, debounceMs, retryUs, lockEverything, seed);
+        printPath(path, result);
+
+        fprintf(stderr, "%s: %d rounds, %u settings and %u run states packets, %u lost updates", getPathName(path), nbRounds,
+            (unsigned int)result.nbSettingsSent, (unsigned int)result.nbRunStatesSent, (unsigned int)result.nbLost);
+        for (int field = 0; field < WRITTEN_COUNT; field++) {
+            if (result.lostUpdates[field] > 0) {
+                fprintf(stderr, ", %s %u", WRITTEN_NAMES[field], (unsigned int)result.lostUpdates[field]);
+            }
+        }
+        fprintf(stderr, "\n");
+        if (result.nbAssertionFailures > 0) {
+            fprintf(stderr, "%s: control() saw the settings being sent %u times (logCheckWantedSettingsMutex)\n",
+                getPathName(path), (unsigned int)result.nbAssertionFailures);
+        }
+        if (result.nbUndrained > 0) {
+            fprintf(stderr, "%s: %u rounds still pending after %u ms\n", getPathName(path), (unsigned int)result.nbUndrained,
+                (unsigned int)DRAIN_TIMEOUT_MS);
+        }
+        failures += result.nbLost + result.nbAssertionFailures + result.nbUndrained;
+    }
+    if (failures > 0) {
+        fprintf(stderr, "FAIL: updates lost or lock violated\n");
+        return 1;
+    }
+    fprintf(stderr, "PASS: no update lost\n");
+    return 0;
+}
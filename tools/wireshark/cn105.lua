@@ -0,0 +1,234 @@
+-- Wireshark dissector for the Mitsubishi CN105 protocol.
+--
+-- Decodes the captures written by tools/cn105_trace2pcapng.py (link type USER0).
+-- Install: copy this file to the Wireshark personal plugins folder
+-- (Help > About Wireshark > Folders), or run `wireshark -X lua_script:cn105.lua capture.pcapng`.
+--
+-- Frame: FC <type> 01 30 <len> <data[len]> <checksum>, checksum = (0xFC - sum of all bytes) & 0xFF
+
+local cn105 = Proto("cn105", "Mitsubishi CN105")
+
+local PACKET_TYPES = {
+    [0x41] = "Set request",
+    [0x42] = "Get request",
+    [0x5a] = "Connect request",
+    [0x61] = "Set response (ACK)",
+    [0x62] = "Get response",
+    [0x7a] = "Connect response",
+}
+
+local INFO_CODES = {
+    [0x01] = "Settings",
+    [0x02] = "Settings",
+    [0x03] = "Room temperature",
+    [0x04] = "Unknown",
+    [0x05] = "Timers",
+    [0x06] = "Status",
+    [0x07] = "Remote temperature",
+    [0x08] = "Run states",
+    [0x09] = "Stage / sub modes",
+    [0x10] = "Auto mode state",
+    [0x1f] = "Functions set part 1",
+    [0x20] = "Functions part 1",
+    [0x21] = "Functions set part 2",
+    [0x22] = "Functions part 2",
+    [0x42] = "HVAC options",
+}
+
+local POWER = { [0x00] = "OFF", [0x01] = "ON" }
+local MODE = { [0x01] = "HEAT", [0x02] = "DRY", [0x03] = "COOL", [0x07] = "FAN", [0x08] = "AUTO" }
+local FAN = { [0x00] = "AUTO", [0x01] = "QUIET", [0x02] = "1", [0x03] = "2", [0x05] = "3", [0x06] = "4" }
+local VANE = { [0x00] = "AUTO", [0x01] = "1 (up)", [0x02] = "2", [0x03] = "3", [0x04] = "4", [0x05] = "5 (down)", [0x07] = "SWING" }
+local WIDEVANE = { [0x00] = "AIRFLOW CONTROL", [0x01] = "<<", [0x02] = "<", [0x03] = "|", [0x04] = ">", [0x05] = ">>", [0x08] = "<>", [0x0c] = "SWING" }
+local AIRFLOW_CONTROL = { [0x00] = "EVEN", [0x01] = "INDIRECT", [0x02] = "DIRECT" }
+local STAGE = { [0x00] = "IDLE", [0x01] = "LOW", [0x02] = "GENTLE", [0x03] = "MEDIUM", [0x04] = "MODERATE", [0x05] = "HIGH", [0x06] = "DIFFUSE" }
+local SUB_MODE = { [0x00] = "NORMAL", [0x02] = "DEFROST", [0x04] = "PREHEAT", [0x08] = "STANDBY" }
+local AUTO_SUB_MODE = { [0x00] = "AUTO_OFF", [0x01] = "AUTO_COOL", [0x02] = "AUTO_HEAT", [0x03] = "AUTO_LEADER" }
+
+local f = cn105.fields
+f.start = ProtoField.uint8("cn105.start", "Start", base.HEX)
+f.type = ProtoField.uint8("cn105.type", "Packet type", base.HEX, PACKET_TYPES)
+f.header = ProtoField.uint16("cn105.header", "Header constant", base.HEX)
+f.length = ProtoField.uint8("cn105.length", "Data length", base.DEC)
+f.data = ProtoField.bytes("cn105.data", "Data")
+f.code = ProtoField.uint8("cn105.code", "Info code", base.HEX, INFO_CODES)
+f.checksum = ProtoField.uint8("cn105.checksum", "Checksum", base.HEX)
+f.checksum_status = ProtoField.string("cn105.checksum.status", "Checksum status")
+
+f.flags1 = ProtoField.uint8("cn105.set.flags1", "Control flags 1", base.HEX)
+f.flags2 = ProtoField.uint8("cn105.set.flags2", "Control flags 2", base.HEX)
+f.power = ProtoField.uint8("cn105.power", "Power", base.HEX, POWER)
+f.isee = ProtoField.bool("cn105.isee", "i-See active")
+f.mode = ProtoField.uint8("cn105.mode", "Mode", base.HEX, MODE)
+f.temp_index = ProtoField.uint8("cn105.setpoint.index", "Setpoint (legacy, 31 - value)", base.DEC)
+f.setpoint = ProtoField.float("cn105.setpoint", "Setpoint (°C)")
+f.fan = ProtoField.uint8("cn105.fan", "Fan", base.HEX, FAN)
+f.vane = ProtoField.uint8("cn105.vane", "Vane", base.HEX, VANE)
+f.widevane = ProtoField.uint8("cn105.widevane", "Wide vane", base.HEX, WIDEVANE, 0x0F)
+f.widevane_adj = ProtoField.bool("cn105.widevane.adj", "Wide vane adjust", 8, nil, 0x80)
+f.airflow = ProtoField.uint8("cn105.airflow_control", "Airflow control", base.HEX, AIRFLOW_CONTROL)
+
+f.room_temp = ProtoField.float("cn105.room_temp", "Room temperature (°C)")
+f.outside_temp = ProtoField.float("cn105.outside_temp", "Outside temperature (°C)")
+f.runtime = ProtoField.uint32("cn105.runtime", "Operating time (min)", base.DEC)
+
+f.compressor = ProtoField.uint8("cn105.compressor_freq", "Compressor frequency (Hz)", base.DEC)
+f.operating = ProtoField.bool("cn105.operating", "Operating")
+f.input_power = ProtoField.uint16("cn105.input_power", "Input power (W)", base.DEC)
+f.energy = ProtoField.float("cn105.energy", "Energy (kWh)")
+
+f.stage = ProtoField.uint8("cn105.stage", "Stage", base.HEX, STAGE)
+f.sub_mode = ProtoField.uint8("cn105.sub_mode", "Sub mode", base.HEX, SUB_MODE)
+f.auto_sub_mode = ProtoField.uint8("cn105.auto_sub_mode", "Auto sub mode", base.HEX, AUTO_SUB_MODE)
+
+f.air_purifier = ProtoField.bool("cn105.air_purifier", "Air purifier")
+f.night_mode = ProtoField.bool("cn105.night_mode", "Night mode")
+f.circulator = ProtoField.bool("cn105.circulator", "Circulator")
+
+f.functions = ProtoField.bytes("cn105.functions", "Function codes")
+f.remote_temp = ProtoField.float("cn105.remote_temp", "Remote temperature (°C)")
+
+-- data[i] of the C++ decoders is at offset 5 + i in the frame
+local function d(buffer, i)
+    return buffer(5 + i, 1)
+end
+
+local function half_degrees(value)
+    return (value - 128) / 2
+end
+
+local function dissect_settings(buffer, tree)
+    local mode = d(buffer, 4):uint()
+    tree:add(f.power, d(buffer, 3))
+    tree:add(f.isee, d(buffer, 4), mode > 0x08)
+    tree:add(f.mode, d(buffer, 4), mode > 0x08 and mode - 0x08 or mode)
+    if d(buffer, 11):uint() ~= 0 then
+        tree:add(f.setpoint, d(buffer, 11), half_degrees(d(buffer, 11):uint()))
+    else
+        tree:add(f.temp_index, d(buffer, 5))
+    end
+    tree:add(f.fan, d(buffer, 6))
+    tree:add(f.vane, d(buffer, 7))
+    tree:add(f.widevane, d(buffer, 10))
+    tree:add(f.widevane_adj, d(buffer, 10))
+    tree:add(f.airflow, d(buffer, 14))
+end
+
+local function dissect_set_settings(buffer, tree)
+    tree:add(f.flags1, d(buffer, 1))
+    tree:add(f.flags2, d(buffer, 2))
+    local flags1 = d(buffer, 1):uint()
+    if bit.band(flags1, 0x01) ~= 0 then tree:add(f.power, d(buffer, 3)) end
+    if bit.band(flags1, 0x02) ~= 0 then tree:add(f.mode, d(buffer, 4)) end
+    if bit.band(flags1, 0x04) ~= 0 then
+        if d(buffer, 14):uint() ~= 0 then
+            tree:add(f.setpoint, d(buffer, 14), half_degrees(d(buffer, 14):uint()))
+        else
+            tree:add(f.temp_index, d(buffer, 5))
+        end
+    end
+    if bit.band(flags1, 0x08) ~= 0 then tree:add(f.fan, d(buffer, 6)) end
+    if bit.band(flags1, 0x10) ~= 0 then tree:add(f.vane, d(buffer, 7)) end
+    if bit.band(d(buffer, 2):uint(), 0x01) ~= 0 then
+        tree:add(f.widevane, d(buffer, 13))
+        tree:add(f.widevane_adj, d(buffer, 13))
+    end
+end
+
+local function dissect_room_temp(buffer, tree)
+    local outside = d(buffer, 5):uint()
+    if outside > 1 then
+        tree:add(f.outside_temp, d(buffer, 5), half_degrees(outside))
+    end
+    if d(buffer, 6):uint() ~= 0 then
+        tree:add(f.room_temp, d(buffer, 6), half_degrees(d(buffer, 6):uint()))
+    else
+        tree:add(f.room_temp, d(buffer, 3), 10 + d(buffer, 3):uint())
+    end
+    tree:add(f.runtime, buffer(5 + 11, 3))
+end
+
+local function dissect_status(buffer, tree)
+    tree:add(f.compressor, d(buffer, 3))
+    tree:add(f.operating, d(buffer, 4), d(buffer, 4):uint() ~= 0)
+    tree:add(f.input_power, buffer(5 + 5, 2))
+    tree:add(f.energy, buffer(5 + 7, 2), buffer(5 + 7, 2):uint() / 10)
+end
+
+local function dissect_stage(buffer, tree)
+    tree:add(f.sub_mode, d(buffer, 3))
+    tree:add(f.stage, d(buffer, 4))
+    tree:add(f.auto_sub_mode, d(buffer, 5))
+end
+
+local function dissect_options(buffer, tree)
+    tree:add(f.air_purifier, d(buffer, 1), d(buffer, 1):uint() ~= 0)
+    tree:add(f.night_mode, d(buffer, 2), d(buffer, 2):uint() ~= 0)
+    tree:add(f.circulator, d(buffer, 3), d(buffer, 3):uint() ~= 0)
+end
+
+local function dissect_remote_temp(buffer, tree)
+    if d(buffer, 1):uint() == 0 then
+        tree:add(f.remote_temp, d(buffer, 3), 0):append_text(" (internal sensor)")
+    else
+        tree:add(f.remote_temp, d(buffer, 3), half_degrees(d(buffer, 3):uint()))
+    end
+end
+
+function cn105.dissector(buffer, pinfo, tree)
+    if buffer:len() < 6 or buffer(0, 1):uint() ~= 0xfc then
+        return 0
+    end
+    pinfo.cols.protocol = "CN105"
+
+    local ptype = buffer(1, 1):uint()
+    local length = buffer(4, 1):uint()
+    local subtree = tree:add(cn105, buffer(), "Mitsubishi CN105")
+    subtree:add(f.start, buffer(0, 1))
+    subtree:add(f.type, buffer(1, 1))
+    subtree:add(f.header, buffer(2, 2))
+    subtree:add(f.length, buffer(4, 1))
+
+    local info = PACKET_TYPES[ptype] or string.format("Unknown type 0x%02X", ptype)
+    if buffer:len() < 6 + length then
+        pinfo.cols.info = info .. " [truncated]"
+        return buffer:len()
+    end
+
+    local sum = 0
+    for i = 0, 4 + length do
+        sum = sum + buffer(i, 1):uint()
+    end
+    local expected = bit.band(0xfc - sum, 0xff)
+    local checksum = buffer(5 + length, 1)
+    subtree:add(f.checksum, checksum)
+    subtree:add(f.checksum_status, checksum, checksum:uint() == expected and "Good" or string.format("Bad (expected 0x%02X)", expected))
+
+    if length > 0 then
+        local data = subtree:add(f.data, buffer(5, length))
+        local code = d(buffer, 0):uint()
+        data:add(f.code, d(buffer, 0))
+        info = info .. ": " .. (INFO_CODES[code] or string.format("0x%02X", code))
+
+        if ptype == 0x62 and length >= 16 then
+            if code == 0x02 then dissect_settings(buffer, data)
+            elseif code == 0x03 then dissect_room_temp(buffer, data)
+            elseif code == 0x06 then dissect_status(buffer, data)
+            elseif code == 0x09 then dissect_stage(buffer, data)
+            elseif code == 0x42 then dissect_options(buffer, data)
+            elseif code == 0x20 or code == 0x22 then data:add(f.functions, buffer(6, 15))
+            end
+        elseif ptype == 0x41 and length >= 16 then
+            if code == 0x01 then dissect_set_settings(buffer, data)
+            elseif code == 0x07 then dissect_remote_temp(buffer, data)
+            elseif code == 0x08 then data:add(f.airflow, d(buffer, 6))
+            elseif code == 0x1f or code == 0x21 then data:add(f.functions, buffer(6, 15))
+            end
+        end
+    end
+
+    pinfo.cols.info = info
+    return 6 + length
+end
+
+DissectorTable.get("wtap_encap"):add(wtap.USER0, cn105)